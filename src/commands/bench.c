@@ -0,0 +1,509 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#ifndef _WIN32
+  #include <fcntl.h>
+  #include <unistd.h>
+  #include <sys/resource.h>
+  #include <sys/time.h>
+  #include <sys/types.h>
+  #include <sys/wait.h>
+#endif
+
+#include "../include/commands.h"
+
+// `sbor bench`: run the release binary repeatedly and report timing
+// statistics. Every run is stored in .sbor/bench/latest.json (and under
+// --save NAME); --baseline NAME compares against a stored run with a
+// Mann-Whitney U test and fails when the median regresses by more than the
+// threshold.
+//
+//   "bench": { "runs": 20, "warmup": 2, "threshold": 5, "args": ["input.txt"] }
+
+#define BENCH_DIR ".sbor/bench"
+#define SIGNIFICANCE 0.05
+
+struct bench_sample {
+  double wall;     // Seconds
+  double user;
+  double sys;
+  long max_rss_kb;
+};
+
+struct bench_summary {
+  double min, median, mean, stddev, p95, p99;
+  double user_mean, sys_mean;
+  long max_rss_kb;
+};
+
+static void print_bench_usage(void) {
+  fprintf(stderr, "   Usage: sbor bench [-n RUNS] [--warmup N] [--save NAME] [--baseline NAME]\n");
+  fprintf(stderr, "                     [--threshold PERCENT] [--profile NAME] [-- args]\n");
+}
+
+static int compare_doubles(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+// Nearest-rank percentile of sorted values
+static double percentile(const double *sorted, int count, double p) {
+  int rank = (int)ceil(p / 100.0 * count);
+  if (rank < 1) rank = 1;
+  if (rank > count) rank = count;
+  return sorted[rank - 1];
+}
+
+static double median_of(const double *sorted, int count) {
+  if (count % 2) {
+    return sorted[count / 2];
+  }
+  return (sorted[count / 2 - 1] + sorted[count / 2]) / 2.0;
+}
+
+static void summarize(const struct bench_sample *samples, int count, struct bench_summary *summary) {
+  double *wall = malloc(count * sizeof(double));
+  double sum = 0, user = 0, sys = 0;
+  summary->max_rss_kb = 0;
+  for (int i = 0; i < count; i++) {
+    wall[i] = samples[i].wall;
+    sum += samples[i].wall;
+    user += samples[i].user;
+    sys += samples[i].sys;
+    if (samples[i].max_rss_kb > summary->max_rss_kb) {
+      summary->max_rss_kb = samples[i].max_rss_kb;
+    }
+  }
+  qsort(wall, count, sizeof(double), compare_doubles);
+
+  summary->mean = sum / count;
+  double variance = 0;
+  for (int i = 0; i < count; i++) {
+    variance += (wall[i] - summary->mean) * (wall[i] - summary->mean);
+  }
+  summary->stddev = count > 1 ? sqrt(variance / (count - 1)) : 0.0;
+  summary->min = wall[0];
+  summary->median = median_of(wall, count);
+  summary->p95 = percentile(wall, count, 95);
+  summary->p99 = percentile(wall, count, 99);
+  summary->user_mean = user / count;
+  summary->sys_mean = sys / count;
+  free(wall);
+}
+
+// Human-readable duration with a fixed width
+static const char* format_duration(double seconds, char *buffer, size_t size) {
+  if (seconds < 1e-3) {
+    snprintf(buffer, size, "%8.1f µs", seconds * 1e6);
+  } else if (seconds < 1.0) {
+    snprintf(buffer, size, "%8.3f ms", seconds * 1e3);
+  } else {
+    snprintf(buffer, size, "%8.3f s ", seconds);
+  }
+  return buffer;
+}
+
+#ifndef _WIN32
+
+static double timeval_seconds(const struct timeval *tv) {
+  return tv->tv_sec + tv->tv_usec / 1e6;
+}
+
+// Run the binary once with its output discarded, measuring it with wait4
+static int run_once(char *const argv[], struct bench_sample *sample) {
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  pid_t pid = fork();
+  if (pid < 0) {
+    return -1;
+  }
+  if (pid == 0) {
+    int null_fd = open("/dev/null", O_RDWR);
+    if (null_fd >= 0) {
+      dup2(null_fd, STDIN_FILENO);
+      dup2(null_fd, STDOUT_FILENO);
+      dup2(null_fd, STDERR_FILENO);
+    }
+    execv(argv[0], argv);
+    _exit(127);
+  }
+
+  int status;
+  struct rusage usage;
+  if (wait4(pid, &status, 0, &usage) < 0) {
+    return -1;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  sample->wall = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  sample->user = timeval_seconds(&usage.ru_utime);
+  sample->sys = timeval_seconds(&usage.ru_stime);
+#ifdef __APPLE__
+  sample->max_rss_kb = usage.ru_maxrss / 1024;  // Bytes on macOS
+#else
+  sample->max_rss_kb = usage.ru_maxrss;
+#endif
+  return process_exit_code(status);
+}
+
+#endif
+
+static int save_results(const char *path, const char *exe_path, const struct arg_list *args,
+                        const struct bench_sample *samples, int runs, int warmup,
+                        const struct bench_summary *summary) {
+  FILE *file = fopen(path, "w");
+  if (!file) {
+    return -1;
+  }
+
+  char timestamp[64];
+  time_t now = time(NULL);
+  strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+
+  fprintf(file, "{\n");
+  fprintf(file, "    \"binary\": \"%s\",\n", exe_path);
+  fprintf(file, "    \"args\": [");
+  for (int i = 0; i < args->count; i++) {
+    fprintf(file, "%s\"", i ? ", " : "");
+    for (const char *c = args->items[i]; *c; c++) {
+      if (*c == '"' || *c == '\\') fputc('\\', file);
+      fputc(*c, file);
+    }
+    fprintf(file, "\"");
+  }
+  fprintf(file, "],\n");
+  fprintf(file, "    \"timestamp\": \"%s\",\n", timestamp);
+  fprintf(file, "    \"runs\": %d,\n", runs);
+  fprintf(file, "    \"warmup\": %d,\n", warmup);
+  fprintf(file, "    \"wall_seconds\": { \"min\": %.9f, \"median\": %.9f, \"mean\": %.9f, "
+                "\"stddev\": %.9f, \"p95\": %.9f, \"p99\": %.9f },\n",
+          summary->min, summary->median, summary->mean, summary->stddev, summary->p95, summary->p99);
+  fprintf(file, "    \"user_seconds_mean\": %.9f,\n", summary->user_mean);
+  fprintf(file, "    \"sys_seconds_mean\": %.9f,\n", summary->sys_mean);
+  fprintf(file, "    \"max_rss_kb\": %ld,\n", summary->max_rss_kb);
+  fprintf(file, "    \"wall_samples\": [");
+  for (int i = 0; i < runs; i++) {
+    fprintf(file, "%s%.9f", i ? ", " : "", samples[i].wall);
+  }
+  fprintf(file, "]\n}\n");
+
+  return fclose(file) == 0 ? 0 : -1;
+}
+
+// Read the "wall_samples" array of a stored result. Returns the sample count
+// (and a malloc'd array in *values), or -1 if the file is missing or invalid.
+static int load_wall_samples(const char *path, double **values) {
+  char *content = read_file_contents(path);
+  if (!content) {
+    return -1;
+  }
+  char *list = strstr(content, "\"wall_samples\"");
+  list = list ? strchr(list, '[') : NULL;
+  if (!list) {
+    free(content);
+    return -1;
+  }
+
+  int count = 0, capacity = 64;
+  *values = malloc(capacity * sizeof(double));
+  char *cursor = list + 1;
+  while (1) {
+    while (*cursor == ' ' || *cursor == ',' || *cursor == '\n') cursor++;
+    if (*cursor == ']' || *cursor == '\0') {
+      break;
+    }
+    char *end;
+    double value = strtod(cursor, &end);
+    if (end == cursor) {
+      break;
+    }
+    if (count == capacity) {
+      capacity *= 2;
+      *values = realloc(*values, capacity * sizeof(double));
+    }
+    (*values)[count++] = value;
+    cursor = end;
+  }
+  free(content);
+  return count;
+}
+
+struct ranked {
+  double value;
+  int group;
+};
+
+static int compare_ranked(const void *a, const void *b) {
+  return compare_doubles(&((const struct ranked *)a)->value, &((const struct ranked *)b)->value);
+}
+
+// Two-sided Mann-Whitney U test (normal approximation with tie and
+// continuity correction). Makes no normality assumption, which suits run
+// times with their long right tail. Returns the p-value.
+static double mann_whitney_p(const double *a, int na, const double *b, int nb) {
+  int n = na + nb;
+  struct ranked *all = malloc(n * sizeof(struct ranked));
+  for (int i = 0; i < na; i++) { all[i].value = a[i]; all[i].group = 0; }
+  for (int i = 0; i < nb; i++) { all[na + i].value = b[i]; all[na + i].group = 1; }
+  qsort(all, n, sizeof(struct ranked), compare_ranked);
+
+  double rank_sum_a = 0, ties = 0;
+  for (int i = 0; i < n;) {
+    int j = i;
+    while (j < n && all[j].value == all[i].value) j++;
+    double rank = (i + 1 + j) / 2.0;  // Average rank of the tied run
+    for (int k = i; k < j; k++) {
+      if (all[k].group == 0) rank_sum_a += rank;
+    }
+    double t = j - i;
+    ties += t * t * t - t;
+    i = j;
+  }
+  free(all);
+
+  double u = rank_sum_a - na * (na + 1) / 2.0;
+  double mean = na * (double)nb / 2.0;
+  double variance = na * (double)nb / 12.0 * ((n + 1) - ties / ((double)n * (n - 1)));
+  if (variance <= 0) {
+    return 1.0;
+  }
+  double difference = fabs(u - mean) - 0.5;
+  if (difference < 0) difference = 0;
+  return erfc(difference / sqrt(variance) / sqrt(2.0));
+}
+
+static int valid_result_name(const char *name) {
+  return *name && strchr(name, '/') == NULL && strchr(name, '\\') == NULL && name[0] != '.';
+}
+
+// Compare with a stored baseline. Returns 1 on a significant regression.
+static int compare_with_baseline(const char *name, const struct bench_sample *samples, int runs,
+                                 const struct bench_summary *summary, double threshold) {
+  char path[512];
+  snprintf(path, sizeof(path), "%s/%s.json", BENCH_DIR, name);
+  double *baseline = NULL;
+  int count = load_wall_samples(path, &baseline);
+  if (count <= 0) {
+    fprintf(stderr, "❌ Error: No stored results for baseline '%s' (%s)\n", name, path);
+    fprintf(stderr, "   💡 Record one with: sbor bench --save %s\n", name);
+    free(baseline);
+    return -1;
+  }
+
+  double *current = malloc(runs * sizeof(double));
+  for (int i = 0; i < runs; i++) {
+    current[i] = samples[i].wall;
+  }
+  double p = mann_whitney_p(current, runs, baseline, count);
+  qsort(baseline, count, sizeof(double), compare_doubles);
+  double base_median = median_of(baseline, count);
+  double change = base_median > 0 ? 100.0 * (summary->median - base_median) / base_median : 0.0;
+
+  char before[32], after[32];
+  printf("\n📊 Compared with baseline '%s' (%d runs):\n", name, count);
+  printf("   median  %s → %s  (%+.1f%%, p = %.4f)\n",
+         format_duration(base_median, before, sizeof(before)),
+         format_duration(summary->median, after, sizeof(after)), change, p);
+
+  int regression = 0;
+  if (p >= SIGNIFICANCE) {
+    printf("   ✅ No significant difference (threshold %.1f%%)\n", threshold);
+  } else if (change > threshold) {
+    printf("   ❌ Regression: %+.1f%% exceeds the %.1f%% threshold\n", change, threshold);
+    regression = 1;
+  } else if (change < 0) {
+    printf("   🚀 Improvement: %.1f%% faster\n", -change);
+  } else {
+    printf("   ✅ Slower by %.1f%%, within the %.1f%% threshold\n", change, threshold);
+  }
+  if (count < 5 || runs < 5) {
+    printf("   ⚠️  Fewer than 5 runs on one side, the test has little power.\n");
+  }
+
+  free(current);
+  free(baseline);
+  return regression;
+}
+
+static int config_int(const char *key, int fallback) {
+  char *value = get_config_value("bench", key);
+  int result = value ? atoi(value) : fallback;
+  free(value);
+  return result;
+}
+
+int cmd_bench(int argc, char *argv[]) {
+#ifdef _WIN32
+  (void)argc;
+  (void)argv;
+  fprintf(stderr, "❌ Error: 'sbor bench' is not supported on Windows yet.\n");
+  return 1;
+#else
+  struct build_options build_opts;
+  init_build_options(&build_opts);
+  build_opts.profile = "release";
+
+  int runs = config_int("runs", 10);
+  int warmup = config_int("warmup", 1);
+  char *threshold_value = get_config_value("bench", "threshold");
+  double threshold = threshold_value ? atof(threshold_value) : 5.0;
+  free(threshold_value);
+  const char *save_name = NULL;
+  const char *baseline_name = NULL;
+
+  struct arg_list args;
+  arg_list_init(&args);
+  int passthrough = 0;
+
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    int has_value = i + 1 < argc;
+    if (passthrough) {
+      arg_list_push(&args, arg);
+    } else if (strcmp(arg, "--") == 0) {
+      passthrough = 1;
+    } else if ((strcmp(arg, "-n") == 0 || strcmp(arg, "--runs") == 0) && has_value) {
+      runs = atoi(argv[++i]);
+    } else if (strcmp(arg, "--warmup") == 0 && has_value) {
+      warmup = atoi(argv[++i]);
+    } else if (strcmp(arg, "--save") == 0 && has_value) {
+      save_name = argv[++i];
+    } else if (strcmp(arg, "--baseline") == 0 && has_value) {
+      baseline_name = argv[++i];
+    } else if (strcmp(arg, "--threshold") == 0 && has_value) {
+      threshold = atof(argv[++i]);
+    } else {
+      int parsed = parse_build_option(argc, argv, &i, &build_opts);
+      if (parsed < 0) {
+        arg_list_free(&args);
+        return 1;
+      }
+      if (parsed == 0) {
+        fprintf(stderr, "❌ Error: Unknown option '%s'\n", arg);
+        print_bench_usage();
+        arg_list_free(&args);
+        return 1;
+      }
+    }
+  }
+
+  if (runs < 1 || warmup < 0 || threshold < 0) {
+    fprintf(stderr, "❌ Error: runs must be at least 1, warmup and threshold not negative.\n");
+    arg_list_free(&args);
+    return 1;
+  }
+  if ((save_name && !valid_result_name(save_name)) ||
+      (baseline_name && !valid_result_name(baseline_name))) {
+    fprintf(stderr, "❌ Error: Result names may not contain '/' or start with '.'\n");
+    arg_list_free(&args);
+    return 1;
+  }
+  if (!passthrough) {
+    get_config_list("bench", "args", &args);
+  }
+
+  int result = build_project(&build_opts);
+  if (result != 0) {
+    fprintf(stderr, "❌ Build failed! Cannot run the benchmark.\n");
+    arg_list_free(&args);
+    return result;
+  }
+
+  struct project_config config;
+  struct build_profile profile;
+  if (load_project_config(&config) != 0) {
+    arg_list_free(&args);
+    return 1;
+  }
+  if (load_build_profile(&build_opts, &config, &profile) != 0) {
+    free_project_config(&config);
+    arg_list_free(&args);
+    return 1;
+  }
+  char *exe_path = find_executable(profile.directory, config.name);
+  free_build_profile(&profile);
+  free_project_config(&config);
+  if (!exe_path) {
+    fprintf(stderr, "❌ Error: Could not find the executable to benchmark.\n");
+    arg_list_free(&args);
+    return 1;
+  }
+
+  struct arg_list command;
+  arg_list_init(&command);
+  arg_list_push(&command, exe_path);
+  for (int i = 0; i < args.count; i++) {
+    arg_list_push(&command, args.items[i]);
+  }
+
+  printf("\n⏱️  Benchmarking %s", exe_path);
+  for (int i = 0; i < args.count; i++) {
+    printf(" %s", args.items[i]);
+  }
+  printf("\n   %d warmup run%s, %d measured run%s (program output discarded)\n",
+         warmup, warmup == 1 ? "" : "s", runs, runs == 1 ? "" : "s");
+  fflush(stdout);
+
+  struct bench_sample *samples = calloc(runs, sizeof(struct bench_sample));
+  for (int i = 0; i < warmup + runs && result == 0; i++) {
+    struct bench_sample sample;
+    int exit_code = run_once(command.items, &sample);
+    if (exit_code != 0) {
+      fprintf(stderr, "❌ Error: %s exited with code %d, benchmark aborted.\n", exe_path, exit_code);
+      result = 1;
+    } else if (i >= warmup) {
+      samples[i - warmup] = sample;
+    }
+  }
+
+  if (result == 0) {
+    struct bench_summary summary;
+    summarize(samples, runs, &summary);
+
+    char a[32], b[32], c[32];
+    printf("\n📈 Wall time:\n");
+    printf("   min     %s    median  %s    mean    %s ± %.1f%%\n",
+           format_duration(summary.min, a, sizeof(a)), format_duration(summary.median, b, sizeof(b)),
+           format_duration(summary.mean, c, sizeof(c)),
+           summary.mean > 0 ? 100.0 * summary.stddev / summary.mean : 0.0);
+    printf("   p95     %s    p99     %s\n",
+           format_duration(summary.p95, a, sizeof(a)), format_duration(summary.p99, b, sizeof(b)));
+    printf("   user    %s    sys     %s    (mean per run)\n",
+           format_duration(summary.user_mean, a, sizeof(a)), format_duration(summary.sys_mean, b, sizeof(b)));
+    printf("   peak RSS %.1f MiB\n", summary.max_rss_kb / 1024.0);
+
+    make_directories(BENCH_DIR);
+    char path[512];
+    snprintf(path, sizeof(path), "%s/latest.json", BENCH_DIR);
+    if (save_results(path, exe_path, &args, samples, runs, warmup, &summary) != 0) {
+      fprintf(stderr, "⚠️  Warning: Failed to write %s\n", path);
+    }
+    if (save_name) {
+      snprintf(path, sizeof(path), "%s/%s.json", BENCH_DIR, save_name);
+      if (save_results(path, exe_path, &args, samples, runs, warmup, &summary) == 0) {
+        printf("\n💾 Saved as '%s' (%s)\n", save_name, path);
+      } else {
+        fprintf(stderr, "❌ Error: Failed to write %s\n", path);
+        result = 1;
+      }
+    }
+
+    if (baseline_name) {
+      int compared = compare_with_baseline(baseline_name, samples, runs, &summary, threshold);
+      if (compared != 0) {
+        result = 1;
+      }
+    }
+  }
+
+  free(samples);
+  free(exe_path);
+  arg_list_free(&command);
+  arg_list_free(&args);
+  return result;
+#endif
+}
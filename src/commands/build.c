@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
 #include <unistd.h>
 #include <sys/stat.h>
 
@@ -16,102 +17,756 @@
 #include "../include/commands.h"
 
 
-int cmd_build(int argc, char *argv[]) {
-  (void)argc;
-  (void)argv;
+void init_build_options(struct build_options *opts) {
+  opts->jobs = 0;
+  opts->reconfigure = 0;
+  opts->unity = 0;
+  opts->profile = NULL;
+  opts->pgo = 0;
+  opts->pgo_phase = PGO_NONE;
+  opts->bolt = 0;
+  opts->emit_relocs = 0;
+  opts->benches = 0;
+  opts->timings = 0;
+  opts->json_messages = 0;
+}
 
-  printf("🔨 Building project...\n\n");
+// Parse a job count, returning -1 if it is not a positive integer
+static int parse_job_count(const char *value) {
+  char *end;
+  long jobs = strtol(value, &end, 10);
+  if (*value == '\0' || *end != '\0' || jobs < 1 || jobs > 4096) {
+    return -1;
+  }
+  return (int)jobs;
+}
 
-  // Check if we are in a valid sbor project
-  if (!is_valid_sbor_project()) {
-    fprintf(stderr, "❌ Error: Not in a valid sbor project directory.\n");
-    fprintf(stderr, "   Make sure you're in a directory created with 'sbor init' that contains:\n");
-    fprintf(stderr, "   - CMakeLists.txt\n");
-    fprintf(stderr, "   - sbor.conf\n");
-    fprintf(stderr, "   - src/ directory\n\n");
-    fprintf(stderr, "   Run 'sbor init <project_name>' to create a new project.\n");
+// Try to consume a build option at argv[*index].
+// Returns 1 if the option was consumed, 0 if it is not a build option
+// and -1 if it is a build option with an invalid value.
+int parse_build_option(int argc, char *argv[], int *index, struct build_options *opts) {
+  const char *arg = argv[*index];
+  const char *value = NULL;
+
+  if (strcmp(arg, "--reconfigure") == 0) {
+    opts->reconfigure = 1;
     return 1;
   }
 
-  // Create build directory if it doesn't exist
-  if (!file_exists("build")) {
-    printf("📁 Creating build directory...\n");
-    if (mkdir("build", 0755) != 0) {
-      fprintf(stderr, "❌ Error: Failed to create build directory\n");
-      return 1;
+  if (strcmp(arg, "--unity") == 0) {
+    opts->unity = 1;
+    return 1;
+  }
+
+  if (strcmp(arg, "--timings") == 0) {
+    opts->timings = 1;
+    return 1;
+  }
+
+  if (strcmp(arg, "--pgo") == 0) {
+    opts->pgo = 1;
+    if (!opts->profile) {
+      opts->profile = "release";  // PGO on an -O0 build would be pointless
     }
-    printf("   ✅ Build directory created successfully.\n\n");
-  } else {
-    printf("📁 Using existing build directory...\n\n");
+    return 1;
   }
 
-  // Save current directory
-  char current_dir[1024];
-  if (getcwd(current_dir, sizeof(current_dir)) == NULL) {
-    fprintf(stderr, "❌ Error: Failed to get current directory.\n");
+  if (strcmp(arg, "--bolt") == 0) {
+    opts->bolt = 1;
+    if (!opts->profile) {
+      opts->profile = "release";
+    }
     return 1;
   }
 
-  // Change build directory
-  if (chdir("build") != 0) {
-    fprintf(stderr, "❌ Error: Failed to change to build directory.\n");
+  if (strcmp(arg, "--message-format") == 0 || strncmp(arg, "--message-format=", 17) == 0) {
+    if (arg[16] == '=') {
+      value = arg + 17;
+    } else if (*index + 1 < argc) {
+      value = argv[++(*index)];
+    }
+    if (!value || (strcmp(value, "json") != 0 && strcmp(value, "human") != 0)) {
+      fprintf(stderr, "❌ Error: --message-format must be 'json' or 'human'\n");
+      return -1;
+    }
+    opts->json_messages = strcmp(value, "json") == 0;
+    return 1;
+  }
+
+  if (strcmp(arg, "--release") == 0) {
+    opts->profile = "release";
     return 1;
   }
 
-  printf("🔧 Configuring project with CMake...\n");
+  if (strcmp(arg, "--profile") == 0) {
+    if (*index + 1 >= argc) {
+      fprintf(stderr, "❌ Error: --profile requires a profile name\n");
+      return -1;
+    }
+    opts->profile = argv[++(*index)];
+    return 1;
+  }
 
-  // Run cmake command
-  int cmake_result = execute_command("cmake ../");
-  if (cmake_result != 0) {
-    fprintf(stderr, "❌ Error: CMake configuration failed (exit code: %d).\n", cmake_result);
-    fprintf(stderr, "   Please check your CMakeLists.txt file and ensure CMake is installed.\n");
-    chdir(current_dir);  // Return to original directory
+  if (strncmp(arg, "--profile=", 10) == 0) {
+    opts->profile = arg + 10;
     return 1;
   }
 
-  printf("   ✅ CMake configuration completed successfully.\n\n");
+  if (strcmp(arg, "-j") == 0 || strcmp(arg, "--jobs") == 0) {
+    if (*index + 1 >= argc) {
+      fprintf(stderr, "❌ Error: %s requires a job count\n", arg);
+      return -1;
+    }
+    value = argv[++(*index)];
+  } else if (strncmp(arg, "--jobs=", 7) == 0) {
+    value = arg + 7;
+  } else if (strncmp(arg, "-j", 2) == 0 && isdigit((unsigned char)arg[2])) {
+    // Only -jN; anything else starting with -j (-json) is left for the program
+    value = arg + 2;
+  } else {
+    return 0;
+  }
+
+  opts->jobs = parse_job_count(value);
+  if (opts->jobs < 0) {
+    fprintf(stderr, "❌ Error: Invalid job count '%s'\n", value);
+    return -1;
+  }
+  return 1;
+}
+
+// Resolve the job count: command line, then build.jobs in sbor.conf, then the CPU count
+static int resolve_job_count(const struct build_options *opts) {
+  if (opts->jobs > 0) {
+    return opts->jobs;
+  }
+
+  char *configured = get_config_value("build", "jobs");
+  if (configured) {
+    int jobs = parse_job_count(configured);
+    if (jobs < 0 && strcmp(configured, "0") != 0 && strcmp(configured, "auto") != 0) {
+      fprintf(stderr, "⚠️  Warning: Ignoring invalid build.jobs value '%s' in sbor.conf\n", configured);
+    }
+    free(configured);
+    if (jobs > 0) {
+      return jobs;
+    }
+  }
+
+  return get_cpu_count();
+}
+
+// Map a build.generator value from sbor.conf to a CMake generator name
+static char* normalize_generator(const char *value) {
+  if (strcmp(value, "ninja") == 0 || strcmp(value, "Ninja") == 0) {
+    return strdup("Ninja");
+  }
+  if (strcmp(value, "make") == 0 || strcmp(value, "makefiles") == 0) {
+  #ifdef _WIN32
+    return strdup("MinGW Makefiles");
+  #else
+    return strdup("Unix Makefiles");
+  #endif
+  }
+  // Anything else is passed to cmake -G verbatim
+  return strdup(value);
+}
+
+// Pick the CMake generator: build.generator in sbor.conf, otherwise
+// Ninja when it is installed. Returns NULL for the platform default.
+static char* select_generator(void) {
+  char *configured = get_config_value("build", "generator");
+  if (configured && *configured && strcmp(configured, "auto") != 0) {
+    char *generator = normalize_generator(configured);
+    free(configured);
+    return generator;
+  }
+  free(configured);
+
+  char *ninja = find_program("ninja");
+  if (ninja) {
+    free(ninja);
+    return strdup("Ninja");
+  }
+
+  #ifdef _WIN32
+    return NULL;  // Let CMake pick (Visual Studio / NMake)
+  #else
+    return strdup("Unix Makefiles");
+  #endif
+}
+
+// CMake refuses to switch generators or compilers in an existing build tree,
+// so drop the cache when the value recorded by the previous build differs.
+static void reset_cache_on_change(const char *record, const char *what, const char *current) {
+  char path[256];
+  snprintf(path, sizeof(path), ".sbor/%s", record);
+  char *previous = read_file_contents(path);
+
+  if (previous && strcmp(previous, current) != 0 && file_exists("CMakeCache.txt")) {
+    printf("   🔁 %s changed (%s -> %s), resetting CMake cache...\n", what, previous, current);
+    remove("CMakeCache.txt");
+    remove_directory("CMakeFiles");
+  }
+  free(previous);
+}
+
+// Remember which generator or compiler configured this build tree
+static void record_configuration(const char *record, const char *value) {
+  if (!file_exists(".sbor")) {
+    create_directory(".sbor");
+  }
+  char path[256];
+  snprintf(path, sizeof(path), ".sbor/%s", record);
+  create_file_with_content(path, value);
+}
+
+// Locate the C compiler from sbor.conf (or $CC / cc), for the configure fingerprint
+static char* resolve_toolchain(const struct project_config *config) {
+  char *path = find_program(config->compiler);
+  return path ? path : strdup(config->compiler);
+}
+
+// Append "-Dname=value" with the values joined by `separator`
+static void append_define(struct arg_list *args, const char *name, const struct arg_list *values,
+                          const char *separator) {
+  size_t size = strlen(name) + 4;
+  for (int i = 0; i < values->count; i++) {
+    size += strlen(values->items[i]) + strlen(separator);
+  }
+  char *define = malloc(size);
+  size_t length = (size_t)snprintf(define, size, "-D%s=", name);
+  for (int i = 0; i < values->count; i++) {
+    length += (size_t)snprintf(define + length, size - length, "%s%s", i ? separator : "", values->items[i]);
+  }
+  arg_list_push(args, define);
+  free(define);
+}
+
+// Translate c_standard ("c17", "gnu11", "c2x") into CMake's C standard and extensions
+static void append_c_standard(struct arg_list *args, const char *standard) {
+  if (!standard || !*standard) {
+    return;
+  }
+  int gnu = strncmp(standard, "gnu", 3) == 0;
+  const char *version = standard + (gnu ? 3 : (*standard == 'c' ? 1 : 0));
+  if (strcmp(version, "2x") == 0) version = "23";
+  else if (strcmp(version, "1x") == 0) version = "11";
+  else if (strcmp(version, "89") == 0 || strcmp(version, "9x") == 0) version = "90";
+
+  arg_list_pushf(args, "-DCMAKE_C_STANDARD=%s", version);
+  arg_list_pushf(args, "-DCMAKE_C_EXTENSIONS=%s", gnu ? "ON" : "OFF");
+}
+
+// Unity builds are requested with --unity or build.unity in sbor.conf
+int unity_enabled(const struct build_options *opts) {
+  return opts->unity || get_config_flag("build", "unity", 0);
+}
+
+// Sources per unity translation unit: build.unity_batch_size, 8 by default
+int unity_batch_size(void) {
+  char *value = get_config_value("build", "unity_batch_size");
+  int size = value ? atoi(value) : 0;
+  free(value);
+  return size > 0 ? size : 8;
+}
+
+// Cache variables sbor passes to cmake, appended to `args`: the compiler,
+// C standard and flags from sbor.conf plus the profile's build type and
+// flags. Called from the project root.
+static void compute_cmake_args(const struct build_options *opts, const struct project_config *config,
+                               const struct build_profile *profile, struct arg_list *args) {
+  char root[1024];
+  if (getcwd(root, sizeof(root)) == NULL) {
+    root[0] = '\0';
+  }
+
+  // Compiles run through `sbor __time` only for --timings and events
+  // (--message-format=json, or the stream `sbor watch` hands its builds
+  // through $SBOR_EVENTS_FD; see timings.c), so a plain build pays no extra
+  // exec per compile. The launcher is part of these arguments and so of the
+  // configure stamp: toggling either option reconfigures, and Ninja, which
+  // tracks commands, recompiles. With the object cache the launcher is (or
+  // wraps) `sbor cache compile`.
+  char *self = get_self_executable();
+  int timed = opts->timings || opts->json_messages || events_enabled();
+  if (self && cache_enabled() && timed) {
+    arg_list_pushf(args, "-DCMAKE_C_COMPILER_LAUNCHER=%s;__time;%s;cache;compile;--root;%s", self, self, root);
+  } else if (self && cache_enabled()) {
+    arg_list_pushf(args, "-DCMAKE_C_COMPILER_LAUNCHER=%s;cache;compile;--root;%s", self, root);
+  } else if (self && timed) {
+    arg_list_pushf(args, "-DCMAKE_C_COMPILER_LAUNCHER=%s;__time", self);
+  } else {
+    arg_list_push(args, "-DCMAKE_C_COMPILER_LAUNCHER=");
+  }
+
+  // Every link runs through `sbor __link`, which records the link time the
+  // build summary prints (see linker.c). Links are few, so it stays on.
+  if (self) {
+    arg_list_pushf(args, "-DCMAKE_C_LINKER_LAUNCHER=%s;__link;%s/%s/.sbor/link-time",
+                   self, root, profile->directory);
+    free(self);
+  }
+
+  // Read by the SBOR_PCH option in generated CMakeLists.txt files
+  arg_list_pushf(args, "-DSBOR_PCH=%s", get_config_flag("build", "pch", 1) ? "ON" : "OFF");
+
+  // Read by the SBOR_BENCHES option (sbor microbench)
+  arg_list_pushf(args, "-DSBOR_BENCHES=%s", opts->benches ? "ON" : "OFF");
+
+  // CMake caches these, so switching unity off must be explicit too
+  if (unity_enabled(opts)) {
+    struct arg_list excluded;
+    arg_list_init(&excluded);
+    get_config_list("build", "unity_exclude", &excluded);
+
+    arg_list_push(args, "-DCMAKE_UNITY_BUILD=ON");
+    arg_list_pushf(args, "-DCMAKE_UNITY_BUILD_BATCH_SIZE=%d", unity_batch_size());
+    append_define(args, "SBOR_UNITY_EXCLUDE", &excluded, ";");
+    arg_list_free(&excluded);
+  } else {
+    arg_list_push(args, "-DCMAKE_UNITY_BUILD=OFF");
+  }
+
+  arg_list_pushf(args, "-DCMAKE_C_COMPILER=%s", config->compiler);
+  arg_list_pushf(args, "-DCMAKE_BUILD_TYPE=%s", profile->build_type);
+  append_c_standard(args, config->c_standard);
+
+  // The profile owns CMAKE_C_FLAGS_<TYPE>, replacing CMake's defaults for it
+  char variable[128];
+  char upper[64];
+  size_t i = 0;
+  for (; profile->build_type[i] && i + 1 < sizeof(upper); i++) {
+    upper[i] = (char)toupper((unsigned char)profile->build_type[i]);
+  }
+  upper[i] = '\0';
+  snprintf(variable, sizeof(variable), "CMAKE_C_FLAGS_%s", upper);
+  append_define(args, variable, &profile->flags, " ");
+  snprintf(variable, sizeof(variable), "CMAKE_EXE_LINKER_FLAGS_%s", upper);
+  append_define(args, variable, &profile->link_flags, " ");
+}
+
+// Build the configure stamp: a fingerprint over everything that can change
+// the result of configuring. Called from the project root.
+static char* compute_configure_stamp(const char *generator, const struct arg_list *cmake_args,
+                                     const char *toolchain) {
+  const char *generator_name = generator ? generator : "default";
+
+  unsigned long long hash = HASH_SEED;
+  hash = hash_file(hash, "CMakeLists.txt");
+  hash = hash_file(hash, "sbor.conf");
+  hash = hash_string(hash, toolchain);
+  hash = hash_string(hash, generator_name);
+  hash = hash_arg_list(hash, cmake_args);
+
+  size_t size = strlen(toolchain) + strlen(generator_name) + 96;
+  char *stamp = malloc(size);
+  snprintf(stamp, size, "fingerprint=%016llx\ngenerator=%s\ntoolchain=%s\n",
+           hash, generator_name, toolchain);
+  return stamp;
+}
+
+// Check whether the build tree was configured with the same fingerprint
+// and still has the files the build tool needs. Called from the build directory.
+static int configure_is_current(const char *stamp, const char *generator) {
+  if (!file_exists("CMakeCache.txt")) {
+    return 0;
+  }
+  if (generator && strcmp(generator, "Ninja") == 0 && !file_exists("build.ninja")) {
+    return 0;
+  }
+  if (generator && strstr(generator, "Makefiles") != NULL && !file_exists("Makefile")) {
+    return 0;
+  }
+  // Trees configured before sbor asked for the codemodel have no target list
+  if (!cmake_codemodel_ready()) {
+    return 0;
+  }
+
+  char *previous = read_file_contents(".sbor/configure.stamp");
+  int current = previous && strcmp(previous, stamp) == 0;
+  free(previous);
+  return current;
+}
+
+// CMakeLists.txt files written by `sbor init` before the build profiles
+// hard-code the C standard and Release flags, so c_standard and the profile
+// flags are silently overridden. They are recognized by the unguarded
+// set(CMAKE_C_STANDARD ...).
+static void warn_if_old_template(const char *project_dir) {
+  char path[1200];
+  snprintf(path, sizeof(path), "%s/CMakeLists.txt", project_dir);
+  char *content = read_file_contents(path);
+  if (content && strstr(content, "set(CMAKE_C_STANDARD") && !strstr(content, "if(NOT CMAKE_C_STANDARD)")) {
+    printf("⚠️  Warning: CMakeLists.txt predates sbor's build profiles and overrides them.\n");
+    printf("   c_standard, the profile flags, \"pch\" and sbor microbench are ignored until it is\n");
+    printf("   regenerated: copy the CMakeLists.txt of a fresh 'sbor init' and re-add your sources.\n");
+  }
+  free(content);
+}
+
+// Whether the installed CMake is at least <major>.<minor>, e.g. 3.18 to
+// profile the configure step as a trace
+static int cmake_at_least(int required_major, int required_minor) {
+  char *argv[] = { "cmake", "--version", NULL };
+  char *out = NULL, *err = NULL;
+  size_t out_length = 0, err_length = 0;
+  int major = 0, minor = 0;
+  if (run_process_capture(argv, &out, &out_length, &err, &err_length) != 0 || !out ||
+      sscanf(out, "cmake version %d.%d", &major, &minor) != 2) {
+    major = 0;
+  }
+  free(out);
+  free(err);
+  return major > required_major || (major == required_major && minor >= required_minor);
+}
+
+// Run the native build tool for the selected generator
+static int run_build_tool(const char *generator, int jobs) {
+  char parallel[32];
+  snprintf(parallel, sizeof(parallel), "%d", jobs);
+
+  if (generator && strcmp(generator, "Ninja") == 0) {
+    char *ninja[] = { "ninja", "-j", parallel, NULL };
+    return execute_command(ninja);
+  }
 
-  // Run make command
-  printf("🔨 Building project with Make...\n");
+  if (generator && strstr(generator, "Makefiles") == NULL) {
+    // IDE and other generators: let CMake drive the right tool
+    char *cmake[] = { "cmake", "--build", ".", "--parallel", parallel, NULL };
+    return execute_command(cmake);
+  }
+
+  char make_jobs[32];
+  snprintf(make_jobs, sizeof(make_jobs), "-j%d", jobs);
+  char *make[] = { "make", make_jobs, NULL };
 
   // make command changes based on pplatform
   int make_result;
   #ifdef _WIN32
     // Trying nmake first , then mingw32-make then make
-    make_result = execute_command("nmake");
+    // nmake has no parallel mode, so only the GNU makes get -j
+    char *nmake[] = { "nmake", NULL };
+    char *mingw_make[] = { "mingw32-make", make_jobs, NULL };
+    make_result = generator ? -1 : execute_command(nmake);
     if (make_result != 0) {
-      make_result = execute_command("mingw32-make");
+      make_result = execute_command(mingw_make);
       if (make_result != 0) {
-        make_result = execute_command("make");
+        make_result = execute_command(make);
       }
     }
   #else
     // On unix-like sytems, it is just make
-    make_result = execute_command("make");
+    make_result = execute_command(make);
   #endif
-  
-  if (make_result != 0) {
-    fprintf(stderr, "❌ Error: Build failed (exit code: %d).\n", make_result);
-    fprintf(stderr, "   Please check for compilation errors above.\n");
-    chdir(current_dir);  // Return to original directory
+
+  return make_result;
+}
+
+int cmd_build(int argc, char *argv[]) {
+  struct build_options opts;
+  init_build_options(&opts);
+
+  for (int i = 1; i < argc; i++) {
+    int parsed = parse_build_option(argc, argv, &i, &opts);
+    if (parsed < 0) {
+      return 1;
+    }
+    if (parsed == 0) {
+      fprintf(stderr, "❌ Error: Unknown build option '%s'\n", argv[i]);
+      fprintf(stderr, "   Usage: sbor build [-j N | --jobs N] [--release | --profile NAME] [--pgo] [--bolt] [--reconfigure] [--unity] [--timings] [--message-format json]\n");
+      return 1;
+    }
+  }
+
+  return build_project(&opts);
+}
+
+// Configure (when needed) and build the profile's CMake tree
+static int cmake_build(const struct build_options *opts, int jobs,
+                       const struct project_config *config, const struct build_profile *profile) {
+  // Create the profile's build directory if it doesn't exist
+  if (!file_exists(profile->directory)) {
+    printf("📁 Creating build directory %s/...\n", profile->directory);
+    if (make_directories(profile->directory) != 0) {
+      fprintf(stderr, "❌ Error: Failed to create build directory\n");
+      return 1;
+    }
+    printf("   ✅ Build directory created successfully.\n\n");
+  } else {
+    printf("📁 Using existing build directory %s/...\n\n", profile->directory);
+  }
+
+  double configure_started = build_phase_started("configure");
+  char *generator = select_generator();
+  char *toolchain = resolve_toolchain(config);
+  struct arg_list cmake_args;
+  arg_list_init(&cmake_args);
+  compute_cmake_args(opts, config, profile, &cmake_args);
+  char *stamp = compute_configure_stamp(generator, &cmake_args, toolchain);
+
+  // Save current directory
+  char current_dir[1024];
+  if (getcwd(current_dir, sizeof(current_dir)) == NULL) {
+    fprintf(stderr, "❌ Error: Failed to get current directory.\n");
+    free(generator);
+    free(toolchain);
+    free(stamp);
+    arg_list_free(&cmake_args);
+    return 1;
+  }
+
+  // Change build directory
+  if (chdir(profile->directory) != 0) {
+    fprintf(stderr, "❌ Error: Failed to change to build directory.\n");
+    free(generator);
+    free(toolchain);
+    free(stamp);
+    arg_list_free(&cmake_args);
     return 1;
   }
 
-  printf("   ✅ Build completed successfully.\n\n");
+  int result = 0;
+  if (!opts->reconfigure && configure_is_current(stamp, generator)) {
+    printf("⚡ Configuration up to date, skipping CMake (use --reconfigure to force).\n\n");
+  } else {
+    printf("🔧 Configuring project with CMake (%s generator, %s profile)...\n",
+           generator ? generator : "default", profile->name);
+
+    warn_if_old_template(current_dir);
+    reset_cache_on_change("generator", "Generator", generator ? generator : "default");
+    reset_cache_on_change("toolchain", "Compiler", toolchain);
+
+    // Run cmake command
+    struct arg_list cmake_command;
+    arg_list_init(&cmake_command);
+    arg_list_push(&cmake_command, "cmake");
+    if (generator) {
+      arg_list_push(&cmake_command, "-G");
+      arg_list_push(&cmake_command, generator);
+    }
+    // CMAKE_C_LINKER_LAUNCHER needs CMake 3.21; older ones would only
+    // report it as unused
+    int link_launcher = cmake_at_least(3, 21);
+    if (!link_launcher) {
+      printf("   🔗 CMake before 3.21 cannot launch the linker through sbor: no link times.\n");
+    }
+    for (int i = 0; i < cmake_args.count; i++) {
+      if (link_launcher || strncmp(cmake_args.items[i], "-DCMAKE_C_LINKER_LAUNCHER=", 26) != 0) {
+        arg_list_push(&cmake_command, cmake_args.items[i]);
+      }
+    }
+    arg_list_push(&cmake_command, current_dir);
+
+    // With --timings, CMake profiles itself into the build trace
+    char cmake_trace[1200] = "";
+    if (timings_enabled() && cmake_at_least(3, 18)) {
+      snprintf(cmake_trace, sizeof(cmake_trace), "%s/%s/.sbor/cmake-trace.json",
+               current_dir, profile->directory);
+      arg_list_push(&cmake_command, "--profiling-format=google-trace");
+      arg_list_pushf(&cmake_command, "--profiling-output=%s", cmake_trace);
+    }
+
+    // Drop the stamp first so an interrupted configure is never trusted
+    remove(".sbor/configure.stamp");
+    request_cmake_codemodel();
+
+    int cmake_result = execute_command(cmake_command.items);
+    arg_list_free(&cmake_command);
+    if (cmake_result != 0) {
+      fprintf(stderr, "❌ Error: CMake configuration failed (exit code: %d).\n", cmake_result);
+      fprintf(stderr, "   Please check your CMakeLists.txt file and ensure CMake is installed.\n");
+      result = 1;
+    } else {
+      record_configuration("generator", generator ? generator : "default");
+      record_configuration("toolchain", toolchain);
+      create_file_with_content(".sbor/configure.stamp", stamp);
+      printf("   ✅ CMake configuration completed successfully.\n\n");
+    }
+    if (cmake_trace[0]) {
+      timings_attach_trace(cmake_trace, configure_started);
+    }
+  }
+  build_phase_finished("configure", configure_started, result == 0);
+  free(stamp);
+  arg_list_free(&cmake_args);
+  free(toolchain);
+
+  if (result == 0) {
+    // Run the build tool
+    const char *tool = "Make";
+    if (generator && strcmp(generator, "Ninja") == 0) {
+      tool = "Ninja";
+    } else if (generator && strstr(generator, "Makefiles") == NULL) {
+      tool = "cmake --build";
+    }
+    printf("🔨 Building project with %s (%d parallel job%s)...\n",
+           tool, jobs, jobs == 1 ? "" : "s");
+
+    // Written by `sbor __link` only if this build links
+    remove(".sbor/link-time");
+
+    // The compiler and linker launchers append their jobs here, see timings.c
+    char timings_log[1200];
+    snprintf(timings_log, sizeof(timings_log), "%s/%s/.sbor/timings.log", current_dir, profile->directory);
+    if (timings_enabled()) {
+      record_configuration("timings.log", "");
+      timings_export_log(timings_log);
+    }
+    double build_started = build_phase_started("build");
+    int make_result = run_build_tool(generator, jobs);
+    double build_finished = timings_now();
+    if (timings_enabled()) {
+      timings_export_log(NULL);
+      timings_load_log(timings_log);
+    }
+    build_phase_finished("build", build_started, make_result == 0);
+    // Whatever runs after the last job: post-build commands and the tool itself
+    timings_phase("post-build steps", timings_last_job_end(), build_finished);
+    if (make_result != 0) {
+      fprintf(stderr, "❌ Error: Build failed (exit code: %d).\n", make_result);
+      fprintf(stderr, "   Please check for compilation errors above.\n");
+      result = 1;
+    } else {
+      printf("   ✅ Build completed successfully.\n");
+      if (record_cmake_targets() <= 0) {
+        printf("   ⚠️  Warning: CMake reported no executable targets.\n");
+      }
+      char *link_time = read_file_contents(".sbor/link-time");
+      if (link_time) {
+        print_link_time(atof(link_time), profile);
+        free(link_time);
+      }
+      printf("\n");
+    }
+  }
+  free(generator);
 
   // Return to original directory
   if (chdir(current_dir) != 0) {
     fprintf(stderr, "⚠️  Warning: Failed to return to original directory.\n");
   }
+  return result;
+}
+
+// The last event of a build: its result and, on success, the executables
+static void report_build_finished(int result, double started, const struct project_config *config,
+                                  const struct build_profile *profile) {
+  if (!events_enabled()) {
+    return;
+  }
+  struct event event;
+  if (result == 0 && config && profile) {
+    struct arg_list names, paths;
+    load_targets(profile->directory, &names, &paths);
+    for (int i = 0; i < names.count; i++) {
+      event_begin(&event, "artifact");
+      event_string(&event, "kind", "executable");
+      event_string(&event, "name", names.items[i]);
+      event_string(&event, "path", paths.items[i]);
+      event_string(&event, "profile", profile->name);
+      event_emit(&event);
+    }
+    arg_list_free(&names);
+    arg_list_free(&paths);
+  }
+  event_begin(&event, "build-finished");
+  event_bool(&event, "success", result == 0);
+  event_int(&event, "exit_code", result);
+  event_number(&event, "duration", timings_now() - started);
+  event_emit(&event);
+}
 
-  // Check if binary was created and show its location
-  if (file_exists("build")) {
-    printf("🎉 Build successful!\n");
-    printf("   📍 Binary location: ./build/\n");
-    printf("   🚀 Run your project with: cd build && ./<project_name>\n");
-    printf("   💡 Or use: sbor run\n");
+int build_project(const struct build_options *opts) {
+  if (opts->json_messages) {
+    events_start();
+  }
+  if (opts->timings) {
+    timings_start();
+  }
+  double started = timings_now();
+
+  if (opts->pgo) {
+    return pgo_build(opts);
+  }
+  if (opts->bolt) {
+    return bolt_build(opts);
   }
 
-  return 0;
+  printf("🔨 Building project...\n\n");
+  if (events_enabled()) {
+    char *profile_name = selected_profile_name(opts);
+    struct event event;
+    event_begin(&event, "build-started");
+    event_string(&event, "profile", profile_name);
+    event_emit(&event);
+    free(profile_name);
+  }
+  double load_started = build_phase_started("load configuration");
+
+  // Check if we are in a valid sbor project
+  if (!is_valid_sbor_project()) {
+    fprintf(stderr, "❌ Error: Not in a valid sbor project directory.\n");
+    fprintf(stderr, "   Make sure you're in a directory created with 'sbor init' that contains:\n");
+    fprintf(stderr, "   - CMakeLists.txt\n");
+    fprintf(stderr, "   - sbor.conf\n");
+    fprintf(stderr, "   - src/ directory\n\n");
+    fprintf(stderr, "   Run 'sbor init <project_name>' to create a new project.\n");
+    build_phase_finished("load configuration", load_started, 0);
+    report_build_finished(1, started, NULL, NULL);
+    return 1;
+  }
+
+  // Read sbor.conf before leaving the project root
+  struct project_config config;
+  if (load_project_config(&config) != 0) {
+    fprintf(stderr, "❌ Error: Could not load the project configuration from sbor.conf.\n");
+    build_phase_finished("load configuration", load_started, 0);
+    report_build_finished(1, started, NULL, NULL);
+    return 1;
+  }
+  struct build_profile profile;
+  if (load_build_profile(opts, &config, &profile) != 0) {
+    free_project_config(&config);
+    build_phase_finished("load configuration", load_started, 0);
+    report_build_finished(1, started, NULL, NULL);
+    return 1;
+  }
+  int jobs = resolve_job_count(opts);
+  build_phase_finished("load configuration", load_started, 1);
+
+  // build.backend = "native" compiles directly without CMake
+  char *backend = get_config_value("build", "backend");
+  int result;
+  if (backend && strcmp(backend, "native") == 0) {
+    result = native_build(opts, jobs);
+    if (result != 0) {
+      fprintf(stderr, "❌ Error: Build failed.\n");
+      fprintf(stderr, "   Please check for compilation errors above.\n");
+    }
+  } else {
+    if (backend && *backend && strcmp(backend, "cmake") != 0) {
+      fprintf(stderr, "⚠️  Warning: Unknown build.backend '%s', using cmake\n", backend);
+    }
+    result = cmake_build(opts, jobs, &config, &profile);
+  }
+  free(backend);
+
+  if (result == 0) {
+    printf("🎉 Build successful! (%s profile)\n", profile.name);
+    printf("   📍 Binary location: ./%s/%s\n", profile.directory, config.name);
+    printf("   💡 Run your project with: sbor run%s%s\n",
+           opts->profile ? " --profile " : "", opts->profile ? opts->profile : "");
+  }
+
+  if (opts->timings) {
+    char trace_path[1100];
+    snprintf(trace_path, sizeof(trace_path), "%s/timings.json", profile.directory);
+    timings_finish(trace_path);
+  }
+  report_build_finished(result, started, &config, &profile);
 
+  free_build_profile(&profile);
+  free_project_config(&config);
+  return result;
 }
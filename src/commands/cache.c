@@ -0,0 +1,35 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/commands.h"
+
+static void print_cache_usage(void) {
+  printf("Usage:\n");
+  printf("  sbor cache stats                      Show hit/miss counts and cache size\n");
+  printf("  sbor cache clear                      Remove every cached object\n");
+  printf("  sbor cache serve [--port N] [--dir D]  Run a remote cache server (default 127.0.0.1:7878)\n");
+  printf("  sbor cache compile <compiler> <args>  Compile through the cache (used by sbor build)\n");
+}
+
+int cmd_cache(int argc, char *argv[]) {
+  if (argc < 2) {
+    print_cache_usage();
+    return 1;
+  }
+
+  const char *subcommand = argv[1];
+
+  if (strcmp(subcommand, "stats") == 0) {
+    return cache_print_stats();
+  } else if (strcmp(subcommand, "clear") == 0) {
+    return cache_clear();
+  } else if (strcmp(subcommand, "serve") == 0) {
+    return cache_serve(argc - 2, argv + 2);
+  } else if (strcmp(subcommand, "compile") == 0) {
+    return cache_compile(argc - 2, argv + 2);
+  } else {
+    fprintf(stderr, "❌ Error: Unknown cache command '%s'\n", subcommand);
+    print_cache_usage();
+    return 1;
+  }
+}
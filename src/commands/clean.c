@@ -2,6 +2,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
+#include <errno.h>
 
 #ifdef _WIN32
   #include <direct.h>
@@ -14,19 +15,53 @@
 
 #include "../include/commands.h"
 
-// Helper function to recursively delete a directory
+// Helper function to recursively delete a directory. A symbolic link,
+// including `path` itself, is removed without touching its target, as with
+// rm -rf. Returns 0 on success.
 int remove_directory(const char *path) {
   #ifdef _WIN32
-    char command[512];
-    snprintf(command, sizeof(command), "rmdir /s /q \"%s\"", path);
-    return system(command);
-  #else 
-    char command[512];
-    snprintf(command, sizeof(command), "rm -rf \"%s\"\n", path);
+    char *command[] = { "cmd", "/c", "rmdir", "/s", "/q", (char *)path, NULL };
+    return run_process(command);
+  #else
+    // A missing path is already removed; a link or file is just unlinked
+    struct stat self;
+    if (lstat(path, &self) != 0) {
+      return errno == ENOENT ? 0 : -1;
+    }
+    if (!S_ISDIR(self.st_mode)) {
+      return unlink(path) == 0 ? 0 : -1;
+    }
+
+    DIR *dir = opendir(path);
+    if (!dir) {
+      return -1;
+    }
+
+    int result = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+      if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+        continue;
+      }
+      size_t size = strlen(path) + strlen(entry->d_name) + 2;
+      char *child = malloc(size);
+      snprintf(child, size, "%s/%s", path, entry->d_name);
+
+      struct stat info;
+      if (lstat(child, &info) == 0 && S_ISDIR(info.st_mode)) {
+        result |= remove_directory(child);
+      } else if (unlink(child) != 0) {
+        result = -1;
+      }
+      free(child);
+    }
+    closedir(dir);
+
+    if (rmdir(path) != 0) {
+      result = -1;
+    }
+    return result;
   #endif
-  
-  int result = system(command);
-  return result;
 }
 
 int cmd_clean(int argc, char *argv[]) {
@@ -45,16 +80,28 @@ int cmd_clean(int argc, char *argv[]) {
     return 1;
   }
 
-  // Check if build directory exists
-  if (!file_exists("build")) {
+  // Check if build directory exists (build.output_dir, holding every profile)
+  char *output_dir = get_config_value("build", "output_dir");
+  if (!output_dir || !*output_dir) {
+    free(output_dir);
+    output_dir = strdup("build");
+  }
+  if (check_output_dir(output_dir) != 0) {
+    fprintf(stderr, "   Nothing was removed.\n");
+    free(output_dir);
+    return 1;
+  }
+  if (!file_exists(output_dir)) {
     printf("✨ Already clean! No build directory found.\n");
     printf("   The project has no build artifacts to remove.\n");
+    free(output_dir);
     return 0;
   }
 
-  printf("🗑️  Removing build directory...\n");
+  printf("🗑️  Removing build directory %s/...\n", output_dir);
 
-  int result = remove_directory("build");
+  int result = remove_directory(output_dir);
+  free(output_dir);
 
   if (result == 0) {
     printf("   ✅ Build directory removed successfully.\n\n");
@@ -0,0 +1,942 @@
+#ifdef __linux__
+  #define _GNU_SOURCE  // struct ucred, for SO_PEERCRED
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+
+#ifdef __linux__
+  #include <errno.h>
+  #include <fcntl.h>
+  #include <poll.h>
+  #include <signal.h>
+  #include <stdint.h>
+  #include <unistd.h>
+  #include <sys/socket.h>
+  #include <sys/stat.h>
+  #include <sys/un.h>
+  #include <sys/wait.h>
+  extern char **environ;
+#endif
+
+#include "../include/commands.h"
+
+// `sbor daemon`: a per-project build server.
+//
+// The daemon listens on a Unix socket named after the project directory,
+// <hash>.sock in a directory only the user can enter ($XDG_RUNTIME_DIR/sbor,
+// or /tmp/sbor-<uid> without it). Clients only talk to a daemon running as
+// the same user (SO_PEERCRED). While one is
+// running, `sbor build`, `sbor run` and `sbor list` send it their arguments,
+// environment, stdout and stderr (the descriptors themselves, SCM_RIGHTS)
+// instead of doing the work, and it answers with the exit status.
+//
+// What the daemon keeps between requests: the text of sbor.conf, a change
+// counter driven by inotify (watcher.c), and for each profile the value the
+// counter had when its last build succeeded. A build request with nothing
+// changed since is answered from memory, without configure, make or a
+// single stat of the tree. Other requests run as a forked job in their own
+// process group, writing straight to the client's terminal. A run with
+// nothing changed skips the up-to-date scan of the tree.
+//
+// The program of `sbor run` is never started by the daemon: the job hands
+// the executable's path back and the client runs it, so the program gets
+// the terminal, the environment and the signals it would get without a
+// daemon. Ctrl-C while the job is building is passed on to it.
+//
+// The daemon exits after `daemon.idle_timeout` seconds without a request
+// (30 minutes by default, 0 never) or on `sbor daemon stop`. Setting
+// SBOR_NO_DAEMON makes a command ignore it.
+
+#define DAEMON_PROTOCOL "sbor-daemon-1"
+#define DEFAULT_IDLE_TIMEOUT 1800
+#define MAX_REQUEST_SIZE (1 << 20)
+#define MAX_CURRENT_BUILDS 16
+
+static void print_daemon_usage(void) {
+  fprintf(stderr, "   Usage: sbor daemon [start] [--idle-timeout SECONDS] [--foreground]\n");
+  fprintf(stderr, "          sbor daemon status\n");
+  fprintf(stderr, "          sbor daemon stop\n");
+}
+
+#ifdef __linux__
+
+// A profile whose last build through the daemon succeeded
+struct current_build {
+  unsigned long long key;     // Profile and build environment, see build_key()
+  unsigned long generation;   // Change counter when that build started
+  char profile[64];
+};
+
+struct daemon_state {
+  int listener;
+  struct file_watcher *watcher;
+  char root[1024];
+  int idle_timeout;           // Seconds, 0 = never
+  double started;
+  long requests;
+  unsigned long generation;   // Changes to the build's inputs seen so far
+  struct current_build builds[MAX_CURRENT_BUILDS];
+  int build_count;
+};
+
+static volatile sig_atomic_t stop_requested = 0;
+static volatile sig_atomic_t forwarded_signal = 0;
+
+static void on_stop(int signal_number) {
+  (void)signal_number;
+  stop_requested = 1;
+}
+
+static void on_forwarded_signal(int signal_number) {
+  forwarded_signal = signal_number;
+}
+
+// The directory holding the sockets and logs: $XDG_RUNTIME_DIR/sbor, or
+// /tmp/sbor-<uid>. With `create` it is made if missing. Returns -1 unless it
+// is a real directory owned by this user that nobody else can enter, so
+// another user can neither plant a socket there nor remove ours.
+static int daemon_directory(char *path, size_t size, int create) {
+  const char *runtime = getenv("XDG_RUNTIME_DIR");
+  int length = runtime && *runtime ? snprintf(path, size, "%s/sbor", runtime)
+                                   : snprintf(path, size, "/tmp/sbor-%u", (unsigned)getuid());
+  if (length <= 0 || (size_t)length >= size) {
+    return -1;
+  }
+  if (create && mkdir(path, 0700) != 0 && errno != EEXIST) {
+    return -1;
+  }
+  struct stat info;
+  if (lstat(path, &info) != 0) {
+    return -1;
+  }
+  if (!S_ISDIR(info.st_mode) || info.st_uid != getuid() || (info.st_mode & 077) != 0) {
+    if (create) {
+      fprintf(stderr, "❌ Error: %s must be a directory owned by you with mode 0700.\n", path);
+    }
+    return -1;
+  }
+  return 0;
+}
+
+// <daemon directory>/<hash of the project directory><suffix>
+static int daemon_path(char *path, size_t size, const char *suffix, int create) {
+  char project[1024];
+  char directory[1024];
+  if (!getcwd(project, sizeof(project)) || daemon_directory(directory, sizeof(directory), create) != 0) {
+    return -1;
+  }
+  int length = snprintf(path, size, "%s/%016llx%s", directory, hash_string(HASH_SEED, project), suffix);
+  return length > 0 && (size_t)length < size ? 0 : -1;
+}
+
+static int socket_address(struct sockaddr_un *address, int create) {
+  memset(address, 0, sizeof(*address));
+  address->sun_family = AF_UNIX;
+  return daemon_path(address->sun_path, sizeof(address->sun_path), ".sock", create);
+}
+
+// Remove the socket of a daemon that died, but only if it is ours
+static void remove_stale_socket(const char *path) {
+  struct stat info;
+  if (lstat(path, &info) == 0 && S_ISSOCK(info.st_mode) && info.st_uid == getuid()) {
+    unlink(path);
+  }
+}
+
+// Connect to this project's daemon. Returns -1 if none is running or the
+// one listening runs as another user; a socket left behind by a daemon that
+// died is removed.
+static int connect_daemon(void) {
+  struct sockaddr_un address;
+  if (socket_address(&address, 0) != 0) {
+    return -1;
+  }
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return -1;
+  }
+  if (connect(fd, (struct sockaddr *)&address, sizeof(address)) != 0) {
+    if (errno == ECONNREFUSED) {
+      remove_stale_socket(address.sun_path);
+    }
+    close(fd);
+    return -1;
+  }
+
+  // Our stdout and stderr are about to be handed over: check who gets them
+  struct ucred peer;
+  socklen_t peer_size = sizeof(peer);
+  if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &peer, &peer_size) != 0 || peer.uid != getuid()) {
+    fprintf(stderr, "⚠️  Warning: Ignoring %s: it is not served by your own sbor daemon.\n", address.sun_path);
+    close(fd);
+    return -1;
+  }
+  fcntl(fd, F_SETFD, FD_CLOEXEC);
+  return fd;
+}
+
+static int send_all(int fd, const void *data, size_t length) {
+  const char *bytes = data;
+  while (length > 0) {
+    ssize_t sent = send(fd, bytes, length, MSG_NOSIGNAL);
+    if (sent < 0 && errno == EINTR) {
+      continue;
+    }
+    if (sent <= 0) {
+      return -1;
+    }
+    bytes += sent;
+    length -= (size_t)sent;
+  }
+  return 0;
+}
+
+static int receive_all(int fd, void *data, size_t length) {
+  char *bytes = data;
+  while (length > 0) {
+    ssize_t got = recv(fd, bytes, length, 0);
+    if (got < 0 && errno == EINTR) {
+      continue;
+    }
+    if (got <= 0) {
+      return -1;
+    }
+    bytes += got;
+    length -= (size_t)got;
+  }
+  return 0;
+}
+
+// A request is its strings back to back, each ending in NUL: the protocol
+// name, the client's directory, argc, the arguments and the environment.
+// It is preceded by its length, which carries the client's stdout and
+// stderr as ancillary data.
+static int send_request(int fd, const struct arg_list *request) {
+  size_t size = 0;
+  for (int i = 0; i < request->count; i++) {
+    size += strlen(request->items[i]) + 1;
+  }
+  char *payload = malloc(size);
+  char *cursor = payload;
+  for (int i = 0; i < request->count; i++) {
+    size_t length = strlen(request->items[i]) + 1;
+    memcpy(cursor, request->items[i], length);
+    cursor += length;
+  }
+
+  uint32_t length = (uint32_t)size;
+  int fds[2] = { STDOUT_FILENO, STDERR_FILENO };
+  char control[CMSG_SPACE(sizeof(fds))];
+  memset(control, 0, sizeof(control));
+  struct iovec part = { &length, sizeof(length) };
+  struct msghdr message;
+  memset(&message, 0, sizeof(message));
+  message.msg_iov = &part;
+  message.msg_iovlen = 1;
+  message.msg_control = control;
+  message.msg_controllen = sizeof(control);
+  struct cmsghdr *header = CMSG_FIRSTHDR(&message);
+  header->cmsg_level = SOL_SOCKET;
+  header->cmsg_type = SCM_RIGHTS;
+  header->cmsg_len = CMSG_LEN(sizeof(fds));
+  memcpy(CMSG_DATA(header), fds, sizeof(fds));
+
+  int sent = sendmsg(fd, &message, MSG_NOSIGNAL) == (ssize_t)sizeof(length) &&
+             send_all(fd, payload, size) == 0;
+  free(payload);
+  return sent ? 0 : -1;
+}
+
+// Read a request into `request`, and the client's stdout and stderr into
+// `fds`. Returns -1 for anything that is not a complete request.
+static int receive_request(int fd, struct arg_list *request, int fds[2]) {
+  uint32_t length = 0;
+  char control[CMSG_SPACE(sizeof(int) * 2)];
+  struct iovec part = { &length, sizeof(length) };
+  struct msghdr message;
+  memset(&message, 0, sizeof(message));
+  message.msg_iov = &part;
+  message.msg_iovlen = 1;
+  message.msg_control = control;
+  message.msg_controllen = sizeof(control);
+  if (recvmsg(fd, &message, 0) != (ssize_t)sizeof(length)) {
+    return -1;
+  }
+
+  fds[0] = fds[1] = -1;
+  struct cmsghdr *header = CMSG_FIRSTHDR(&message);
+  if (header && header->cmsg_level == SOL_SOCKET && header->cmsg_type == SCM_RIGHTS &&
+      header->cmsg_len == CMSG_LEN(sizeof(int) * 2)) {
+    memcpy(fds, CMSG_DATA(header), sizeof(int) * 2);
+    fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+    fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+  }
+  char *payload = length <= MAX_REQUEST_SIZE ? malloc(length + 1) : NULL;
+  if (fds[0] < 0 || !payload || receive_all(fd, payload, length) != 0) {
+    free(payload);
+    if (fds[0] >= 0) {
+      close(fds[0]);
+      close(fds[1]);
+    }
+    return -1;
+  }
+  payload[length] = '\0';
+
+  arg_list_init(request);
+  for (char *item = payload; item < payload + length; item += strlen(item) + 1) {
+    arg_list_push(request, item);
+  }
+  free(payload);
+  return 0;
+}
+
+// Reads everything the watcher has queued. Any change makes every recorded
+// build stale and the cached sbor.conf text with it.
+static void note_changes(struct daemon_state *state) {
+  char changed[1024];
+  if (watcher_read(state->watcher, changed, sizeof(changed)) > 0) {
+    state->generation++;
+    config_cache_drop();
+    printf("🔁 %s changed\n", changed);
+    fflush(stdout);
+  }
+}
+
+// Identifies what a build or run request would build: the profile and the
+// environment variables the toolchain reads. Returns 0 for requests whose
+// options always need a real build (see build_can_be_skipped()).
+static int build_key(int argc, char *argv[], char *const env[], unsigned long long *key,
+                     char *profile_name, size_t size) {
+  struct build_options opts;
+  init_build_options(&opts);
+  for (int i = 1; i < argc && strcmp(argv[i], "--") != 0; i++) {
+    if (parse_build_option(argc, argv, &i, &opts) < 0) {
+      return 0;
+    }
+  }
+  if (!build_can_be_skipped(&opts) || opts.benches) {
+    return 0;
+  }
+
+  char *profile = selected_profile_name(&opts);
+  snprintf(profile_name, size, "%s", profile);
+  unsigned long long hash = hash_string(HASH_SEED, profile);
+  free(profile);
+  static const char *const variables[] = { "PATH=", "CC=", "CFLAGS=", "LDFLAGS=", NULL };
+  for (int v = 0; variables[v]; v++) {
+    const char *value = "";
+    for (int i = 0; env[i]; i++) {
+      if (strncmp(env[i], variables[v], strlen(variables[v])) == 0) {
+        value = env[i];
+      }
+    }
+    hash = hash_string(hash, value);
+  }
+  *key = hash;
+  return 1;
+}
+
+static struct current_build* find_build(struct daemon_state *state, unsigned long long key) {
+  for (int i = 0; i < state->build_count; i++) {
+    if (state->builds[i].key == key) {
+      return &state->builds[i];
+    }
+  }
+  return NULL;
+}
+
+static int build_is_current(struct daemon_state *state, unsigned long long key) {
+  struct current_build *build = find_build(state, key);
+  return build && build->generation == state->generation;
+}
+
+static void remember_build(struct daemon_state *state, unsigned long long key,
+                           unsigned long generation, const char *profile) {
+  struct current_build *build = find_build(state, key);
+  if (!build) {
+    // Full: the oldest entry makes room
+    if (state->build_count == MAX_CURRENT_BUILDS) {
+      memmove(&state->builds[0], &state->builds[1], sizeof(state->builds[0]) * (MAX_CURRENT_BUILDS - 1));
+      state->build_count--;
+    }
+    build = &state->builds[state->build_count++];
+    build->key = key;
+  }
+  build->generation = generation;
+  snprintf(build->profile, sizeof(build->profile), "%s", profile);
+}
+
+// Whether every executable the profile's last build recorded still exists,
+// so nothing was cleaned or deleted behind the daemon's back
+static int targets_exist(const char *profile_name) {
+  struct project_config config;
+  if (load_project_config(&config) != 0) {
+    return 0;
+  }
+  char directory[1100];
+  snprintf(directory, sizeof(directory), "%s/%s", config.output_dir, profile_name);
+  free_project_config(&config);
+
+  struct arg_list names, paths;
+  int present = load_targets(directory, &names, &paths) > 0;
+  for (int i = 0; i < paths.count && present; i++) {
+    present = file_exists(paths.items[i]);
+  }
+  arg_list_free(&names);
+  arg_list_free(&paths);
+  return present;
+}
+
+static void reply(int connection, const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+static void reply(int connection, const char *format, ...) {
+  char line[4200];
+  va_list args;
+  va_start(args, format);
+  int length = vsnprintf(line, sizeof(line), format, args);
+  va_end(args);
+  if (length > 0 && (size_t)length < sizeof(line)) {
+    send_all(connection, line, (size_t)length);
+  }
+}
+
+// The forked job: the command itself, on the client's stdout and stderr,
+// in the client's environment, in a process group of its own
+static void run_job(struct daemon_state *state, int connection, const int fds[2], int handoff,
+                    int argc, char *argv[], char *env[], int current) {
+  setpgid(0, 0);
+  close(state->listener);
+  close(connection);
+  watcher_close(state->watcher);
+
+  int null_device = open("/dev/null", O_RDONLY);
+  if (null_device >= 0) {
+    dup2(null_device, STDIN_FILENO);
+    close(null_device);
+  }
+  dup2(fds[0], STDOUT_FILENO);
+  dup2(fds[1], STDERR_FILENO);
+  close(fds[0]);
+  close(fds[1]);
+  setvbuf(stdout, NULL, isatty(STDOUT_FILENO) ? _IOLBF : _IOFBF, BUFSIZ);
+
+  signal(SIGINT, SIG_DFL);
+  signal(SIGTERM, SIG_DFL);
+  signal(SIGPIPE, SIG_DFL);
+  environ = env;
+
+  int exit_code;
+  if (strcmp(argv[0], "run") == 0) {
+    run_hand_off(handoff);
+    if (current) {
+      assume_targets_fresh();
+    }
+    exit_code = cmd_run(argc, argv);
+  } else if (strcmp(argv[0], "build") == 0) {
+    exit_code = cmd_build(argc, argv);
+  } else {
+    exit_code = cmd_list(argc, argv);
+  }
+  exit(exit_code);
+}
+
+// Serve a build, run or list request. While the job works, signal numbers
+// from the client are passed on to its process group, and a client that
+// goes away stops it.
+static void serve_job(struct daemon_state *state, int connection, const int fds[2],
+                      int argc, char *argv[], char *env[]) {
+  unsigned long long key = 0;
+  char profile[64] = "";
+  int keyed = strcmp(argv[0], "list") != 0 && build_key(argc, argv, env, &key, profile, sizeof(profile));
+  int current = keyed && build_is_current(state, key);
+
+  if (strcmp(argv[0], "build") == 0 && current && targets_exist(profile)) {
+    dprintf(fds[0], "⚡ No changes since the last %s build, nothing to do (sbor daemon).\n", profile);
+    reply(connection, "exit 0 0\n");
+    return;
+  }
+
+  int handoff[2];
+  if (pipe(handoff) != 0) {
+    reply(connection, "retry\n");
+    return;
+  }
+  fcntl(handoff[0], F_SETFD, FD_CLOEXEC);
+  fcntl(handoff[1], F_SETFD, FD_CLOEXEC);
+
+  unsigned long generation = state->generation;
+  fflush(stdout);
+  fflush(stderr);
+  pid_t pid = fork();
+  if (pid == 0) {
+    close(handoff[0]);
+    run_job(state, connection, fds, handoff[1], argc, argv, env, current);
+  }
+  close(handoff[1]);
+  if (pid < 0) {
+    close(handoff[0]);
+    reply(connection, "retry\n");
+    return;
+  }
+  setpgid(pid, pid);
+
+  // The hand-off pipe closes when the job exits: only the job holds it, the
+  // tools it starts do not inherit it
+  char exe_path[4096];
+  size_t length = 0;
+  int client_open = 1;
+  int job_open = 1;
+  while (job_open) {
+    struct pollfd ready[3] = {
+      { handoff[0], POLLIN, 0 },
+      { watcher_fd(state->watcher), POLLIN, 0 },
+      { client_open ? connection : -1, POLLIN, 0 },
+    };
+    if (poll(ready, 3, -1) < 0) {
+      if (stop_requested) {
+        kill(-pid, SIGTERM);
+      }
+      continue;
+    }
+    if (ready[0].revents & (POLLIN | POLLHUP)) {
+      ssize_t got = read(handoff[0], exe_path + length, sizeof(exe_path) - 1 - length);
+      if (got > 0) {
+        length += (size_t)got;
+      } else if (got == 0 || errno != EINTR) {
+        job_open = 0;
+      }
+    }
+    if (ready[1].revents & POLLIN) {
+      note_changes(state);
+    }
+    if (ready[2].revents & (POLLIN | POLLHUP)) {
+      int signal_number;
+      ssize_t got = recv(connection, &signal_number, sizeof(signal_number), 0);
+      if (got == (ssize_t)sizeof(signal_number) && signal_number > 0 && signal_number < 65) {
+        kill(-pid, signal_number);
+      } else if (got == 0 || (got < 0 && errno != EINTR)) {
+        kill(-pid, SIGTERM);
+        client_open = 0;
+      }
+    }
+  }
+  close(handoff[0]);
+  exe_path[length] = '\0';
+
+  int status = 0;
+  while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+  }
+  int signal_number = WIFSIGNALED(status) ? WTERMSIG(status) : 0;
+  int exit_code = signal_number ? 128 + signal_number : WEXITSTATUS(status);
+
+  // A job that built (or found current) its executable leaves the profile
+  // current as of the moment it started; later changes make it stale again
+  int handed_off = strcmp(argv[0], "run") == 0 && exit_code == 0 && length > 0;
+  if (keyed && exit_code == 0 && (handed_off || strcmp(argv[0], "build") == 0)) {
+    remember_build(state, key, generation, profile);
+  }
+  if (handed_off) {
+    reply(connection, "run %s\n", exe_path);
+  } else {
+    reply(connection, "exit %d %d\n", exit_code, signal_number);
+  }
+}
+
+static void print_status(struct daemon_state *state, int out) {
+  dprintf(out, "🟢 sbor daemon running (pid %d) for %s\n", (int)getpid(), state->root);
+  dprintf(out, "   Up %.0fs, %ld request%s served, %lu change%s seen\n", timings_now() - state->started,
+          state->requests, state->requests == 1 ? "" : "s", state->generation,
+          state->generation == 1 ? "" : "s");
+  if (state->idle_timeout > 0) {
+    dprintf(out, "   Idle timeout: %ds\n", state->idle_timeout);
+  }
+  int shown = 0;
+  for (int i = 0; i < state->build_count; i++) {
+    if (state->builds[i].generation == state->generation) {
+      dprintf(out, "%s%s", shown++ ? ", " : "   Up to date: ", state->builds[i].profile);
+    }
+  }
+  if (shown) {
+    dprintf(out, "\n");
+  }
+}
+
+static void serve_request(struct daemon_state *state, int connection) {
+  struct arg_list request;
+  int fds[2];
+  if (receive_request(connection, &request, fds) != 0) {
+    return;
+  }
+  state->requests++;
+
+  // Anything saved before the request was sent is in the watcher's queue by now
+  note_changes(state);
+
+  int argc = request.count >= 3 ? atoi(request.items[2]) : 0;
+  if (request.count < 3 || strcmp(request.items[0], DAEMON_PROTOCOL) != 0 ||
+      strcmp(request.items[1], state->root) != 0 || argc < 1 || 3 + argc > request.count) {
+    // Another version of sbor, or another directory: the client works alone
+    reply(connection, "retry\n");
+  } else {
+    char **argv = malloc(sizeof(char *) * (argc + 1));
+    memcpy(argv, request.items + 3, sizeof(char *) * argc);
+    argv[argc] = NULL;
+    char **env = request.items + 3 + argc;  // The arg_list is NULL-terminated
+    const char *command = argv[0];
+    if (strcmp(command, "status") == 0) {
+      print_status(state, fds[0]);
+      reply(connection, "exit 0 0\n");
+    } else if (strcmp(command, "stop") == 0) {
+      dprintf(fds[0], "👋 sbor daemon (pid %d) stopped.\n", (int)getpid());
+      stop_requested = 1;
+      reply(connection, "exit 0 0\n");
+    } else if (strcmp(command, "build") == 0 || strcmp(command, "run") == 0 || strcmp(command, "list") == 0) {
+      serve_job(state, connection, fds, argc, argv, env);
+    } else {
+      reply(connection, "retry\n");
+    }
+    free(argv);
+  }
+  close(fds[0]);
+  close(fds[1]);
+  arg_list_free(&request);
+}
+
+// Accept requests one at a time until stopped or idle for too long
+static void serve(struct daemon_state *state) {
+  double last_request = timings_now();
+  while (!stop_requested) {
+    int timeout = -1;
+    if (state->idle_timeout > 0) {
+      double idle = timings_now() - last_request;
+      if (idle >= state->idle_timeout) {
+        printf("💤 Idle for %ds, shutting down.\n", state->idle_timeout);
+        break;
+      }
+      timeout = (int)((state->idle_timeout - idle) * 1000) + 1;
+    }
+
+    struct pollfd ready[2] = {
+      { state->listener, POLLIN, 0 },
+      { watcher_fd(state->watcher), POLLIN, 0 },
+    };
+    if (poll(ready, 2, timeout) < 0) {
+      continue;
+    }
+    if (ready[1].revents & POLLIN) {
+      note_changes(state);
+    }
+    if (ready[0].revents & POLLIN) {
+      int connection = accept(state->listener, NULL, NULL);
+      if (connection >= 0) {
+        fcntl(connection, F_SETFD, FD_CLOEXEC);
+        serve_request(state, connection);
+        close(connection);
+        last_request = timings_now();
+      }
+    }
+  }
+  fflush(stdout);
+}
+
+// Send `argv` to the daemon on `fd` and wait for its answer. Signals meant
+// for this process go to the job instead. Returns the exit code, or -1 if
+// the daemon declined the request; *exe_path is set when a run was handed
+// back.
+static int daemon_request(int fd, int argc, char *argv[], int *signal_number, char **exe_path) {
+  *signal_number = 0;
+  *exe_path = NULL;
+  char directory[1024];
+  if (!getcwd(directory, sizeof(directory))) {
+    return -1;
+  }
+
+  struct arg_list request;
+  arg_list_init(&request);
+  arg_list_push(&request, DAEMON_PROTOCOL);
+  arg_list_push(&request, directory);
+  arg_list_pushf(&request, "%d", argc);
+  for (int i = 0; i < argc; i++) {
+    arg_list_push(&request, argv[i]);
+  }
+  for (int i = 0; environ[i]; i++) {
+    arg_list_push(&request, environ[i]);
+  }
+  fflush(stdout);
+  fflush(stderr);
+  int sent = send_request(fd, &request);
+  arg_list_free(&request);
+  if (sent != 0) {
+    return -1;
+  }
+
+  static const int forwarded[] = { SIGINT, SIGTERM, SIGQUIT, SIGHUP };
+  struct sigaction action, previous[4];
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = on_forwarded_signal;
+  sigemptyset(&action.sa_mask);
+  for (int i = 0; i < 4; i++) {
+    sigaction(forwarded[i], &action, &previous[i]);
+  }
+
+  char answer[4200];
+  size_t length = 0;
+  while (length < sizeof(answer) - 1 && (length == 0 || answer[length - 1] != '\n')) {
+    if (forwarded_signal) {
+      int number = forwarded_signal;
+      forwarded_signal = 0;
+      send_all(fd, &number, sizeof(number));
+    }
+    struct pollfd ready = { fd, POLLIN, 0 };
+    if (poll(&ready, 1, 200) <= 0) {
+      continue;
+    }
+    ssize_t got = recv(fd, answer + length, sizeof(answer) - 1 - length, 0);
+    if (got < 0 && errno == EINTR) {
+      continue;
+    }
+    if (got <= 0) {
+      break;
+    }
+    length += (size_t)got;
+  }
+  answer[length] = '\0';
+
+  for (int i = 0; i < 4; i++) {
+    sigaction(forwarded[i], &previous[i], NULL);
+  }
+
+  int exit_code;
+  if (sscanf(answer, "exit %d %d", &exit_code, signal_number) == 2) {
+    return exit_code;
+  }
+  if (strncmp(answer, "run ", 4) == 0 && length > 5) {
+    answer[length - 1] = '\0';
+    *exe_path = strdup(answer + 4);
+    return 0;
+  }
+  if (strcmp(answer, "retry\n") == 0) {
+    return -1;
+  }
+  fprintf(stderr, "❌ Error: Lost the connection to the sbor daemon.\n");
+  return 1;
+}
+
+static int start_daemon(int idle_timeout, int foreground) {
+  if (!is_valid_sbor_project()) {
+    fprintf(stderr, "❌ Error: Not in a valid sbor project directory.\n");
+    fprintf(stderr, "   Run 'sbor init <project_name>' to create a new project.\n");
+    return 1;
+  }
+  int running = connect_daemon();
+  if (running >= 0) {
+    close(running);
+    printf("✅ An sbor daemon is already running for this project (see 'sbor daemon status').\n");
+    return 0;
+  }
+
+  struct daemon_state *state = calloc(1, sizeof(struct daemon_state));
+  struct sockaddr_un address;
+  char log_path[1024];
+  if (!getcwd(state->root, sizeof(state->root)) || socket_address(&address, 1) != 0 ||
+      daemon_path(log_path, sizeof(log_path), ".log", 1) != 0) {
+    fprintf(stderr, "❌ Error: Could not create the daemon socket for this project.\n");
+    free(state);
+    return 1;
+  }
+
+  // Only this user may connect: the socket is created with mode 0600, in a
+  // directory only this user can enter
+  state->listener = socket(AF_UNIX, SOCK_STREAM, 0);
+  remove_stale_socket(address.sun_path);
+  mode_t mask = umask(077);
+  int bound = state->listener >= 0 && bind(state->listener, (struct sockaddr *)&address, sizeof(address)) == 0;
+  umask(mask);
+  if (!bound || listen(state->listener, 16) != 0) {
+    fprintf(stderr, "❌ Error: Could not listen on %s\n", address.sun_path);
+    if (state->listener >= 0) {
+      close(state->listener);
+    }
+    free(state);
+    return 1;
+  }
+  fcntl(state->listener, F_SETFD, FD_CLOEXEC);
+
+  state->watcher = watcher_open();
+  if (!state->watcher) {
+    fprintf(stderr, "❌ Error: Could not start watching the project.\n");
+    close(state->listener);
+    unlink(address.sun_path);
+    free(state);
+    return 1;
+  }
+  state->idle_timeout = idle_timeout;
+  state->started = timings_now();
+
+  if (!foreground) {
+    fflush(stdout);
+    fflush(stderr);
+    pid_t pid = fork();
+    if (pid < 0) {
+      fprintf(stderr, "❌ Error: Could not start the daemon.\n");
+      unlink(address.sun_path);
+      return 1;
+    }
+    if (pid > 0) {
+      printf("✅ sbor daemon started (pid %d)\n", (int)pid);
+      printf("   Socket: %s\n", address.sun_path);
+      printf("   Log: %s\n", log_path);
+      if (idle_timeout > 0) {
+        printf("   Stops after %ds without a request, or with 'sbor daemon stop'\n", idle_timeout);
+      }
+      close(state->listener);
+      watcher_close(state->watcher);
+      free(state);
+      return 0;
+    }
+
+    // Detach from the terminal; from here on stdout and stderr are the log
+    setsid();
+    int null_device = open("/dev/null", O_RDONLY);
+    int log = open(log_path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (null_device >= 0) {
+      dup2(null_device, STDIN_FILENO);
+      close(null_device);
+    }
+    if (log >= 0) {
+      dup2(log, STDOUT_FILENO);
+      dup2(log, STDERR_FILENO);
+      close(log);
+    }
+  }
+
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = on_stop;
+  sigemptyset(&action.sa_mask);
+  sigaction(SIGINT, &action, NULL);
+  sigaction(SIGTERM, &action, NULL);
+  signal(SIGPIPE, SIG_IGN);
+  config_cache_enable();
+
+  printf("👀 sbor daemon (pid %d) serving %s on %s\n", (int)getpid(), state->root, address.sun_path);
+  fflush(stdout);
+  serve(state);
+
+  unlink(address.sun_path);
+  close(state->listener);
+  watcher_close(state->watcher);
+  free(state);
+  return 0;
+}
+
+#endif
+
+// Hand a command to the project's daemon, if one is running. Returns the
+// command's exit code, or -1 when the caller should do the work itself.
+int daemon_forward(int argc, char *argv[]) {
+#ifndef __linux__
+  (void)argc;
+  (void)argv;
+  return -1;
+#else
+  // `sbor watch` children and explicit opt-outs never use the daemon
+  if (getenv("SBOR_NO_DAEMON") || getenv("SBOR_EVENTS_FD")) {
+    return -1;
+  }
+  int fd = connect_daemon();
+  if (fd < 0) {
+    return -1;
+  }
+  int signal_number;
+  char *exe_path;
+  int exit_code = daemon_request(fd, argc, argv, &signal_number, &exe_path);
+  close(fd);
+
+  // The daemon built the program; run it from here, in the foreground
+  if (exe_path) {
+    run_prebuilt(exe_path);
+    exit_code = cmd_run(argc, argv);
+    free(exe_path);
+    return exit_code;
+  }
+  if (exit_code >= 0) {
+    raise_signal(signal_number);
+  }
+  return exit_code;
+#endif
+}
+
+int cmd_daemon(int argc, char *argv[]) {
+#ifndef __linux__
+  (void)argc;
+  (void)argv;
+  fprintf(stderr, "❌ Error: sbor daemon needs Unix sockets and inotify and is only available on Linux.\n");
+  return 1;
+#else
+  const char *action = "start";
+  int first = 1;
+  if (argc > 1 && argv[1][0] != '-') {
+    action = argv[1];
+    first = 2;
+  }
+
+  if (strcmp(action, "status") == 0 || strcmp(action, "stop") == 0) {
+    if (argc > first) {
+      fprintf(stderr, "❌ Error: Unknown daemon option '%s'\n", argv[first]);
+      print_daemon_usage();
+      return 1;
+    }
+    int fd = connect_daemon();
+    if (fd < 0) {
+      printf("💤 No sbor daemon is running for this project.\n");
+      return strcmp(action, "stop") == 0 ? 0 : 1;
+    }
+    int signal_number;
+    char *exe_path;
+    char *request[] = { (char *)action, NULL };
+    int exit_code = daemon_request(fd, 1, request, &signal_number, &exe_path);
+    close(fd);
+    free(exe_path);
+    if (exit_code < 0) {
+      fprintf(stderr, "❌ Error: The running sbor daemon belongs to another version of sbor.\n");
+      return 1;
+    }
+    return exit_code;
+  }
+  if (strcmp(action, "start") != 0) {
+    fprintf(stderr, "❌ Error: Unknown daemon command '%s'\n", action);
+    print_daemon_usage();
+    return 1;
+  }
+
+  int idle_timeout = DEFAULT_IDLE_TIMEOUT;
+  char *configured = get_config_value("daemon", "idle_timeout");
+  if (configured) {
+    idle_timeout = atoi(configured);
+    free(configured);
+  }
+  int foreground = 0;
+  for (int i = first; i < argc; i++) {
+    if (strcmp(argv[i], "--foreground") == 0) {
+      foreground = 1;
+    } else if (strcmp(argv[i], "--idle-timeout") == 0 && i + 1 < argc) {
+      idle_timeout = atoi(argv[++i]);
+    } else if (strncmp(argv[i], "--idle-timeout=", 15) == 0) {
+      idle_timeout = atoi(argv[i] + 15);
+    } else {
+      fprintf(stderr, "❌ Error: Unknown daemon option '%s'\n", argv[i]);
+      print_daemon_usage();
+      return 1;
+    }
+  }
+  if (idle_timeout < 0) {
+    fprintf(stderr, "❌ Error: The idle timeout must be 0 (never) or a number of seconds.\n");
+    return 1;
+  }
+  return start_daemon(idle_timeout, foreground);
+#endif
+}
@@ -14,14 +14,23 @@
 #include "../include/commands.h"
 
 int cmd_init(int argc, char *argv[]) {
-  if (argc < 2) {
+  // sbor init <project_name> [--bench]
+  const char *project_name = NULL;
+  int with_benches = 0;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--bench") == 0) {
+      with_benches = 1;
+    } else if (!project_name) {
+      project_name = argv[i];
+    }
+  }
+
+  if (!project_name) {
     fprintf(stderr, "Error: Project Name required\n");
-    fprintf(stderr, "Usage: sbor init <project_name>\n");
+    fprintf(stderr, "Usage: sbor init <project_name> [--bench]\n");
     return 1;
   }
 
-  const char *project_name = argv[1];
-
   // Validate project name
   if (strlen(project_name) == 0) {
     fprintf(stderr, "Error: Project name cannot be empty\n");
@@ -125,6 +134,30 @@ int cmd_init(int argc, char *argv[]) {
   free(config_content);
   printf("  ✓ sbor.conf\n");
 
+  // benches/ with the micro-benchmark harness and an example
+  if (with_benches) {
+    char benches_dir[256], harness_path[256], example_path[256];
+    snprintf(benches_dir, sizeof(benches_dir), "%s/benches", project_name);
+    snprintf(harness_path, sizeof(harness_path), "%s/benches/sbor_bench.h", project_name);
+    snprintf(example_path, sizeof(example_path), "%s/benches/example_bench.c", project_name);
+
+    char *harness_content = generate_bench_header_template();
+    char *example_content = generate_bench_example_template();
+    if (create_directory(benches_dir) != 0 ||
+        create_file_with_content(harness_path, harness_content) != 0 ||
+        create_file_with_content(example_path, example_content) != 0) {
+      fprintf(stderr, "Error: Failed to create benches/\n");
+      free(harness_content);
+      free(example_content);
+      return 1;
+    }
+
+    free(harness_content);
+    free(example_content);
+    printf("  ✓ benches/sbor_bench.h\n");
+    printf("  ✓ benches/example_bench.c\n");
+  }
+
   // Success message
   printf("\n✨ Project '%s' created successfully!\n\n", project_name);
   printf("Next steps:\n");
@@ -132,6 +165,9 @@ int cmd_init(int argc, char *argv[]) {
   printf("  mkdir build && cd build\n");
   printf("  cmake .. && make\n");
   printf("  ./%s\n\n", project_name);
+  if (with_benches) {
+    printf("Run the micro-benchmarks with: sbor microbench\n\n");
+  }
 
   return 0;
 }
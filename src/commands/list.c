@@ -0,0 +1,77 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/commands.h"
+
+// Print one of the header lists from sbor.conf's "includes" section
+static void print_headers(const char *title, const char *key) {
+  struct arg_list headers;
+  arg_list_init(&headers);
+  get_config_list("includes", key, &headers);
+
+  printf("%s (%d):\n", title, headers.count);
+  if (headers.count == 0) {
+    printf("   (none)\n");
+  }
+  for (int i = 0; i < headers.count; i++) {
+    printf("   %s\n", headers.items[i]);
+  }
+  arg_list_free(&headers);
+}
+
+// `sbor list [--release | --profile NAME]`: the headers in include.h and
+// the executable targets the selected profile's last build produced
+int cmd_list(int argc, char *argv[]) {
+  struct build_options opts;
+  init_build_options(&opts);
+  for (int i = 1; i < argc; i++) {
+    int parsed = parse_build_option(argc, argv, &i, &opts);
+    if (parsed < 0) {
+      return 1;
+    }
+    if (parsed == 0) {
+      fprintf(stderr, "❌ Error: Unknown list option '%s'\n", argv[i]);
+      fprintf(stderr, "   Usage: sbor list [--release | --profile NAME]\n");
+      return 1;
+    }
+  }
+
+  if (!file_exists("CMakeLists.txt") || !file_exists("sbor.conf")) {
+    fprintf(stderr, "❌ Error: Not in a valid sbor project directory.\n");
+    fprintf(stderr, "   Make sure you're in a directory created with 'sbor init'\n");
+    return 1;
+  }
+
+  struct project_config config;
+  struct build_profile profile;
+  if (load_project_config(&config) != 0) {
+    fprintf(stderr, "❌ Error: Could not load the project configuration from sbor.conf.\n");
+    return 1;
+  }
+  if (load_build_profile(&opts, &config, &profile) != 0) {
+    free_project_config(&config);
+    return 1;
+  }
+
+  printf("📋 %s\n\n", config.name);
+  print_headers("📚 System headers", "system");
+  print_headers("📝 Custom headers", "custom");
+
+  struct arg_list names, paths;
+  int count = load_targets(profile.directory, &names, &paths);
+  printf("🎯 Executable targets (%s):\n", profile.name);
+  if (count < 0) {
+    printf("   (not built yet)\n");
+  } else if (count == 0) {
+    printf("   (none)\n");
+  }
+  for (int i = 0; i < names.count; i++) {
+    printf("   %-20s %s%s\n", names.items[i], paths.items[i], file_exists(paths.items[i]) ? "" : " (missing)");
+  }
+
+  arg_list_free(&names);
+  arg_list_free(&paths);
+  free_build_profile(&profile);
+  free_project_config(&config);
+  return 0;
+}
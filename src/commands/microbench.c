@@ -0,0 +1,147 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../include/commands.h"
+
+// `sbor microbench [filter]`: build every benches/*.c as its own optimized
+// executable (release profile by default) and run them. Each benchmark file
+// uses benches/sbor_bench.h, which does the timing and prints ns/op and
+// throughput per function; `filter` selects functions by substring.
+
+static void print_microbench_usage(void) {
+  fprintf(stderr, "   Usage: sbor microbench [filter] [--profile NAME] [-j N]\n");
+}
+
+// Write benches/sbor_bench.h if the project does not have one yet
+static int ensure_harness(void) {
+  if (file_exists("benches/sbor_bench.h")) {
+    return 0;
+  }
+  char *content = generate_bench_header_template();
+  int result = create_file_with_content("benches/sbor_bench.h", content);
+  free(content);
+  if (result == 0) {
+    printf("📝 Created benches/sbor_bench.h\n");
+  }
+  return result;
+}
+
+// CMake projects need the SBOR_BENCHES block of the current template
+static int cmake_supports_benches(void) {
+  char *backend = get_config_value("build", "backend");
+  int native = backend && strcmp(backend, "native") == 0;
+  free(backend);
+  if (native) {
+    return 1;
+  }
+
+  char *cmake = read_file_contents("CMakeLists.txt");
+  int supported = cmake && strstr(cmake, "SBOR_BENCHES") != NULL;
+  free(cmake);
+  if (!supported) {
+    fprintf(stderr, "❌ Error: CMakeLists.txt has no SBOR_BENCHES block.\n");
+    fprintf(stderr, "   Copy it from a project created with 'sbor init', or set\n");
+    fprintf(stderr, "   \"backend\": \"native\" in the build section of sbor.conf.\n");
+  }
+  return supported;
+}
+
+int cmd_microbench(int argc, char *argv[]) {
+  struct build_options build_opts;
+  init_build_options(&build_opts);
+  build_opts.profile = "release";
+  build_opts.benches = 1;
+  const char *filter = NULL;
+
+  for (int i = 1; i < argc; i++) {
+    int parsed = parse_build_option(argc, argv, &i, &build_opts);
+    if (parsed < 0) {
+      return 1;
+    }
+    if (parsed == 0) {
+      if (argv[i][0] == '-' || filter) {
+        fprintf(stderr, "❌ Error: Unexpected argument '%s'\n", argv[i]);
+        print_microbench_usage();
+        return 1;
+      }
+      filter = argv[i];
+    }
+  }
+
+  struct arg_list sources;
+  arg_list_init(&sources);
+  list_files_recursive("benches", ".c", &sources);
+  if (sources.count == 0) {
+    fprintf(stderr, "❌ Error: No benchmarks found in benches/.\n");
+    fprintf(stderr, "   Create benches/<name>.c using benches/sbor_bench.h,\n");
+    fprintf(stderr, "   or start a project with: sbor init <name> --bench\n");
+    arg_list_free(&sources);
+    return 1;
+  }
+
+  if (ensure_harness() != 0 || !cmake_supports_benches()) {
+    arg_list_free(&sources);
+    return 1;
+  }
+
+  int result = build_project(&build_opts);
+  if (result != 0) {
+    fprintf(stderr, "❌ Build failed! Cannot run the benchmarks.\n");
+    arg_list_free(&sources);
+    return result;
+  }
+
+  struct project_config config;
+  struct build_profile profile;
+  if (load_project_config(&config) != 0) {
+    arg_list_free(&sources);
+    return 1;
+  }
+  if (load_build_profile(&build_opts, &config, &profile) != 0) {
+    free_project_config(&config);
+    arg_list_free(&sources);
+    return 1;
+  }
+
+  printf("\n🔬 Running micro-benchmarks (%s profile%s%s)\n", profile.name,
+         filter ? ", filter: " : "", filter ? filter : "");
+
+  int ran = 0;
+  for (int i = 0; i < sources.count && result == 0; i++) {
+    const char *name = sources.items[i] + strlen("benches/");
+    if (strchr(name, '/')) {
+      continue;  // Only benches/*.c
+    }
+
+    char directory[1100], stem[256];
+    snprintf(directory, sizeof(directory), "%s/benches", profile.directory);
+    snprintf(stem, sizeof(stem), "%.*s", (int)(strlen(name) - 2), name);
+    char *exe_path = find_executable(directory, stem);
+    if (!exe_path) {
+      fprintf(stderr, "❌ Error: Could not find the executable for %s in %s/\n", sources.items[i], directory);
+      result = 1;
+      break;
+    }
+
+    printf("\n📄 %s\n", sources.items[i]);
+    fflush(stdout);
+    char *command[] = { exe_path, (char *)filter, NULL };
+    int exit_code = run_process(command);
+    if (exit_code != 0) {
+      fprintf(stderr, "❌ Error: %s failed (exit code: %d)\n", exe_path, exit_code);
+      result = 1;
+    }
+    free(exe_path);
+    ran++;
+  }
+
+  if (result == 0) {
+    printf("\n✅ Ran %d benchmark file%s\n", ran, ran == 1 ? "" : "s");
+  }
+
+  free_build_profile(&profile);
+  free_project_config(&config);
+  arg_list_free(&sources);
+  return result;
+}
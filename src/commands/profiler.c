@@ -0,0 +1,317 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../include/commands.h"
+
+// `sbor profile`: build the profiling profile (optimized, with frame
+// pointers and symbols), sample the program while it runs, and write
+// <profile dir>/profile/stacks.folded and flamegraph.svg plus a table of the
+// hottest functions.
+//
+// Samples come from `perf record -g` when perf is installed and allowed to
+// run; otherwise from sbor's own SIGPROF sampler (Linux only). With --cache
+// the program runs under cachegrind instead (see cachegrind.c).
+//
+//   "profiler": { "hz": 999, "top": 20, "args": ["input.txt"] }
+
+static void print_profile_usage(void) {
+  fprintf(stderr, "   Usage: sbor profile [--hz N] [--top N] [--sampler | --cache] [--profile NAME] [-- args]\n");
+}
+
+static int config_int(const char *key, int fallback) {
+  char *value = get_config_value("profiler", key);
+  int result = value ? atoi(value) : fallback;
+  free(value);
+  return result;
+}
+
+// One perf script frame line: "<address> <symbol>+0x<offset> (<object>)"
+static void push_perf_frame(struct arg_list *frames, char *line) {
+  while (*line == ' ' || *line == '\t') line++;
+  char *symbol = strchr(line, ' ');
+  if (!symbol) {
+    return;
+  }
+  while (*symbol == ' ') symbol++;
+  char *object = strstr(symbol, " (");
+  if (object) *object = '\0';
+  char *offset = strstr(symbol, "+0x");
+  if (offset) *offset = '\0';
+  arg_list_push(frames, *symbol ? symbol : "[unknown]");
+}
+
+// Sample with perf. Returns the number of samples, or -1 if perf failed.
+// `perf record` exits with the program's status, so only a missing or
+// unreadable perf.data counts as perf failing; a program that exits nonzero
+// keeps its samples.
+static int profile_with_perf(const char *perf, const struct arg_list *command, const char *work_dir,
+                             int hz, struct arg_list *stacks) {
+  char perf_data[1200], frequency[32];
+  snprintf(perf_data, sizeof(perf_data), "%s/perf.data", work_dir);
+  snprintf(frequency, sizeof(frequency), "%d", hz);
+
+  struct arg_list record;
+  arg_list_init(&record);
+  arg_list_push(&record, perf);
+  arg_list_push(&record, "record");
+  arg_list_push(&record, "-q");
+  arg_list_push(&record, "-F");
+  arg_list_push(&record, frequency);
+  arg_list_push(&record, "-g");
+  arg_list_push(&record, "-o");
+  arg_list_push(&record, perf_data);
+  arg_list_push(&record, "--");
+  for (int i = 0; i < command->count; i++) {
+    arg_list_push(&record, command->items[i]);
+  }
+  remove(perf_data);
+  int exit_code = run_process(record.items);
+  arg_list_free(&record);
+  if (!file_exists(perf_data)) {
+    return -1;
+  }
+
+  char *script[] = { (char *)perf, "script", "-i", perf_data, "-F", "comm,ip,sym", NULL };
+  char *out = NULL, *err = NULL;
+  size_t out_length = 0, err_length = 0;
+  if (run_process_capture(script, &out, &out_length, &err, &err_length) != 0 || !out) {
+    free(out);
+    free(err);
+    return -1;
+  }
+  free(err);
+  if (exit_code != 0) {
+    printf("⚠️  Warning: %s exited with code %d\n", command->items[0], exit_code);
+  }
+
+  // Samples are a header line, then indented frames (leaf first), then a
+  // blank line
+  int samples = 0;
+  struct arg_list frames;
+  arg_list_init(&frames);
+  char *line = out;
+  while (line) {
+    char *next = strchr(line, '\n');
+    if (next) *next++ = '\0';
+    if (*line == ' ' || *line == '\t') {
+      push_perf_frame(&frames, line);
+    } else if (frames.count > 0) {
+      push_folded_stack(stacks, &frames);
+      samples++;
+      arg_list_free(&frames);
+      arg_list_init(&frames);
+    }
+    line = next;
+  }
+  if (frames.count > 0) {
+    push_folded_stack(stacks, &frames);
+    samples++;
+  }
+  arg_list_free(&frames);
+  free(out);
+  return samples;
+}
+
+// Sample with the preloaded SIGPROF sampler. Returns the number of
+// samples, or -1 if it could not run.
+static int profile_with_sampler(const struct project_config *config, const struct arg_list *command,
+                                const char *work_dir, int hz, struct arg_list *stacks) {
+#ifndef __linux__
+  (void)config;
+  (void)command;
+  (void)work_dir;
+  (void)hz;
+  (void)stacks;
+  fprintf(stderr, "❌ Error: The built-in sampler needs Linux; install perf to profile here.\n");
+  return -1;
+#else
+  char *library = build_sampler(config, work_dir);
+  if (!library) {
+    return -1;
+  }
+
+  char samples_path[1200], frequency[32];
+  snprintf(samples_path, sizeof(samples_path), "%s/samples.txt", work_dir);
+  snprintf(frequency, sizeof(frequency), "%d", hz);
+  remove(samples_path);
+
+  setenv("SBOR_PROFILE_OUT", samples_path, 1);
+  setenv("SBOR_PROFILE_HZ", frequency, 1);
+  int exit_code = run_preloaded(command->items, library);
+  unsetenv("SBOR_PROFILE_OUT");
+  unsetenv("SBOR_PROFILE_HZ");
+  free(library);
+
+  if (exit_code != 0) {
+    printf("⚠️  Warning: %s exited with code %d\n", command->items[0], exit_code);
+  }
+  int samples = symbolize_samples(samples_path, command->items[0], stacks);
+  if (samples < 0) {
+    fprintf(stderr, "❌ Error: The sampler wrote no samples (the program must exit normally).\n");
+  }
+  return samples;
+#endif
+}
+
+int cmd_profile(int argc, char *argv[]) {
+  struct build_options build_opts;
+  init_build_options(&build_opts);
+  build_opts.profile = "profiling";
+
+  int hz = config_int("hz", 999);
+  int top = config_int("top", 20);
+  int force_sampler = 0;
+  int cache = 0;
+
+  struct arg_list args;
+  arg_list_init(&args);
+  int passthrough = 0;
+
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    int has_value = i + 1 < argc;
+    if (passthrough) {
+      arg_list_push(&args, arg);
+    } else if (strcmp(arg, "--") == 0) {
+      passthrough = 1;
+    } else if (strcmp(arg, "--hz") == 0 && has_value) {
+      hz = atoi(argv[++i]);
+    } else if (strcmp(arg, "--top") == 0 && has_value) {
+      top = atoi(argv[++i]);
+    } else if (strcmp(arg, "--sampler") == 0) {
+      force_sampler = 1;
+    } else if (strcmp(arg, "--cache") == 0) {
+      cache = 1;
+    } else {
+      int parsed = parse_build_option(argc, argv, &i, &build_opts);
+      if (parsed < 0) {
+        arg_list_free(&args);
+        return 1;
+      }
+      if (parsed == 0) {
+        fprintf(stderr, "❌ Error: Unknown option '%s'\n", arg);
+        print_profile_usage();
+        arg_list_free(&args);
+        return 1;
+      }
+    }
+  }
+
+  if (hz < 1 || hz > 10000 || top < 1) {
+    fprintf(stderr, "❌ Error: --hz must be between 1 and 10000, --top at least 1.\n");
+    arg_list_free(&args);
+    return 1;
+  }
+  if (!passthrough) {
+    get_config_list("profiler", "args", &args);
+  }
+
+  int result = build_project(&build_opts);
+  if (result != 0) {
+    fprintf(stderr, "❌ Build failed! Cannot profile the program.\n");
+    arg_list_free(&args);
+    return result;
+  }
+
+  struct project_config config;
+  struct build_profile profile;
+  if (load_project_config(&config) != 0) {
+    arg_list_free(&args);
+    return 1;
+  }
+  if (load_build_profile(&build_opts, &config, &profile) != 0) {
+    free_project_config(&config);
+    arg_list_free(&args);
+    return 1;
+  }
+
+  char *exe_path = find_executable(profile.directory, config.name);
+  if (!exe_path) {
+    fprintf(stderr, "❌ Error: Could not find the executable to profile.\n");
+    free_build_profile(&profile);
+    free_project_config(&config);
+    arg_list_free(&args);
+    return 1;
+  }
+
+  char work_dir[1100];
+  snprintf(work_dir, sizeof(work_dir), "%s/profile", profile.directory);
+  make_directories(work_dir);
+
+  struct arg_list command;
+  arg_list_init(&command);
+  arg_list_push(&command, exe_path);
+  for (int i = 0; i < args.count; i++) {
+    arg_list_push(&command, args.items[i]);
+  }
+
+  if (cache) {
+    char cachegrind_dir[1100];
+    snprintf(cachegrind_dir, sizeof(cachegrind_dir), "%s/cachegrind", profile.directory);
+    printf("\n🧮 Simulating caches for %s with cachegrind\n\n", exe_path);
+    result = run_cachegrind(command.items, cachegrind_dir, top) < 0 ? 1 : 0;
+    arg_list_free(&command);
+    free(exe_path);
+    free_build_profile(&profile);
+    free_project_config(&config);
+    arg_list_free(&args);
+    return result;
+  }
+
+  char *perf = NULL;
+  if (!force_sampler) {
+    const char *env = getenv("PERF");
+    perf = env && *env ? strdup(env) : find_program("perf");
+  }
+
+  printf("\n🔥 Profiling %s", exe_path);
+  for (int i = 0; i < args.count; i++) {
+    printf(" %s", args.items[i]);
+  }
+  printf("\n   Sampling at %d Hz with %s\n\n", hz, perf ? "perf" : "the built-in sampler");
+  fflush(stdout);
+
+  struct arg_list stacks;
+  arg_list_init(&stacks);
+  int samples = -1;
+  if (perf) {
+    samples = profile_with_perf(perf, &command, work_dir, hz, &stacks);
+    if (samples < 0) {
+      printf("\n⚠️  Warning: perf record failed (see kernel.perf_event_paranoid), "
+             "using the built-in sampler.\n\n");
+      fflush(stdout);
+    }
+  }
+  if (samples < 0) {
+    samples = profile_with_sampler(&config, &command, work_dir, hz, &stacks);
+  }
+
+  char folded_path[1200], svg_path[1200], title[1200];
+  snprintf(folded_path, sizeof(folded_path), "%s/stacks.folded", work_dir);
+  snprintf(svg_path, sizeof(svg_path), "%s/flamegraph.svg", work_dir);
+  snprintf(title, sizeof(title), "%s (%d samples at %d Hz)", config.name, samples, hz);
+
+  if (samples < 0) {
+    result = 1;
+  } else if (samples == 0) {
+    fprintf(stderr, "❌ Error: No samples collected; the program ran too briefly to profile.\n");
+    result = 1;
+  } else if (write_folded_stacks(&stacks, folded_path) != 0 ||
+             write_flamegraph(folded_path, svg_path, title) != 0) {
+    result = 1;
+  } else {
+    print_hot_functions(folded_path, top);
+    printf("\n📍 Folded stacks: ./%s\n", folded_path);
+    printf("📍 Flame graph:   ./%s\n", svg_path);
+  }
+
+  arg_list_free(&stacks);
+  arg_list_free(&command);
+  free(perf);
+  free(exe_path);
+  free_build_profile(&profile);
+  free_project_config(&config);
+  arg_list_free(&args);
+  return result;
+}
@@ -4,69 +4,126 @@
 #include <unistd.h>
 #include <dirent.h>
 #include <sys/stat.h>
+#include <fcntl.h>
 
 // Cross-platform directory and execution
 #ifdef _WIN32
   #include <direct.h>
   #define chdir _chdir                    
-  #define PATH_SEPARATOR "\\"             
   #define EXE_EXTENSION ".exe"
+  #define NULL_DEVICE "NUL"
 #else
   #include <sys/types.h>
-  #define PATH_SEPARATOR "/"               
   #define EXE_EXTENSION ""
+  #define NULL_DEVICE "/dev/null"
 #endif
 
 #include "../include/commands.h"
 
-// Reuse the build function
-extern int cmd_build(int argc, char *argv[]);
+// Helper function to find the executable in the profile's build directory.
+// Looks `name` up in the target list the last build recorded (see
+// targets.c), then tries <directory>/<name>. A project with a single
+// executable of another name gets that one.
+char* find_executable(const char *directory, const char *name) {
+    char *target = find_target(directory, name);
+    if (target) {
+        return target;
+    }
 
-// Helper function to find the executable in build directory
-char* find_executable() {
-    DIR *dir = opendir("build");
-    if (!dir) {
-        return NULL;
+    char expected[1024];
+    snprintf(expected, sizeof(expected), "%s/%s%s", directory, name, EXE_EXTENSION);
+    if (file_exists(expected)) {
+        return strdup(expected);
     }
-    
-    struct dirent *entry;
-    char *exe_path = NULL;
-    
-    while ((entry = readdir(dir)) != NULL) {
-        // Skip . and .. and CMake files
-        if (strcmp(entry->d_name, ".") == 0 || 
-            strcmp(entry->d_name, "..") == 0 ||
-            strstr(entry->d_name, "CMake") != NULL ||
-            strstr(entry->d_name, "Makefile") != NULL ||
-            strcmp(entry->d_name, "cmake_install.cmake") == 0) {
-            continue;
+
+    struct arg_list names, paths;
+    char *only = NULL;
+    if (load_targets(directory, &names, &paths) == 1) {
+        only = strdup(paths.items[0]);
+    }
+    arg_list_free(&names);
+    arg_list_free(&paths);
+    return only;
+}
+
+// The executable `sbor run` starts: the --bin target if one was named,
+// otherwise the project's own binary. Prints why when there is none.
+static char* resolve_executable(const char *directory, const char *name, const char *bin, int report) {
+    char *exe_path = bin ? find_target(directory, bin) : find_executable(directory, name);
+    if (exe_path || !report) {
+        return exe_path;
+    }
+
+    struct arg_list names, paths;
+    int count = load_targets(directory, &names, &paths);
+    if (bin) {
+        fprintf(stderr, "❌ Error: No executable target named '%s'.\n", bin);
+    } else {
+        fprintf(stderr, "❌ Error: Could not find executable in build directory.\n");
+        fprintf(stderr, "   Expected executable location: %s/%s%s\n", directory, name, EXE_EXTENSION);
+    }
+    if (count > 0) {
+        fprintf(stderr, "   Available targets:");
+        for (int i = 0; i < names.count; i++) {
+            fprintf(stderr, " %s", names.items[i]);
         }
-        
-        // Check if it's a regular file (not a directory)
-        char full_path[512];
-        snprintf(full_path, sizeof(full_path), "build/%s", entry->d_name);
-        
-        struct stat file_stat;
-        if (stat(full_path, &file_stat) == 0 && S_ISREG(file_stat.st_mode)) {
-            // On Unix systems, check if it's executable
-            #ifndef _WIN32
-            if (file_stat.st_mode & S_IXUSR) {
-            #endif
-                exe_path = malloc(strlen(full_path) + 1);
-                strcpy(exe_path, full_path);
-                break;  // Don't print here - let caller decide
-            #ifndef _WIN32
-            }
-            #endif
+        fprintf(stderr, "\n");
+        if (!bin) {
+            fprintf(stderr, "   Pick one with 'sbor run --bin <name>'.\n");
         }
+    } else {
+        fprintf(stderr, "   Make sure the build was successful.\n");
     }
-    
-    closedir(dir);
-    return exe_path;
+    arg_list_free(&names);
+    arg_list_free(&paths);
+    return NULL;
+}
+
+// sbor daemon splits a run in two: the daemon's job builds and finds the
+// executable, then hands its path over, and the client starts the program
+// itself, in the terminal's foreground (see daemon.c)
+static int handoff_fd = -1;
+static const char *prebuilt_exe = NULL;
+
+void run_hand_off(int fd) {
+    handoff_fd = fd;
+}
+
+void run_prebuilt(const char *exe_path) {
+    prebuilt_exe = exe_path;
 }
 
-// Execute the binary with enhanced visual formatting
-int execute_binary_verbose(const char *exe_path, int argc, char *argv[]) {
+// Options that need the build to run even when its output is current
+int build_can_be_skipped(const struct build_options *opts) {
+    return !opts->reconfigure && !opts->pgo && !opts->bolt && !opts->timings &&
+           !opts->unity && !opts->json_messages;
+}
+
+// The program's argument vector: the executable followed by its arguments
+static void program_command(const char *exe_path, int argc, char *argv[], struct arg_list *command) {
+    arg_list_init(command);
+    arg_list_push(command, exe_path);
+    for (int i = 0; i < argc; i++) {
+        arg_list_push(command, argv[i]);
+    }
+}
+
+// Run the binary under hardware performance counters. It is exec'd directly
+// rather than through a shell, so the counters see only the program.
+static int execute_binary_counted(const char *exe_path, int argc, char *argv[],
+                                  const char *counters, struct counter_run **run) {
+    struct arg_list command;
+    program_command(exe_path, argc, argv, &command);
+    int exit_code = run_with_counters(command.items, counters, run);
+    arg_list_free(&command);
+    return exit_code;
+}
+
+// Execute the binary with enhanced visual formatting.
+// `counters` is a --counters list ("" for the default set), or NULL.
+// A signal that killed the program is stored in *signal_number.
+int execute_binary_verbose(const char *exe_path, int argc, char *argv[], const char *counters,
+                           int *signal_number) {
     printf("🎯 Found executable: %s\n", exe_path);
     printf("🚀 Running: %s", exe_path);
 
@@ -79,38 +136,37 @@ int execute_binary_verbose(const char *exe_path, int argc, char *argv[]) {
     }
     printf("\n\n");
 
-    // Build the command string
-    char command[1024];
-    snprintf(command, sizeof(command), ".%s%s", PATH_SEPARATOR, exe_path);
-
-    // Add arguments to command
-    for (int i = 0; i < argc; i++) {
-        strcat(command, " ");
-        strcat(command, argv[i]);
-    }
-
     // Enhanced visual separator
     printf("╔═══════════════════════════════════════════════════════════╗\n");
     printf("║                     PROGRAM OUTPUT                        ║\n");
     printf("╚═══════════════════════════════════════════════════════════╝\n");
     printf("\n");
 
-    // Execute the command
-    int result = system(command);
+    // Execute the program directly, without a shell in between
+    struct counter_run *counted = NULL;
+    int exit_code;
+    *signal_number = 0;
+    if (counters) {
+        exit_code = execute_binary_counted(exe_path, argc, argv, counters, &counted);
+    } else {
+        struct arg_list command;
+        program_command(exe_path, argc, argv, &command);
+        exit_code = run_foreground(command.items, signal_number);
+        arg_list_free(&command);
+    }
 
     printf("\n");
     printf("╔═══════════════════════════════════════════════════════════╗\n");
     printf("║                      END OUTPUT                           ║\n");
     printf("╚═══════════════════════════════════════════════════════════╝\n");
-
-    #ifdef _WIN32
-        int exit_code = result;
-    #else
-        int exit_code = WIFEXITED(result) ? WEXITSTATUS(result) : -1;
-    #endif
+    print_counter_run(counted);
 
     if (exit_code == 0) {
         printf("✅ Program completed successfully (exit code: %d)\n", exit_code);
+    } else if (*signal_number) {
+    #ifndef _WIN32
+        printf("❌ Program killed by signal %d (%s)\n", *signal_number, strsignal(*signal_number));
+    #endif
     } else {
         printf("❌ Program exited with error (exit code: %d)\n", exit_code);
     }
@@ -118,45 +174,81 @@ int execute_binary_verbose(const char *exe_path, int argc, char *argv[]) {
     return exit_code;
 }
 
-// Execute binary in quiet mode (minimal output)
+// Execute binary in quiet mode (minimal output). A program killed by a
+// signal returns 128 + the signal, as in the shell.
 int execute_binary_quiet(const char *exe_path, int argc, char *argv[]) {
-    // Build the command string
-    char command[1024];
-    snprintf(command, sizeof(command), ".%s%s", PATH_SEPARATOR, exe_path);
-
-    // Add arguments to command
-    for (int i = 0; i < argc; i++) {
-        strcat(command, " ");
-        strcat(command, argv[i]);
-    }
+    struct arg_list command;
+    program_command(exe_path, argc, argv, &command);
 
     // Just execute - no extra formatting
-    int result = system(command);
-
-    #ifdef _WIN32
-        return result;
-    #else
-        return WIFEXITED(result) ? WEXITSTATUS(result) : -1;
-    #endif
+    int signal_number;
+    int exit_code = run_foreground(command.items, &signal_number);
+    arg_list_free(&command);
+    return exit_code;
 }
 
 int cmd_run(int argc, char *argv[]) {
     // Check for quiet flag
     int quiet_mode = 0;
+    const char *counters = NULL;  // --counters[=list], "" for the default set
+    int cachegrind = 0;
+    int alloc = 0;
+    const char *bin = NULL;  // --bin NAME: run this target instead of the project's binary
+    struct build_options build_opts;
+    init_build_options(&build_opts);
     
-    // Parse flags and rebuild argv without flags
+    // Parse flags and rebuild argv without flags.
+    // Everything after "--" is passed to the program untouched.
     char *filtered_argv[argc];
     int filtered_argc = 0;
+    int passthrough = 0;
     
     for (int i = 1; i < argc; i++) {
-        if (strcmp(argv[i], "-q") == 0 || strcmp(argv[i], "--quiet") == 0) {
+        if (passthrough) {
+            filtered_argv[filtered_argc++] = argv[i];
+        } else if (strcmp(argv[i], "--") == 0) {
+            passthrough = 1;
+        } else if (strcmp(argv[i], "-q") == 0 || strcmp(argv[i], "--quiet") == 0) {
             quiet_mode = 1;
+        } else if (strcmp(argv[i], "--counters") == 0) {
+            counters = "";
+        } else if (strncmp(argv[i], "--counters=", 11) == 0) {
+            counters = argv[i] + 11;
+        } else if (strcmp(argv[i], "--cachegrind") == 0) {
+            cachegrind = 1;
+        } else if (strcmp(argv[i], "--alloc") == 0) {
+            alloc = 1;
+        } else if (strcmp(argv[i], "--bin") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "❌ Error: --bin requires a target name.\n");
+                return 1;
+            }
+            bin = argv[++i];
+        } else if (strncmp(argv[i], "--bin=", 6) == 0) {
+            bin = argv[i] + 6;
         } else {
-            filtered_argv[filtered_argc++] = argv[i];
+            int parsed = parse_build_option(argc, argv, &i, &build_opts);
+            if (parsed < 0) {
+                return 1;
+            }
+            if (parsed == 0) {
+                filtered_argv[filtered_argc++] = argv[i];
+            }
         }
     }
 
-    if (!quiet_mode) {
+    if (counters && validate_counter_list(counters) != 0) {
+        return 1;
+    }
+    if ((counters != NULL) + cachegrind + alloc > 1) {
+        fprintf(stderr, "❌ Error: Use only one of --counters, --cachegrind and --alloc.\n");
+        return 1;
+    }
+    if (build_opts.json_messages) {
+        events_start();
+    }
+
+    if (!quiet_mode && !prebuilt_exe) {
         printf("🏃 Building and running project...\n\n");
     }
 
@@ -170,51 +262,151 @@ int cmd_run(int argc, char *argv[]) {
         return 1;
     }
 
+    // The profile's build tree holds the target list and the executable
+    struct project_config config;
+    struct build_profile profile;
+    if (load_project_config(&config) != 0) {
+        fprintf(stderr, "❌ Error: Could not load the project configuration from sbor.conf.\n");
+        return 1;
+    }
+    if (load_build_profile(&build_opts, &config, &profile) != 0) {
+        free_project_config(&config);
+        return 1;
+    }
+
+    // When the executable is newer than everything it is built from, a
+    // build would do nothing: skip it, configure and make included
+    char *exe_path = prebuilt_exe ? strdup(prebuilt_exe) : NULL;
+    if (!exe_path && build_can_be_skipped(&build_opts)) {
+        exe_path = resolve_executable(profile.directory, config.name, bin, 0);
+        if (exe_path && !target_is_fresh(profile.directory, exe_path)) {
+            free(exe_path);
+            exe_path = NULL;
+        }
+    }
+
     // Build the project
-    if (!quiet_mode) {
+    int build_result = 0;
+    if (prebuilt_exe) {
+        // Built, or found current, by sbor daemon
+    } else if (exe_path) {
+        if (!quiet_mode) {
+            printf("⚡ %s is up to date, skipping the build.\n\n", exe_path);
+        }
+    } else if (!quiet_mode) {
         printf("📦 Building project...\n");
-        int build_result = cmd_build(0, NULL);
-        
-        if (build_result != 0) {
-            fprintf(stderr, "❌ Build failed! Cannot run the program.\n");
-            return build_result;
+        build_result = build_project(&build_opts);
+        if (build_result == 0) {
+            printf("\n");
         }
-        printf("\n");
     } else {
-        // In quiet mode, suppress build output
-        // Redirect stdout temporarily
-        FILE *original_stdout = stdout;
-        stdout = fopen("/dev/null", "w");
-        
-        int build_result = cmd_build(0, NULL);
-        
-        // Restore stdout
-        fclose(stdout);
-        stdout = original_stdout;
-        
-        if (build_result != 0) {
-            fprintf(stderr, "❌ Build failed! Cannot run the program.\n");
-            return build_result;
+        // In quiet mode, suppress build output. stdout is redirected at the
+        // descriptor so the compiler and make are silenced too; errors and
+        // warnings still reach stderr.
+        int saved_stdout = -1;
+        int null_device = open(NULL_DEVICE, O_WRONLY);
+        if (null_device >= 0) {
+            saved_stdout = redirect_stdout(null_device);
+            close(null_device);
         }
+
+        build_result = build_project(&build_opts);
+
+        restore_stdout(saved_stdout);
+    }
+    if (build_result != 0) {
+        fprintf(stderr, "❌ Build failed! Cannot run the program.\n");
+        free_build_profile(&profile);
+        free_project_config(&config);
+        return build_result;
     }
 
-    // Find the executable
-    char *exe_path = find_executable();
+    // Find the executable in the profile's build tree
     if (!exe_path) {
-        fprintf(stderr, "❌ Error: Could not find executable in build directory.\n");
-        fprintf(stderr, "   Expected executable location: build/<project_name>%s\n", EXE_EXTENSION);
-        fprintf(stderr, "   Make sure the build was successful.\n");
+        exe_path = resolve_executable(profile.directory, config.name, bin, 1);
+    }
+    if (!exe_path) {
+        free_build_profile(&profile);
+        free_project_config(&config);
+        return 1;
+    }
+    if (handoff_fd >= 0) {
+        size_t length = strlen(exe_path);
+        int handed_off = write(handoff_fd, exe_path, length) == (ssize_t)length;
+        free(exe_path);
+        free_build_profile(&profile);
+        free_project_config(&config);
+        return handed_off ? 0 : 1;
+    }
+
+    // With --message-format=json the program gets stdout back, between a
+    // run-started and a run-finished event, and runs without the banners
+    int plain = quiet_mode || build_opts.json_messages;
+    double run_started = timings_now();
+    if (events_enabled()) {
+        struct event event;
+        event_begin(&event, "run-started");
+        event_string(&event, "path", exe_path);
+        event_int(&event, "args", filtered_argc);
+        event_emit(&event);
+        events_release_stdout();
+    }
+
+    // Nothing is left to do after a plain quiet run, so sbor becomes the
+    // program: its exit code and signals are exactly what the caller sees
+    if (quiet_mode && !counters && !cachegrind && !alloc && !events_enabled()) {
+        struct arg_list command;
+        program_command(exe_path, filtered_argc, filtered_argv, &command);
+        exec_program(command.items);
+        arg_list_free(&command);
+        free(exe_path);
+        free_build_profile(&profile);
+        free_project_config(&config);
         return 1;
     }
 
     // Execute the binary based on mode
     int run_result;
-    if (quiet_mode) {
+    int signal_number = 0;
+    if (cachegrind || alloc) {
+        struct arg_list command;
+        program_command(exe_path, filtered_argc, filtered_argv, &command);
+        char work_dir[1100];
+        snprintf(work_dir, sizeof(work_dir), "%s/%s", profile.directory, cachegrind ? "cachegrind" : "alloc");
+        if (!quiet_mode) {
+            printf("%s %s\n\n", cachegrind ? "🧮 Running under cachegrind:" : "🧮 Counting allocations:", exe_path);
+        }
+        if (cachegrind) {
+            run_result = run_cachegrind(command.items, work_dir, 15);
+        } else {
+            run_result = run_with_alloc_profile(&config, command.items, work_dir, 15);
+        }
+        if (run_result < 0) {
+            run_result = 1;
+        }
+        arg_list_free(&command);
+    } else if (plain && counters) {
+        struct counter_run *counted = NULL;
+        run_result = execute_binary_counted(exe_path, filtered_argc, filtered_argv, counters, &counted);
+        print_counter_run(counted);
+    } else if (plain) {
         run_result = execute_binary_quiet(exe_path, filtered_argc, filtered_argv);
     } else {
-        run_result = execute_binary_verbose(exe_path, filtered_argc, filtered_argv);
+        run_result = execute_binary_verbose(exe_path, filtered_argc, filtered_argv, counters, &signal_number);
+    }
+
+    if (events_enabled()) {
+        struct event event;
+        event_begin(&event, "run-finished");
+        event_int(&event, "exit_code", run_result);
+        event_number(&event, "duration", timings_now() - run_started);
+        event_bool(&event, "success", run_result == 0);
+        event_emit(&event);
     }
 
     free(exe_path);
+    free_build_profile(&profile);
+    free_project_config(&config);
+    raise_signal(signal_number);
     return run_result;
 }
@@ -18,13 +18,6 @@
     return 0;
 }*/
 
-int cmd_list(int argc, char *argv[]) {
-    (void)argc;  // Suppress unused parameter warning
-    (void)argv;  // Suppress unused parameter warning
-    printf("🚧 list command not implemented yet\n");
-    return 0;
-}
-
 /*int cmd_build(int argc, char *argv[]) {
     (void)argc;  // Suppress unused parameter warning
     (void)argv;  // Suppress unused parameter warning
@@ -0,0 +1,292 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __linux__
+  #include <errno.h>
+  #include <fcntl.h>
+  #include <poll.h>
+  #include <signal.h>
+  #include <spawn.h>
+  #include <unistd.h>
+  #include <sys/wait.h>
+  extern char **environ;
+#endif
+
+#include "../include/commands.h"
+
+// `sbor watch [build|run] [options] [-- args]`: rebuild, and rerun, every
+// time a build input changes.
+//
+// Changes come from the inotify watcher (watcher.c). A burst of saves is
+// settled into one change, then `sbor build` or `sbor run` starts as a
+// child in its own process group. If another change arrives while it is
+// still working, the whole group (make, compilers, the program) is stopped
+// and the command starts over, so only the newest state of the tree is
+// ever built to the end. The builds themselves are incremental.
+//
+// The child reports through the build event stream (events.c): it inherits
+// a pipe as $SBOR_EVENTS_FD, and the time from the save to build-finished
+// (or run-started, when the build could be skipped) is printed as the
+// change's latency.
+
+#define SETTLE_MS 100
+
+static void print_watch_usage(void) {
+  fprintf(stderr, "   Usage: sbor watch [build|run] [build options] [-- args]\n");
+}
+
+#ifdef __linux__
+
+static volatile sig_atomic_t interrupted = 0;
+
+static void on_interrupt(int signal_number) {
+  (void)signal_number;
+  interrupted = 1;
+}
+
+// What the child reported so far about the current change
+struct watch_result {
+  int finished;       // Saw build-finished or run-started
+  int success;
+  int errors;
+  int warnings;
+  double finished_at;
+  char line[4096];    // Partial event line
+  size_t length;
+};
+
+// Take in one event line from the child
+static void read_event(struct watch_result *result, const char *line) {
+  const char *event = skip_json_space(line);
+  if (*event != '{') {
+    return;
+  }
+  char *reason = json_string_member(event, "reason");
+  if (!reason) {
+    return;
+  }
+  const char *value;
+  if (strcmp(reason, "compile-finished") == 0 || strcmp(reason, "link-finished") == 0) {
+    if (json_member(event, "errors", &value)) result->errors += atoi(value);
+    if (json_member(event, "warnings", &value)) result->warnings += atoi(value);
+  } else if (!result->finished &&
+             (strcmp(reason, "build-finished") == 0 || strcmp(reason, "run-started") == 0)) {
+    result->finished = 1;
+    result->finished_at = timings_now();
+    result->success = strcmp(reason, "run-started") == 0 ||
+                      (json_member(event, "success", &value) && strncmp(value, "true", 4) == 0);
+  }
+  free(reason);
+}
+
+// Drain the event pipe. Returns 0 once every process holding it has exited.
+static int read_events(int fd, struct watch_result *result) {
+  char chunk[4096];
+  ssize_t got = read(fd, chunk, sizeof(chunk));
+  if (got < 0) {
+    return errno == EINTR || errno == EAGAIN;
+  }
+  if (got == 0) {
+    return 0;
+  }
+  for (ssize_t i = 0; i < got; i++) {
+    if (chunk[i] == '\n') {
+      result->line[result->length] = '\0';
+      read_event(result, result->line);
+      result->length = 0;
+    } else if (result->length + 1 < sizeof(result->line)) {
+      result->line[result->length++] = chunk[i];
+    }
+  }
+  return 1;
+}
+
+// Start `sbor <command> <args>` in a new process group, reading /dev/null,
+// with the write end of `events` as its event stream
+static int start_child(char *const argv[], int events, pid_t *pid) {
+  char value[16];
+  snprintf(value, sizeof(value), "%d", events);
+  setenv("SBOR_EVENTS_FD", value, 1);
+
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+  posix_spawnattr_t attributes;
+  posix_spawnattr_init(&attributes);
+  posix_spawnattr_setpgroup(&attributes, 0);
+  posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETPGROUP);
+
+  fflush(stdout);
+  fflush(stderr);
+  int spawned = posix_spawn(pid, argv[0], &actions, &attributes, argv, environ);
+  posix_spawn_file_actions_destroy(&actions);
+  posix_spawnattr_destroy(&attributes);
+  unsetenv("SBOR_EVENTS_FD");
+  return spawned == 0 ? 0 : -1;
+}
+
+// Stop the child's whole process group and reap it. Anything that ignores
+// SIGTERM for a second is killed.
+static void stop_child(pid_t pid) {
+  kill(-pid, SIGTERM);
+  for (int waited = 0; waited < 100; waited++) {
+    if (waitpid(pid, NULL, WNOHANG) == pid) {
+      return;
+    }
+    usleep(10000);
+  }
+  kill(-pid, SIGKILL);
+  waitpid(pid, NULL, 0);
+}
+
+static void print_latency(const char *mode, const char *changed, double saved,
+                          const struct watch_result *result, int exit_code) {
+  double finished = result->finished ? result->finished_at : timings_now();
+  int success = result->finished ? result->success : exit_code == 0;
+  char detail[64] = "";
+  if (result->errors || result->warnings) {
+    snprintf(detail, sizeof(detail), " (%d error%s, %d warning%s)", result->errors,
+             result->errors == 1 ? "" : "s", result->warnings, result->warnings == 1 ? "" : "s");
+  }
+  const char *outcome = success ? (strcmp(mode, "run") == 0 ? "running" : "built") : "failed";
+  printf("\n⏱️  %s → %s in %.3fs%s\n", changed, outcome, finished - saved, detail);
+  fflush(stdout);
+}
+
+#endif
+
+int cmd_watch(int argc, char *argv[]) {
+#ifndef __linux__
+  (void)argc;
+  (void)argv;
+  fprintf(stderr, "❌ Error: sbor watch needs inotify and is only available on Linux.\n");
+  return 1;
+#else
+  const char *mode = "build";
+  int first = 1;
+  if (argc > 1 && (strcmp(argv[1], "build") == 0 || strcmp(argv[1], "run") == 0)) {
+    mode = argv[1];
+    first = 2;
+  } else if (argc > 1 && argv[1][0] != '-') {
+    fprintf(stderr, "❌ Error: Unknown watch command '%s'\n", argv[1]);
+    print_watch_usage();
+    return 1;
+  }
+
+  if (!is_valid_sbor_project()) {
+    fprintf(stderr, "❌ Error: Not in a valid sbor project directory.\n");
+    fprintf(stderr, "   Run 'sbor init <project_name>' to create a new project.\n");
+    return 1;
+  }
+
+  char *self = get_self_executable();
+  struct file_watcher *watcher = self ? watcher_open() : NULL;
+  if (!watcher) {
+    fprintf(stderr, "❌ Error: Could not start watching the project.\n");
+    free(self);
+    return 1;
+  }
+
+  // `sbor <mode> <options> [-- args]`, options checked by the command itself
+  struct arg_list command;
+  arg_list_init(&command);
+  arg_list_push(&command, self);
+  arg_list_push(&command, mode);
+  for (int i = first; i < argc; i++) {
+    arg_list_push(&command, argv[i]);
+  }
+
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = on_interrupt;
+  sigemptyset(&action.sa_mask);
+  sigaction(SIGINT, &action, NULL);
+  sigaction(SIGTERM, &action, NULL);
+
+  printf("👀 Watching src/, sbor.conf and CMakeLists.txt (sbor %s, Ctrl-C to stop)\n\n", mode);
+
+  // The first pass runs right away, as if everything had just been saved
+  char changed[1024] = "start";
+  double saved = timings_now();
+  int exit_code = 0;
+  while (!interrupted) {
+    int events[2];
+    pid_t pid;
+    if (pipe(events) != 0) {
+      break;
+    }
+    fcntl(events[0], F_SETFD, FD_CLOEXEC);
+    int started = start_child(command.items, events[1], &pid);
+    close(events[1]);
+    if (started != 0) {
+      fprintf(stderr, "❌ Error: Failed to start '%s %s'\n", self, mode);
+      close(events[0]);
+      exit_code = 1;
+      break;
+    }
+
+    // Wait for the child to finish or for the next change, whichever is first
+    struct watch_result result;
+    memset(&result, 0, sizeof(result));
+    int reported = 0;
+    int cancelled = 0;
+    int child_open = 1;
+    while (!interrupted) {
+      struct pollfd fds[2] = {
+        { watcher_fd(watcher), POLLIN, 0 },
+        { events[0], POLLIN, 0 },
+      };
+      if (poll(fds, child_open ? 2 : 1, -1) < 0) {
+        continue;
+      }
+      if (child_open && (fds[1].revents & (POLLIN | POLLHUP))) {
+        child_open = read_events(events[0], &result);
+        if (result.finished && !reported) {
+          print_latency(mode, changed, saved, &result, 0);
+          reported = 1;
+        }
+        if (!child_open) {
+          // Everything the child started has exited
+          int status = 0;
+          waitpid(pid, &status, 0);
+          if (!reported) {
+            print_latency(mode, changed, saved, &result, process_exit_code(status));
+          }
+          printf("\n👀 Waiting for changes...\n");
+          fflush(stdout);
+        }
+      }
+      if ((fds[0].revents & POLLIN) && watcher_read(watcher, changed, sizeof(changed)) > 0) {
+        saved = timings_now();
+        if (child_open) {
+          printf("\n🔁 %s changed, restarting sbor %s...\n", changed, mode);
+          fflush(stdout);
+          stop_child(pid);
+          cancelled = 1;
+        }
+        break;
+      }
+    }
+    close(events[0]);
+    if (interrupted) {
+      if (child_open && !cancelled) {
+        stop_child(pid);
+      }
+      break;
+    }
+
+    watcher_settle(watcher, SETTLE_MS);
+    if (!cancelled) {
+      printf("\n🔁 %s changed\n", changed);
+    }
+    printf("\n");
+  }
+
+  printf("\n👋 Stopped watching.\n");
+  arg_list_free(&command);
+  watcher_close(watcher);
+  free(self);
+  return exit_code;
+#endif
+}
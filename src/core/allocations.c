@@ -0,0 +1,552 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../include/commands.h"
+
+// Allocation profiling for `sbor run --alloc`. The malloc shim below is
+// compiled into <profile dir>/alloc/alloc.so (see preload.c) and preloaded
+// into the program. When the program exits it writes its counts to
+// <profile dir>/alloc/alloc.txt, which is summarized here: calls per
+// function, bytes, the live heap's high-water mark, a size histogram and
+// the busiest call sites.
+
+#define BUCKETS 32
+
+#ifdef __linux__
+
+static const char *const alloc_source[] = {
+    "// Generated by sbor: allocation profiler, loaded with LD_PRELOAD by\n",
+    "// `sbor run --alloc`.\n",
+    "//\n",
+    "// Wraps malloc, calloc, realloc, free and the aligned allocators, and counts\n",
+    "// calls, bytes and allocation sizes per call site. Each thread counts into\n",
+    "// its own table, so threads never share a lock or a hot cache line; only the\n",
+    "// live heap size (for the high-water mark) is a shared atomic. At exit the\n",
+    "// tables are merged into $SBOR_ALLOC_OUT. Requires glibc (__libc_malloc).\n",
+    "#define _GNU_SOURCE\n",
+    "#include <dlfcn.h>\n",
+    "#include <execinfo.h>\n",
+    "#include <fcntl.h>\n",
+    "#include <link.h>\n",
+    "#include <malloc.h>\n",
+    "#include <stdarg.h>\n",
+    "#include <stdint.h>\n",
+    "#include <stdio.h>\n",
+    "#include <stdlib.h>\n",
+    "#include <string.h>\n",
+    "#include <sys/mman.h>\n",
+    "#include <unistd.h>\n",
+    "\n",
+    "extern void *__libc_malloc(size_t size);\n",
+    "extern void *__libc_calloc(size_t count, size_t size);\n",
+    "extern void *__libc_realloc(void *pointer, size_t size);\n",
+    "extern void __libc_free(void *pointer);\n",
+    "extern void *__libc_memalign(size_t alignment, size_t size);\n",
+    "\n",
+    "#define BUCKETS 32       // Size classes: [0, 2), [2, 4), [4, 8), ...\n",
+    "#define SITES 4096       // Call sites per thread, a power of two\n",
+    "\n",
+    "enum { CALL_MALLOC, CALL_CALLOC, CALL_REALLOC, CALL_FREE, CALL_ALIGNED, CALLS };\n",
+    "\n",
+    "struct site {\n",
+    "  uintptr_t address;     // Return address into the caller, 0 = unused\n",
+    "  uint64_t calls;\n",
+    "  uint64_t bytes;\n",
+    "  uint64_t sizes[BUCKETS];\n",
+    "};\n",
+    "\n",
+    "struct thread_stats {\n",
+    "  struct thread_stats *next;\n",
+    "  uint64_t calls[CALLS];\n",
+    "  uint64_t allocated;    // Bytes requested\n",
+    "  uint64_t freed_blocks;\n",
+    "  uint64_t sizes[BUCKETS];\n",
+    "  uint64_t lost_sites;   // Allocations whose site did not fit in the table\n",
+    "  struct site sites[SITES];\n",
+    "};\n",
+    "\n",
+    "static struct thread_stats *all_threads;\n",
+    "static __thread struct thread_stats *stats __attribute__((tls_model(\"initial-exec\")));\n",
+    "static __thread int busy __attribute__((tls_model(\"initial-exec\")));\n",
+    "static int64_t live_bytes, live_blocks, peak_bytes;\n",
+    "static int active, reporting;\n",
+    "static char output_path[4096];\n",
+    "\n",
+    "static struct thread_stats* thread_stats(void) {\n",
+    "  if (!stats) {\n",
+    "    // mmap, not malloc: this runs inside the allocator\n",
+    "    void *memory = mmap(NULL, sizeof(struct thread_stats), PROT_READ | PROT_WRITE,\n",
+    "                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);\n",
+    "    if (memory == MAP_FAILED) {\n",
+    "      return NULL;\n",
+    "    }\n",
+    "    struct thread_stats *created = memory;\n",
+    "    created->next = __atomic_load_n(&all_threads, __ATOMIC_ACQUIRE);\n",
+    "    while (!__atomic_compare_exchange_n(&all_threads, &created->next, created, 1,\n",
+    "                                        __ATOMIC_RELEASE, __ATOMIC_ACQUIRE)) {\n",
+    "    }\n",
+    "    stats = created;\n",
+    "  }\n",
+    "  return stats;\n",
+    "}\n",
+    "\n",
+    "static int bucket_of(size_t size) {\n",
+    "  int bucket = 0;\n",
+    "  while (size > 1 && bucket < BUCKETS - 1) {\n",
+    "    size >>= 1;\n",
+    "    bucket++;\n",
+    "  }\n",
+    "  return bucket;\n",
+    "}\n",
+    "\n",
+    "static void track_live(int64_t bytes, int64_t blocks) {\n",
+    "  int64_t now = __atomic_add_fetch(&live_bytes, bytes, __ATOMIC_RELAXED) ;\n",
+    "  __atomic_add_fetch(&live_blocks, blocks, __ATOMIC_RELAXED);\n",
+    "  int64_t peak = __atomic_load_n(&peak_bytes, __ATOMIC_RELAXED);\n",
+    "  while (now > peak && !__atomic_compare_exchange_n(&peak_bytes, &peak, now, 1,\n",
+    "                                                    __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {\n",
+    "  }\n",
+    "}\n",
+    "\n",
+    "// Count an allocation of `size` bytes from `site`\n",
+    "static void record(int call, size_t size, uintptr_t site) {\n",
+    "  struct thread_stats *self = thread_stats();\n",
+    "  if (!self) {\n",
+    "    return;\n",
+    "  }\n",
+    "  int bucket = bucket_of(size);\n",
+    "  self->calls[call]++;\n",
+    "  self->allocated += size;\n",
+    "  self->sizes[bucket]++;\n",
+    "\n",
+    "  unsigned index = (unsigned)((site >> 4) * 2654435761u) & (SITES - 1);\n",
+    "  for (int probe = 0; probe < 16; probe++, index = (index + 1) & (SITES - 1)) {\n",
+    "    struct site *slot = &self->sites[index];\n",
+    "    if (slot->address == 0) {\n",
+    "      slot->address = site;\n",
+    "    }\n",
+    "    if (slot->address == site) {\n",
+    "      slot->calls++;\n",
+    "      slot->bytes += size;\n",
+    "      slot->sizes[bucket]++;\n",
+    "      return;\n",
+    "    }\n",
+    "  }\n",
+    "  self->lost_sites++;\n",
+    "}\n",
+    "\n",
+    "// The allocating code: the return address of the wrapper's caller\n",
+    "__attribute__((noinline)) static uintptr_t call_site(void) {\n",
+    "  void *frames[3];\n",
+    "  if (busy) {\n",
+    "    return 0;\n",
+    "  }\n",
+    "  busy = 1;\n",
+    "  int depth = backtrace(frames, 3);\n",
+    "  busy = 0;\n",
+    "  // frames[0] is call_site, frames[1] the wrapper, frames[2] its caller\n",
+    "  return depth >= 3 ? (uintptr_t)frames[2] : 0;\n",
+    "}\n",
+    "\n",
+    "#define SHOULD_COUNT() (active && !reporting && !busy)\n",
+    "\n",
+    "void *malloc(size_t size) {\n",
+    "  void *pointer = __libc_malloc(size);\n",
+    "  if (pointer && SHOULD_COUNT()) {\n",
+    "    record(CALL_MALLOC, size, call_site());\n",
+    "    track_live((int64_t)malloc_usable_size(pointer), 1);\n",
+    "  }\n",
+    "  return pointer;\n",
+    "}\n",
+    "\n",
+    "void *calloc(size_t count, size_t size) {\n",
+    "  void *pointer = __libc_calloc(count, size);\n",
+    "  if (pointer && SHOULD_COUNT()) {\n",
+    "    record(CALL_CALLOC, count * size, call_site());\n",
+    "    track_live((int64_t)malloc_usable_size(pointer), 1);\n",
+    "  }\n",
+    "  return pointer;\n",
+    "}\n",
+    "\n",
+    "void *realloc(void *old, size_t size) {\n",
+    "  size_t old_size = old ? malloc_usable_size(old) : 0;\n",
+    "  void *pointer = __libc_realloc(old, size);\n",
+    "  if (SHOULD_COUNT() && (pointer || size == 0)) {\n",
+    "    record(CALL_REALLOC, size, call_site());\n",
+    "    size_t new_size = pointer ? malloc_usable_size(pointer) : 0;\n",
+    "    track_live((int64_t)new_size - (int64_t)old_size, (pointer != NULL) - (old != NULL));\n",
+    "  }\n",
+    "  return pointer;\n",
+    "}\n",
+    "\n",
+    "void free(void *pointer) {\n",
+    "  if (pointer && SHOULD_COUNT()) {\n",
+    "    struct thread_stats *self = thread_stats();\n",
+    "    if (self) {\n",
+    "      self->calls[CALL_FREE]++;\n",
+    "    }\n",
+    "    track_live(-(int64_t)malloc_usable_size(pointer), -1);\n",
+    "  }\n",
+    "  __libc_free(pointer);\n",
+    "}\n",
+    "\n",
+    "static void *aligned(size_t alignment, size_t size) {\n",
+    "  void *pointer = __libc_memalign(alignment, size);\n",
+    "  if (pointer && SHOULD_COUNT()) {\n",
+    "    record(CALL_ALIGNED, size, call_site());\n",
+    "    track_live((int64_t)malloc_usable_size(pointer), 1);\n",
+    "  }\n",
+    "  return pointer;\n",
+    "}\n",
+    "\n",
+    "int posix_memalign(void **result, size_t alignment, size_t size) {\n",
+    "  void *pointer = aligned(alignment, size);\n",
+    "  if (!pointer) {\n",
+    "    return 12;  // ENOMEM\n",
+    "  }\n",
+    "  *result = pointer;\n",
+    "  return 0;\n",
+    "}\n",
+    "\n",
+    "void *aligned_alloc(size_t alignment, size_t size) {\n",
+    "  return aligned(alignment, size);\n",
+    "}\n",
+    "\n",
+    "void *memalign(size_t alignment, size_t size) {\n",
+    "  return aligned(alignment, size);\n",
+    "}\n",
+    "\n",
+    "// Buffered output without stdio, which would allocate\n",
+    "static char buffer[1 << 16];\n",
+    "static size_t buffered;\n",
+    "static int output = -1;\n",
+    "\n",
+    "static void flush_output(void) {\n",
+    "  size_t written = 0;\n",
+    "  while (written < buffered) {\n",
+    "    ssize_t result = write(output, buffer + written, buffered - written);\n",
+    "    if (result <= 0) break;\n",
+    "    written += (size_t)result;\n",
+    "  }\n",
+    "  buffered = 0;\n",
+    "}\n",
+    "\n",
+    "static void emit(const char *format, ...) {\n",
+    "  if (buffered > sizeof(buffer) - 1024) {\n",
+    "    flush_output();\n",
+    "  }\n",
+    "  va_list args;\n",
+    "  va_start(args, format);\n",
+    "  int length = vsnprintf(buffer + buffered, sizeof(buffer) - buffered, format, args);\n",
+    "  va_end(args);\n",
+    "  if (length > 0) {\n",
+    "    buffered += (size_t)length;\n",
+    "  }\n",
+    "}\n",
+    "\n",
+    "static uintptr_t main_start, main_end, main_bias;\n",
+    "\n",
+    "static int find_main(struct dl_phdr_info *info, size_t size, void *data) {\n",
+    "  (void)size;\n",
+    "  (void)data;\n",
+    "  main_bias = info->dlpi_addr;\n",
+    "  main_start = UINTPTR_MAX;\n",
+    "  for (int i = 0; i < info->dlpi_phnum; i++) {\n",
+    "    if (info->dlpi_phdr[i].p_type != PT_LOAD) {\n",
+    "      continue;\n",
+    "    }\n",
+    "    uintptr_t start = info->dlpi_addr + info->dlpi_phdr[i].p_vaddr;\n",
+    "    uintptr_t end = start + info->dlpi_phdr[i].p_memsz;\n",
+    "    if (start < main_start) main_start = start;\n",
+    "    if (end > main_end) main_end = end;\n",
+    "  }\n",
+    "  return 1;\n",
+    "}\n",
+    "\n",
+    "__attribute__((constructor)) static void alloc_start(void) {\n",
+    "  const char *path = getenv(\"SBOR_ALLOC_OUT\");\n",
+    "  if (!path || !*path) {\n",
+    "    return;\n",
+    "  }\n",
+    "  snprintf(output_path, sizeof(output_path), \"%s\", path);\n",
+    "  // Only profile this process, not the programs it starts\n",
+    "  unsetenv(\"LD_PRELOAD\");\n",
+    "  unsetenv(\"SBOR_ALLOC_OUT\");\n",
+    "\n",
+    "  // backtrace loads libgcc on first use, which allocates\n",
+    "  void *frames[2];\n",
+    "  busy = 1;\n",
+    "  backtrace(frames, 2);\n",
+    "  busy = 0;\n",
+    "  dl_iterate_phdr(find_main, NULL);\n",
+    "  active = 1;\n",
+    "}\n",
+    "\n",
+    "__attribute__((destructor)) static void alloc_stop(void) {\n",
+    "  if (!active) {\n",
+    "    return;\n",
+    "  }\n",
+    "  reporting = 1;\n",
+    "  output = open(output_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);\n",
+    "  if (output < 0) {\n",
+    "    return;\n",
+    "  }\n",
+    "\n",
+    "  uint64_t calls[CALLS] = {0}, sizes[BUCKETS] = {0}, allocated = 0, lost = 0;\n",
+    "  for (struct thread_stats *thread = all_threads; thread; thread = thread->next) {\n",
+    "    for (int c = 0; c < CALLS; c++) calls[c] += thread->calls[c];\n",
+    "    for (int b = 0; b < BUCKETS; b++) sizes[b] += thread->sizes[b];\n",
+    "    allocated += thread->allocated;\n",
+    "    lost += thread->lost_sites;\n",
+    "  }\n",
+    "\n",
+    "  emit(\"sbor-alloc 1\\nbias %lx\\nrange %lx %lx\\n\", (unsigned long)main_bias,\n",
+    "       (unsigned long)main_start, (unsigned long)main_end);\n",
+    "  emit(\"calls %llu %llu %llu %llu %llu\\n\", (unsigned long long)calls[CALL_MALLOC],\n",
+    "       (unsigned long long)calls[CALL_CALLOC], (unsigned long long)calls[CALL_REALLOC],\n",
+    "       (unsigned long long)calls[CALL_FREE], (unsigned long long)calls[CALL_ALIGNED]);\n",
+    "  emit(\"bytes %llu\\npeak %lld\\nlive %lld %lld\\nlost_sites %llu\\n\", (unsigned long long)allocated,\n",
+    "       (long long)peak_bytes, (long long)live_bytes, (long long)live_blocks, (unsigned long long)lost);\n",
+    "  emit(\"sizes\");\n",
+    "  for (int b = 0; b < BUCKETS; b++) emit(\" %llu\", (unsigned long long)sizes[b]);\n",
+    "  emit(\"\\n\");\n",
+    "\n",
+    "  // One line per site and thread; sbor adds up the threads\n",
+    "  for (struct thread_stats *thread = all_threads; thread; thread = thread->next) {\n",
+    "    for (int i = 0; i < SITES; i++) {\n",
+    "      const struct site *site = &thread->sites[i];\n",
+    "      if (!site->address) {\n",
+    "        continue;\n",
+    "      }\n",
+    "      emit(\"site %lx %llu %llu\", (unsigned long)site->address, (unsigned long long)site->calls,\n",
+    "           (unsigned long long)site->bytes);\n",
+    "      for (int b = 0; b < BUCKETS; b++) emit(\" %llu\", (unsigned long long)site->sizes[b]);\n",
+    "      emit(\"\\n\");\n",
+    "      Dl_info where;\n",
+    "      if ((site->address < main_start || site->address >= main_end) &&\n",
+    "          dladdr((void *)(site->address - 1), &where)) {\n",
+    "        const char *object = where.dli_fname ? strrchr(where.dli_fname, '/') : NULL;\n",
+    "        object = object ? object + 1 : where.dli_fname;\n",
+    "        emit(\"sym %lx %s\\n\", (unsigned long)site->address,\n",
+    "             where.dli_sname ? where.dli_sname : (object && *object ? object : \"??\"));\n",
+    "      }\n",
+    "    }\n",
+    "  }\n",
+    "  flush_output();\n",
+    "  close(output);\n",
+    "}\n",
+    NULL
+};
+
+struct alloc_site {
+  unsigned long long address;
+  unsigned long long calls;
+  unsigned long long bytes;
+  unsigned long long sizes[BUCKETS];
+};
+
+static int compare_sites_by_address(const void *a, const void *b) {
+  const struct alloc_site *x = a, *y = b;
+  return (x->address > y->address) - (x->address < y->address);
+}
+
+static int compare_sites_by_calls(const void *a, const void *b) {
+  const struct alloc_site *x = a, *y = b;
+  if (x->calls != y->calls) {
+    return x->calls < y->calls ? 1 : -1;
+  }
+  return (x->bytes < y->bytes) - (x->bytes > y->bytes);
+}
+
+// "64-127 B" for size bucket 6
+static void format_bucket(int bucket, char *buffer, size_t size) {
+  unsigned long long low = bucket == 0 ? 0 : 1ULL << bucket;
+  unsigned long long high = (1ULL << (bucket + 1)) - 1;
+  if (high >= 1024 * 1024) {
+    snprintf(buffer, size, "%llu-%llu MiB", low >> 20, (high + 1) >> 20);
+  } else if (high >= 1024) {
+    snprintf(buffer, size, "%llu-%llu KiB", low >> 10, (high + 1) >> 10);
+  } else {
+    snprintf(buffer, size, "%llu-%llu B", low, high);
+  }
+}
+
+// Parse "<label> n n n ..." into `values`
+static void parse_counts(const char *text, unsigned long long *values, int count) {
+  char *cursor = (char *)text;
+  for (int i = 0; i < count; i++) {
+    char *end;
+    values[i] = strtoull(cursor, &end, 10);
+    if (end == cursor) break;
+    cursor = end;
+  }
+}
+
+static void print_alloc_report(const char *report, const char *exe_path, int top) {
+  unsigned long long calls[5] = {0}, sizes[BUCKETS] = {0}, bytes = 0, lost = 0;
+  long long peak = 0, live_bytes = 0, live_blocks = 0;
+  struct alloc_site *sites = NULL;
+  int site_count = 0, site_capacity = 0;
+
+  for (const char *line = report; line && *line;) {
+    const char *next = strchr(line, '\n');
+    if (strncmp(line, "calls ", 6) == 0) {
+      parse_counts(line + 6, calls, 5);
+    } else if (strncmp(line, "sizes ", 6) == 0) {
+      parse_counts(line + 6, sizes, BUCKETS);
+    } else if (strncmp(line, "site ", 5) == 0) {
+      if (site_count == site_capacity) {
+        site_capacity = site_capacity ? site_capacity * 2 : 256;
+        sites = realloc(sites, site_capacity * sizeof(struct alloc_site));
+      }
+      struct alloc_site *site = &sites[site_count++];
+      memset(site, 0, sizeof(*site));
+      char *cursor;
+      site->address = strtoull(line + 5, &cursor, 16);
+      unsigned long long values[2 + BUCKETS] = {0};
+      parse_counts(cursor, values, 2 + BUCKETS);
+      site->calls = values[0];
+      site->bytes = values[1];
+      memcpy(site->sizes, values + 2, sizeof(site->sizes));
+    } else {
+      sscanf(line, "bytes %llu", &bytes);
+      sscanf(line, "peak %lld", &peak);
+      sscanf(line, "live %lld %lld", &live_bytes, &live_blocks);
+      sscanf(line, "lost_sites %llu", &lost);
+    }
+    line = next ? next + 1 : NULL;
+  }
+
+  // Threads report their sites separately: add them up
+  qsort(sites, site_count, sizeof(struct alloc_site), compare_sites_by_address);
+  int merged = 0;
+  for (int i = 0; i < site_count; i++) {
+    if (merged > 0 && sites[merged - 1].address == sites[i].address) {
+      sites[merged - 1].calls += sites[i].calls;
+      sites[merged - 1].bytes += sites[i].bytes;
+      for (int b = 0; b < BUCKETS; b++) {
+        sites[merged - 1].sizes[b] += sites[i].sizes[b];
+      }
+    } else {
+      sites[merged++] = sites[i];
+    }
+  }
+  site_count = merged;
+  qsort(sites, site_count, sizeof(struct alloc_site), compare_sites_by_calls);
+
+  unsigned long long allocations = calls[0] + calls[1] + calls[2] + calls[4];
+  char text[5][32];
+  format_count((double)calls[0], text[0], sizeof(text[0]));
+  format_count((double)calls[1], text[1], sizeof(text[1]));
+  format_count((double)calls[2], text[2], sizeof(text[2]));
+  format_count((double)calls[4], text[3], sizeof(text[3]));
+  format_count((double)calls[3], text[4], sizeof(text[4]));
+  printf("\n🧮 Allocations:\n");
+  printf("   malloc %s, calloc %s, realloc %s, aligned %s, free %s\n",
+         text[0], text[1], text[2], text[3], text[4]);
+  format_count((double)bytes, text[0], sizeof(text[0]));
+  printf("   Requested: %s bytes (%.1f B per allocation)\n", text[0],
+         allocations ? (double)bytes / allocations : 0.0);
+  format_count((double)peak, text[0], sizeof(text[0]));
+  format_count((double)live_bytes, text[1], sizeof(text[1]));
+  format_count((double)live_blocks, text[2], sizeof(text[2]));
+  printf("   Peak live heap: %s bytes, still allocated at exit: %s bytes in %s blocks\n",
+         text[0], text[1], text[2]);
+
+  unsigned long long largest = 0;
+  int first = BUCKETS, last = -1;
+  for (int b = 0; b < BUCKETS; b++) {
+    if (sizes[b]) {
+      if (b < first) first = b;
+      last = b;
+      if (sizes[b] > largest) largest = sizes[b];
+    }
+  }
+  if (last >= 0) {
+    printf("\n   Allocation sizes:\n");
+  }
+  for (int b = first; b <= last; b++) {
+    char range[32], count[32], bar[3 * 40 + 1] = "";
+    format_bucket(b, range, sizeof(range));
+    format_count((double)sizes[b], count, sizeof(count));
+    int width = (int)((sizes[b] * 40 + largest - 1) / largest);
+    for (int i = 0; i < width; i++) {
+      strcat(bar, "█");
+    }
+    printf("   %18s %12s%s%s\n", range, count, width ? "  " : "", bar);
+  }
+
+  if (site_count > 0) {
+    struct address_map *map = load_address_map(report, exe_path);
+    printf("\n   Top call sites by allocations:\n");
+    printf("   %12s %15s  %-14s  %s\n", "calls", "bytes", "typical size", "site");
+    for (int i = 0; i < site_count && i < top; i++) {
+      int mode = 0;
+      for (int b = 1; b < BUCKETS; b++) {
+        if (sites[i].sizes[b] > sites[i].sizes[mode]) mode = b;
+      }
+      char count[32], total[32], range[32], label[600];
+      format_count((double)sites[i].calls, count, sizeof(count));
+      format_count((double)sites[i].bytes, total, sizeof(total));
+      format_bucket(mode, range, sizeof(range));
+      unsigned long long offset = 0;
+      const char *name = resolve_address(map, sites[i].address, 1, &offset);
+      if (name && offset) {
+        snprintf(label, sizeof(label), "%s+0x%llx", name, offset);
+      } else if (name) {
+        snprintf(label, sizeof(label), "%s", name);
+      } else {
+        snprintf(label, sizeof(label), "0x%llx", sites[i].address);
+      }
+      printf("   %12s %15s  %-14s  %s\n", count, total, range, label);
+    }
+    free_address_map(map);
+  }
+  if (lost) {
+    printf("   ⚠️  %llu allocations came from more call sites than the shim tracks.\n", lost);
+  }
+  free(sites);
+}
+
+#endif
+
+// Run argv with the allocation shim preloaded and print the summary
+// (`top` call sites). Returns the exit code, or -1 if the shim could not run.
+int run_with_alloc_profile(const struct project_config *config, char *const argv[],
+                           const char *work_dir, int top) {
+#ifndef __linux__
+  (void)config;
+  (void)argv;
+  (void)work_dir;
+  (void)top;
+  fprintf(stderr, "❌ Error: --alloc needs Linux with glibc (LD_PRELOAD).\n");
+  return -1;
+#else
+  make_directories(work_dir);
+  char *library = build_preload_library(config, work_dir, "alloc", alloc_source);
+  if (!library) {
+    return -1;
+  }
+
+  char report_path[1200];
+  snprintf(report_path, sizeof(report_path), "%s/alloc.txt", work_dir);
+  remove(report_path);
+
+  setenv("SBOR_ALLOC_OUT", report_path, 1);
+  int exit_code = run_preloaded(argv, library);
+  unsetenv("SBOR_ALLOC_OUT");
+  free(library);
+
+  char *report = read_file_contents(report_path);
+  if (!report || strncmp(report, "sbor-alloc 1\n", 13) != 0) {
+    fprintf(stderr, "❌ Error: The allocation shim wrote no report (the program must exit normally).\n");
+    free(report);
+    return exit_code == 0 ? -1 : exit_code;
+  }
+  print_alloc_report(report, argv[0], top);
+  printf("\n📍 Raw counts: ./%s\n", report_path);
+  free(report);
+  return exit_code;
+#endif
+}
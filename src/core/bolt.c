@@ -0,0 +1,358 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __linux__
+  #include <elf.h>
+  #include <sys/stat.h>
+#endif
+
+#include "../include/commands.h"
+
+// Post-link layout optimization: `sbor build --bolt`.
+//
+//   1. Link the profile with --emit-relocs so llvm-bolt may move code
+//   2. Keep the linked binary as <name>.pre-bolt for A/B comparisons
+//   3. Sample it with `perf record` while it runs the "training" workload
+//   4. Rewrite <output_dir>/<profile>/<name> in place with llvm-bolt
+//
+// llvm-bolt and perf are looked up on PATH ($LLVM_BOLT and $PERF override).
+// Without them the stage is skipped and the regular binary is kept.
+
+// Section sizes of an ELF executable, used to report the layout change
+struct text_layout {
+  long long file_size;
+  long long text_size;     // .text
+  long long code_size;     // All executable sections
+  int bolted;              // Already rewritten by llvm-bolt
+};
+
+#ifdef __linux__
+
+static int read_layout(const char *path, struct text_layout *layout) {
+  memset(layout, 0, sizeof(*layout));
+  FILE *file = fopen(path, "rb");
+  if (!file) {
+    return -1;
+  }
+
+  Elf64_Ehdr header;
+  if (fread(&header, sizeof(header), 1, file) != 1 ||
+      memcmp(header.e_ident, ELFMAG, SELFMAG) != 0 || header.e_ident[EI_CLASS] != ELFCLASS64 ||
+      header.e_shentsize != sizeof(Elf64_Shdr) || header.e_shstrndx >= header.e_shnum) {
+    fclose(file);
+    return -1;
+  }
+
+  Elf64_Shdr *sections = malloc(header.e_shnum * sizeof(Elf64_Shdr));
+  fseek(file, header.e_shoff, SEEK_SET);
+  if (fread(sections, sizeof(Elf64_Shdr), header.e_shnum, file) != header.e_shnum) {
+    free(sections);
+    fclose(file);
+    return -1;
+  }
+
+  Elf64_Shdr *strtab = &sections[header.e_shstrndx];
+  char *names = malloc(strtab->sh_size + 1);
+  fseek(file, strtab->sh_offset, SEEK_SET);
+  if (fread(names, 1, strtab->sh_size, file) != strtab->sh_size) {
+    free(names);
+    free(sections);
+    fclose(file);
+    return -1;
+  }
+  names[strtab->sh_size] = '\0';
+
+  for (int i = 0; i < header.e_shnum; i++) {
+    if (sections[i].sh_name >= strtab->sh_size) {
+      continue;
+    }
+    const char *name = names + sections[i].sh_name;
+    if (strcmp(name, ".text") == 0) {
+      layout->text_size += sections[i].sh_size;
+    }
+    if (sections[i].sh_flags & SHF_EXECINSTR) {
+      layout->code_size += sections[i].sh_size;
+    }
+    if (strcmp(name, ".note.bolt_info") == 0 || strcmp(name, ".bolt.org.text") == 0) {
+      layout->bolted = 1;
+    }
+  }
+
+  fseek(file, 0, SEEK_END);
+  layout->file_size = ftell(file);
+
+  free(names);
+  free(sections);
+  fclose(file);
+  return 0;
+}
+
+static void print_delta(const char *label, long long before, long long after) {
+  double change = before ? 100.0 * (after - before) / before : 0.0;
+  printf("   %-18s %10lld → %10lld bytes (%+.1f%%)\n", label, before, after, change);
+}
+
+static int copy_binary(const char *from, const char *to) {
+  FILE *in = fopen(from, "rb");
+  if (!in) {
+    return -1;
+  }
+  FILE *out = fopen(to, "wb");
+  if (!out) {
+    fclose(in);
+    return -1;
+  }
+
+  char buffer[65536];
+  size_t got;
+  int result = 0;
+  while ((got = fread(buffer, 1, sizeof(buffer), in)) > 0) {
+    if (fwrite(buffer, 1, got, out) != got) {
+      result = -1;
+      break;
+    }
+  }
+
+  fclose(in);
+  if (fclose(out) != 0) {
+    result = -1;
+  }
+  struct stat info;
+  if (result == 0 && stat(from, &info) == 0) {
+    chmod(to, info.st_mode & 07777);
+  }
+  return result;
+}
+
+// $VARIABLE if set, otherwise the program found on PATH
+static char* locate_tool(const char *variable, const char *program) {
+  const char *env = getenv(variable);
+  if (env && *env) {
+    return strdup(env);
+  }
+  return find_program(program);
+}
+
+// Branch stacks (LBR) give llvm-bolt far better profiles, but virtual
+// machines and non-Intel CPUs often lack them
+static int lbr_available(const char *perf) {
+  char *probe[] = { (char *)perf, "record", "-e", "cycles:u", "-j", "any,u",
+                    "-o", "/dev/null", "--", "true", NULL };
+  process_t process;
+  if (spawn_process_redirected(probe, "/dev/null", "/dev/null", &process) != 0) {
+    return 0;
+  }
+  return wait_process(process) == 0;
+}
+
+// Sample the pre-BOLT binary while it runs the training workload. One run
+// is enough for a layout profile, so training.runs is not repeated here.
+static int record_profile(const char *perf, const char *exe_path, const struct arg_list *args,
+                          const char *perf_data, int lbr) {
+  struct arg_list command;
+  arg_list_init(&command);
+  arg_list_push(&command, perf);
+  arg_list_push(&command, "record");
+  arg_list_push(&command, "-q");
+  arg_list_push(&command, "-e");
+  arg_list_push(&command, "cycles:u");
+  if (lbr) {
+    arg_list_push(&command, "-j");
+    arg_list_push(&command, "any,u");
+  }
+  arg_list_push(&command, "-o");
+  arg_list_push(&command, perf_data);
+  arg_list_push(&command, "--");
+  arg_list_push(&command, exe_path);
+  for (int i = 0; i < args->count; i++) {
+    arg_list_push(&command, args->items[i]);
+  }
+
+  printf("   🏋️  Profiling run: %s", exe_path);
+  for (int i = 0; i < args->count; i++) {
+    printf(" %s", args->items[i]);
+  }
+  printf("\n");
+  fflush(stdout);
+
+  int exit_code = run_process(command.items);
+  if (exit_code != 0) {
+    fprintf(stderr, "❌ Error: perf record failed (exit code: %d)\n", exit_code);
+  }
+  arg_list_free(&command);
+  return exit_code == 0 ? 0 : 1;
+}
+
+// Print the lines of the llvm-bolt log that summarize the new layout
+static void print_bolt_summary(const char *log_path) {
+  char *log = read_file_contents(log_path);
+  if (!log) {
+    return;
+  }
+  for (char *line = strtok(log, "\n"); line; line = strtok(NULL, "\n")) {
+    if (strstr(line, "modified layout") || strstr(line, "taken branches") ||
+        strstr(line, "executed instructions") || strstr(line, "functions with profile")) {
+      while (*line == ' ') line++;
+      printf("   %s\n", line);
+    }
+  }
+  free(log);
+}
+
+static int run_bolt(const char *bolt, const char *input, const char *output,
+                    const char *perf_data, int lbr, const char *log_path) {
+  struct arg_list command;
+  arg_list_init(&command);
+  arg_list_push(&command, bolt);
+  arg_list_push(&command, input);
+  arg_list_push(&command, "-o");
+  arg_list_push(&command, output);
+  arg_list_push(&command, "-p");
+  arg_list_push(&command, perf_data);
+  if (!lbr) {
+    arg_list_push(&command, "-nl");
+  }
+
+  // bolt.flags replaces the default optimization pipeline
+  struct arg_list flags;
+  arg_list_init(&flags);
+  if (get_config_list("bolt", "flags", &flags) < 0) {
+    arg_list_push(&flags, "-reorder-blocks=ext-tsp");
+    arg_list_push(&flags, "-reorder-functions=hfsort");
+    arg_list_push(&flags, "-split-functions");
+    arg_list_push(&flags, "-split-all-cold");
+    arg_list_push(&flags, "-split-eh");
+    arg_list_push(&flags, "-dyno-stats");
+  }
+  for (int i = 0; i < flags.count; i++) {
+    arg_list_push(&command, flags.items[i]);
+  }
+  arg_list_free(&flags);
+
+  printf("   🔩 %s %s -o %s\n", bolt, input, output);
+  fflush(stdout);
+
+  process_t process;
+  int result = -1;
+  if (spawn_process_redirected(command.items, log_path, log_path, &process) == 0) {
+    result = wait_process(process);
+  }
+  if (result != 0) {
+    fprintf(stderr, "❌ Error: llvm-bolt failed (exit code: %d), see %s\n", result, log_path);
+  }
+  arg_list_free(&command);
+  return result == 0 ? 0 : 1;
+}
+
+#endif
+
+int bolt_build(const struct build_options *opts) {
+  struct build_options phase = *opts;
+  phase.bolt = 0;
+
+#ifndef __linux__
+  fprintf(stderr, "⚠️  Warning: BOLT only supports Linux ELF binaries, building without it.\n\n");
+  return build_project(&phase);
+#else
+  char *bolt = locate_tool("LLVM_BOLT", "llvm-bolt");
+  char *perf = locate_tool("PERF", "perf");
+  if (!bolt || !perf) {
+    printf("⚠️  Skipping the BOLT stage: %s%s%s not found on PATH.\n",
+           bolt ? "" : "llvm-bolt", !bolt && !perf ? " and " : "", perf ? "" : "perf");
+    printf("   💡 Install them (or set $LLVM_BOLT / $PERF) to optimize the binary layout.\n\n");
+    free(bolt);
+    free(perf);
+    return build_project(&phase);
+  }
+
+  phase.emit_relocs = 1;
+  int result = build_project(&phase);
+  if (result != 0) {
+    free(bolt);
+    free(perf);
+    return result;
+  }
+
+  struct project_config config;
+  struct build_profile profile;
+  if (load_project_config(&config) != 0) {
+    free(bolt);
+    free(perf);
+    return 1;
+  }
+  if (load_build_profile(&phase, &config, &profile) != 0) {
+    free_project_config(&config);
+    free(bolt);
+    free(perf);
+    return 1;
+  }
+
+  char exe_path[1024], pre_path[1100], work_dir[1100], perf_data[1200], log_path[1200];
+  snprintf(exe_path, sizeof(exe_path), "%s/%s", profile.directory, config.name);
+  snprintf(pre_path, sizeof(pre_path), "%s.pre-bolt", exe_path);
+  snprintf(work_dir, sizeof(work_dir), "%s/bolt", profile.directory);
+  snprintf(perf_data, sizeof(perf_data), "%s/perf.data", work_dir);
+  snprintf(log_path, sizeof(log_path), "%s/bolt.log", work_dir);
+
+  printf("\n🔩 BOLT: optimizing the layout of %s\n", exe_path);
+
+  struct text_layout before, after;
+  if (read_layout(exe_path, &before) != 0) {
+    fprintf(stderr, "❌ Error: %s is not a 64-bit ELF executable.\n", exe_path);
+    result = 1;
+  } else if (before.bolted && file_exists(pre_path)) {
+    // The build did not relink, so the binary is still the optimized one
+    printf("   ✅ Binary unchanged since the last BOLT run, nothing to do.\n");
+    printf("   📍 Pre-BOLT binary: ./%s\n", pre_path);
+  } else {
+    make_directories(work_dir);
+    remove(pre_path);
+    if (copy_binary(exe_path, pre_path) != 0) {
+      fprintf(stderr, "❌ Error: Failed to keep a copy of %s\n", exe_path);
+      result = 1;
+    }
+
+    int lbr = result == 0 && lbr_available(perf);
+    if (result == 0 && !lbr) {
+      printf("   ⚠️  No branch stack (LBR) sampling on this machine, using plain samples (-nl).\n");
+    }
+
+    struct arg_list training;
+    load_training_config(pre_path, &training);
+    if (result == 0) {
+      result = record_profile(perf, pre_path, &training, perf_data, lbr);
+    }
+    arg_list_free(&training);
+
+    // Write the optimized binary next to the original, then swap it in
+    char bolted_path[1200];
+    snprintf(bolted_path, sizeof(bolted_path), "%s.bolt", exe_path);
+    if (result == 0) {
+      result = run_bolt(bolt, pre_path, bolted_path, perf_data, lbr, log_path);
+    }
+    if (result == 0 && rename(bolted_path, exe_path) != 0) {
+      fprintf(stderr, "❌ Error: Failed to replace %s\n", exe_path);
+      result = 1;
+    }
+    remove(bolted_path);
+
+    if (result == 0 && read_layout(exe_path, &after) == 0) {
+      printf("\n📏 Layout (pre-BOLT → BOLT):\n");
+      print_delta("file size", before.file_size, after.file_size);
+      print_delta(".text (hot code)", before.text_size, after.text_size);
+      print_delta("executable code", before.code_size, after.code_size);
+      print_bolt_summary(log_path);
+      printf("\n🎉 BOLT-optimized binary: ./%s\n", exe_path);
+      printf("   📍 Pre-BOLT binary for A/B runs: ./%s\n", pre_path);
+      printf("   📝 llvm-bolt log: %s\n", log_path);
+    }
+  }
+
+  free_build_profile(&profile);
+  free_project_config(&config);
+  free(bolt);
+  free(perf);
+  return result;
+#endif
+}
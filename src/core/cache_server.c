@@ -0,0 +1,295 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <signal.h>
+
+#ifndef _WIN32
+  #include <netdb.h>
+  #include <unistd.h>
+  #include <sys/socket.h>
+  #include <sys/types.h>
+  #include <sys/wait.h>
+#endif
+
+#include "../include/commands.h"
+
+// Reference server for the remote object cache (`sbor cache serve`).
+//
+// Protocol: GET, HEAD and PUT on /objects/<key>, where <key> is a 64-digit
+// lowercase hex SHA-256, and on /objects/<key>.stderr for the compiler
+// diagnostics that go with the object. GET answers 200 with the file or
+// 404; PUT stores the request body and answers 201. A PUT without a
+// Content-Length is refused with 411. Each connection is handled in a forked
+// child, so uploads and downloads proceed concurrently.
+
+#ifndef _WIN32
+
+static int valid_key(const char *key) {
+  size_t length = strlen(key);
+  if (length != 64) {
+    return 0;
+  }
+  for (size_t i = 0; i < length; i++) {
+    if (!((key[i] >= '0' && key[i] <= '9') || (key[i] >= 'a' && key[i] <= 'f'))) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+static void send_status(int fd, int status, const char *reason) {
+  char response[256];
+  int length = snprintf(response, sizeof(response),
+                        "HTTP/1.1 %d %s\r\nContent-Length: 0\r\nConnection: close\r\n\r\n",
+                        status, reason);
+  ssize_t sent = send(fd, response, length, 0);
+  (void)sent;
+}
+
+static int read_exact(int fd, char *buffer, size_t length) {
+  size_t done = 0;
+  while (done < length) {
+    ssize_t got = recv(fd, buffer + done, length - done, 0);
+    if (got < 0 && errno == EINTR) continue;
+    if (got <= 0) return -1;
+    done += got;
+  }
+  return 0;
+}
+
+static void serve_get(int fd, const char *path, int head_only) {
+  FILE *file = fopen(path, "rb");
+  if (!file) {
+    send_status(fd, 404, "Not Found");
+    return;
+  }
+
+  fseek(file, 0, SEEK_END);
+  long length = ftell(file);
+  fseek(file, 0, SEEK_SET);
+
+  char header[256];
+  int header_length = snprintf(header, sizeof(header),
+                               "HTTP/1.1 200 OK\r\nContent-Type: application/octet-stream\r\n"
+                               "Content-Length: %ld\r\nConnection: close\r\n\r\n", length);
+  if (send(fd, header, header_length, 0) != header_length || head_only) {
+    fclose(file);
+    return;
+  }
+
+  char buffer[65536];
+  size_t got;
+  while ((got = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+    if (send(fd, buffer, got, 0) != (ssize_t)got) {
+      break;
+    }
+  }
+  fclose(file);
+}
+
+static void serve_put(int fd, const char *path, const char *directory,
+                      const char *body_start, size_t body_have, size_t content_length) {
+  if (content_length > 512UL * 1024 * 1024) {
+    send_status(fd, 413, "Payload Too Large");
+    return;
+  }
+
+  char *body = malloc(content_length + 1);
+  size_t initial = body_have < content_length ? body_have : content_length;
+  memcpy(body, body_start, initial);
+  if (read_exact(fd, body + initial, content_length - initial) != 0) {
+    free(body);
+    send_status(fd, 400, "Bad Request");
+    return;
+  }
+
+  // Write to a temporary name and rename, so readers never see partial objects
+  make_directories(directory);
+  char temp[1300];
+  snprintf(temp, sizeof(temp), "%s.%ld.tmp", path, (long)getpid());
+  FILE *file = fopen(temp, "wb");
+  int ok = file && fwrite(body, 1, content_length, file) == content_length;
+  if (file && fclose(file) != 0) ok = 0;
+  ok = ok && rename(temp, path) == 0;
+  if (!ok) remove(temp);
+
+  free(body);
+  if (ok) {
+    send_status(fd, 201, "Created");
+  } else {
+    send_status(fd, 500, "Internal Server Error");
+  }
+}
+
+static void handle_connection(int fd, const char *root) {
+  struct timeval tv = { 30, 0 };
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+  // Read until the end of the headers
+  char request[8192];
+  size_t length = 0;
+  char *header_end = NULL;
+  while (!header_end && length < sizeof(request) - 1) {
+    ssize_t got = recv(fd, request + length, sizeof(request) - 1 - length, 0);
+    if (got < 0 && errno == EINTR) continue;
+    if (got <= 0) return;
+    length += got;
+    request[length] = '\0';
+    header_end = strstr(request, "\r\n\r\n");
+  }
+  if (!header_end) {
+    send_status(fd, 431, "Request Header Fields Too Large");
+    return;
+  }
+
+  char method[16], target[1024];
+  if (sscanf(request, "%15s %1023s", method, target) != 2) {
+    send_status(fd, 400, "Bad Request");
+    return;
+  }
+
+  size_t content_length = 0;
+  int has_length = 0;
+  for (char *line = strstr(request, "\r\n"); line && line < header_end; line = strstr(line + 2, "\r\n")) {
+    if (strncasecmp(line + 2, "Content-Length:", 15) == 0) {
+      char *end;
+      content_length = strtoul(line + 17, &end, 10);
+      has_length = end != line + 17;
+    }
+  }
+
+  // /objects/<key> or /objects/<key>.stderr
+  char key[65] = "";
+  const char *name = strncmp(target, "/objects/", 9) == 0 ? target + 9 : "";
+  const char *suffix = strlen(name) >= 64 ? name + 64 : NULL;
+  if (suffix) {
+    memcpy(key, name, 64);
+    key[64] = '\0';
+  }
+  if (!suffix || !valid_key(key) || (*suffix && strcmp(suffix, ".stderr") != 0)) {
+    send_status(fd, 404, "Not Found");
+    return;
+  }
+
+  char directory[1024], path[1200];
+  snprintf(directory, sizeof(directory), "%s/%.2s", root, key);
+  snprintf(path, sizeof(path), "%s/%.62s%s", directory, key + 2, *suffix ? ".stderr" : ".o");
+
+  printf("   %s %s\n", method, target);
+  fflush(stdout);
+
+  if (strcmp(method, "GET") == 0 || strcmp(method, "HEAD") == 0) {
+    serve_get(fd, path, strcmp(method, "HEAD") == 0);
+  } else if (strcmp(method, "PUT") == 0 && !has_length) {
+    send_status(fd, 411, "Length Required");
+  } else if (strcmp(method, "PUT") == 0) {
+    char *body_start = header_end + 4;
+    serve_put(fd, path, directory, body_start, length - (body_start - request), content_length);
+  } else {
+    send_status(fd, 405, "Method Not Allowed");
+  }
+}
+
+#endif
+
+// `sbor cache serve [--port N] [--bind ADDR] [--dir DIR]`
+int cache_serve(int argc, char *argv[]) {
+#ifdef _WIN32
+  (void)argc;
+  (void)argv;
+  fprintf(stderr, "❌ Error: 'sbor cache serve' is not supported on Windows yet.\n");
+  return 1;
+#else
+  const char *port = "7878";
+  const char *bind_address = "127.0.0.1";
+  char *root = NULL;
+
+  for (int i = 0; i < argc; i++) {
+    if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+      port = argv[++i];
+    } else if (strcmp(argv[i], "--bind") == 0 && i + 1 < argc) {
+      bind_address = argv[++i];
+    } else if (strcmp(argv[i], "--dir") == 0 && i + 1 < argc) {
+      free(root);
+      root = strdup(argv[++i]);
+    } else {
+      fprintf(stderr, "❌ Error: Unknown option '%s'\n", argv[i]);
+      fprintf(stderr, "   Usage: sbor cache serve [--port N] [--bind ADDR] [--dir DIR]\n");
+      free(root);
+      return 1;
+    }
+  }
+
+  if (!root) {
+    char *cache = cache_directory();
+    if (!cache) {
+      fprintf(stderr, "❌ Error: Could not determine the cache directory (use --dir).\n");
+      return 1;
+    }
+    size_t size = strlen(cache) + 16;
+    root = malloc(size);
+    snprintf(root, size, "%s/server", cache);
+    free(cache);
+  }
+
+  if (make_directories(root) != 0) {
+    fprintf(stderr, "❌ Error: Failed to create %s\n", root);
+    free(root);
+    return 1;
+  }
+
+  struct addrinfo hints, *address;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_flags = AI_PASSIVE;
+  if (getaddrinfo(bind_address, port, &hints, &address) != 0) {
+    fprintf(stderr, "❌ Error: Invalid address %s:%s\n", bind_address, port);
+    free(root);
+    return 1;
+  }
+
+  int server = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+  int reuse = 1;
+  setsockopt(server, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+  if (server < 0 || bind(server, address->ai_addr, address->ai_addrlen) != 0 ||
+      listen(server, 64) != 0) {
+    fprintf(stderr, "❌ Error: Could not listen on %s:%s (%s)\n", bind_address, port, strerror(errno));
+    freeaddrinfo(address);
+    free(root);
+    return 1;
+  }
+  freeaddrinfo(address);
+
+  // Reap connection handlers automatically
+  signal(SIGCHLD, SIG_IGN);
+
+  printf("📡 sbor cache server listening on http://%s:%s\n", bind_address, port);
+  printf("   Storing objects in %s\n", root);
+  printf("   Point projects at it with \"cache_url\": \"http://%s:%s\"\n\n", bind_address, port);
+  fflush(stdout);
+
+  while (1) {
+    int client = accept(server, NULL, NULL);
+    if (client < 0) {
+      if (errno == EINTR) continue;
+      break;
+    }
+
+    pid_t pid = fork();
+    if (pid == 0) {
+      close(server);
+      handle_connection(client, root);
+      close(client);
+      _exit(0);
+    }
+    close(client);
+  }
+
+  close(server);
+  free(root);
+  return 0;
+#endif
+}
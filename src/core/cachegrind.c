@@ -0,0 +1,380 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../include/commands.h"
+
+// Cache simulation with valgrind's cachegrind, for `sbor run --cachegrind`
+// and `sbor profile --cache`. It works where hardware counters do not (VMs
+// without a PMU), and its instruction counts are deterministic, so they make
+// a noise-free regression metric in CI.
+//
+// sbor reads cachegrind.out itself rather than through cg_annotate:
+//
+//   events: Ir I1mr ILmr Dr D1mr DLmr Dw D1mw DLmw
+//   fl=src/main.c
+//   fn=parse
+//   12 2048 0 0 512 64 0 0 0 0      <line> <one count per event>
+//
+// and writes per-function and per-line tables plus cachegrind.json.
+
+#define MAX_EVENTS 16
+#define JSON_LINES 200
+
+struct cg_function {
+  int file;                 // Index into the file names
+  char *name;
+  unsigned long long counts[MAX_EVENTS];
+};
+
+struct cg_line {
+  int file;
+  int line;
+  unsigned long long counts[MAX_EVENTS];
+};
+
+struct cg_profile {
+  char *events[MAX_EVENTS];
+  int event_count;
+  struct arg_list files;
+  struct cg_function *functions;
+  int function_count, function_capacity;
+  struct cg_line *lines;
+  int line_count, line_capacity;
+  unsigned long long totals[MAX_EVENTS];
+  // Indexes of the events the report uses, -1 when absent
+  int ir, d1mr, d1mw, dlmr, dlmw;
+};
+
+static int event_index(const struct cg_profile *profile, const char *name) {
+  for (int i = 0; i < profile->event_count; i++) {
+    if (strcmp(profile->events[i], name) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+static unsigned long long event_value(const unsigned long long *counts, int index) {
+  return index >= 0 ? counts[index] : 0;
+}
+
+static int intern_file(struct cg_profile *profile, const char *name) {
+  for (int i = profile->files.count - 1; i >= 0; i--) {
+    if (strcmp(profile->files.items[i], name) == 0) {
+      return i;
+    }
+  }
+  arg_list_push(&profile->files, name);
+  return profile->files.count - 1;
+}
+
+static struct cg_function* find_function(struct cg_profile *profile, int file, const char *name) {
+  for (int i = 0; i < profile->function_count; i++) {
+    if (profile->functions[i].file == file && strcmp(profile->functions[i].name, name) == 0) {
+      return &profile->functions[i];
+    }
+  }
+  if (profile->function_count == profile->function_capacity) {
+    profile->function_capacity = profile->function_capacity ? profile->function_capacity * 2 : 64;
+    profile->functions = realloc(profile->functions, profile->function_capacity * sizeof(struct cg_function));
+  }
+  struct cg_function *function = &profile->functions[profile->function_count++];
+  memset(function, 0, sizeof(*function));
+  function->file = file;
+  function->name = strdup(name);
+  return function;
+}
+
+static void add_line(struct cg_profile *profile, int file, int line, const unsigned long long *counts) {
+  if (profile->line_count == profile->line_capacity) {
+    profile->line_capacity = profile->line_capacity ? profile->line_capacity * 2 : 1024;
+    profile->lines = realloc(profile->lines, profile->line_capacity * sizeof(struct cg_line));
+  }
+  struct cg_line *entry = &profile->lines[profile->line_count++];
+  entry->file = file;
+  entry->line = line;
+  memcpy(entry->counts, counts, sizeof(entry->counts));
+}
+
+static int compare_lines_by_location(const void *a, const void *b) {
+  const struct cg_line *x = a, *y = b;
+  if (x->file != y->file) {
+    return x->file - y->file;
+  }
+  return x->line - y->line;
+}
+
+// A line can appear under several functions (inlining): add those up
+static void merge_lines(struct cg_profile *profile) {
+  qsort(profile->lines, profile->line_count, sizeof(struct cg_line), compare_lines_by_location);
+  int merged = 0;
+  for (int i = 0; i < profile->line_count; i++) {
+    if (merged > 0 && profile->lines[merged - 1].file == profile->lines[i].file &&
+        profile->lines[merged - 1].line == profile->lines[i].line) {
+      for (int e = 0; e < MAX_EVENTS; e++) {
+        profile->lines[merged - 1].counts[e] += profile->lines[i].counts[e];
+      }
+    } else {
+      profile->lines[merged++] = profile->lines[i];
+    }
+  }
+  profile->line_count = merged;
+}
+
+// "fl=(3) name" in compressed output, "fl=name" otherwise
+static const char* strip_name_id(const char *value) {
+  if (*value == '(') {
+    const char *close = strchr(value, ')');
+    if (close) {
+      value = close + 1;
+      while (*value == ' ') value++;
+    }
+  }
+  return value;
+}
+
+static int parse_cachegrind_output(const char *path, struct cg_profile *profile) {
+  memset(profile, 0, sizeof(*profile));
+  arg_list_init(&profile->files);
+  char *content = read_file_contents(path);
+  if (!content) {
+    return -1;
+  }
+
+  int file = intern_file(profile, "???");
+  struct cg_function *function = NULL;
+  for (char *line = content; line && *line;) {
+    char *next = strchr(line, '\n');
+    if (next) *next++ = '\0';
+
+    if (strncmp(line, "events:", 7) == 0) {
+      char *copy = line + 7;
+      for (char *event = strtok(copy, " "); event && profile->event_count < MAX_EVENTS;
+           event = strtok(NULL, " ")) {
+        profile->events[profile->event_count++] = strdup(event);
+      }
+    } else if (strncmp(line, "fl=", 3) == 0) {
+      file = intern_file(profile, strip_name_id(line + 3));
+      function = NULL;
+    } else if (strncmp(line, "fn=", 3) == 0) {
+      function = find_function(profile, file, strip_name_id(line + 3));
+    } else if (*line >= '0' && *line <= '9' && function) {
+      unsigned long long counts[MAX_EVENTS] = {0};
+      char *cursor = line;
+      int number = (int)strtol(cursor, &cursor, 10);
+      for (int e = 0; e < profile->event_count; e++) {
+        char *end;
+        counts[e] = strtoull(cursor, &end, 10);
+        if (end == cursor) break;  // Trailing zero counts may be left out
+        cursor = end;
+        function->counts[e] += counts[e];
+        profile->totals[e] += counts[e];
+      }
+      add_line(profile, file, number, counts);
+    }
+    line = next;
+  }
+  free(content);
+
+  merge_lines(profile);
+  profile->ir = event_index(profile, "Ir");
+  profile->d1mr = event_index(profile, "D1mr");
+  profile->d1mw = event_index(profile, "D1mw");
+  profile->dlmr = event_index(profile, "DLmr");
+  profile->dlmw = event_index(profile, "DLmw");
+  return profile->event_count > 0 ? 0 : -1;
+}
+
+static void free_cachegrind_profile(struct cg_profile *profile) {
+  for (int i = 0; i < profile->event_count; i++) {
+    free(profile->events[i]);
+  }
+  for (int i = 0; i < profile->function_count; i++) {
+    free(profile->functions[i].name);
+  }
+  free(profile->functions);
+  free(profile->lines);
+  arg_list_free(&profile->files);
+}
+
+// Ranking key: D1 misses, then instructions. The profile is passed through
+// a file-level pointer because qsort has no context argument.
+static const struct cg_profile *ranking_profile;
+
+static int compare_costs(const unsigned long long *x, const unsigned long long *y) {
+  const struct cg_profile *p = ranking_profile;
+  unsigned long long misses_x = event_value(x, p->d1mr) + event_value(x, p->d1mw);
+  unsigned long long misses_y = event_value(y, p->d1mr) + event_value(y, p->d1mw);
+  if (misses_x != misses_y) {
+    return misses_x < misses_y ? 1 : -1;
+  }
+  unsigned long long ir_x = event_value(x, p->ir), ir_y = event_value(y, p->ir);
+  return (ir_x < ir_y) - (ir_x > ir_y);
+}
+
+static int compare_functions(const void *a, const void *b) {
+  return compare_costs(((const struct cg_function *)a)->counts, ((const struct cg_function *)b)->counts);
+}
+
+static int compare_lines_by_cost(const void *a, const void *b) {
+  return compare_costs(((const struct cg_line *)a)->counts, ((const struct cg_line *)b)->counts);
+}
+
+static double percent(unsigned long long part, unsigned long long whole) {
+  return whole ? 100.0 * part / whole : 0.0;
+}
+
+static void print_cost_row(const struct cg_profile *profile, const unsigned long long *counts,
+                           const char *label) {
+  char ir[32], d1mr[32], d1mw[32], dlmr[32], dlmw[32];
+  format_count((double)event_value(counts, profile->ir), ir, sizeof(ir));
+  format_count((double)event_value(counts, profile->d1mr), d1mr, sizeof(d1mr));
+  format_count((double)event_value(counts, profile->d1mw), d1mw, sizeof(d1mw));
+  format_count((double)event_value(counts, profile->dlmr), dlmr, sizeof(dlmr));
+  format_count((double)event_value(counts, profile->dlmw), dlmw, sizeof(dlmw));
+  printf("   %15s %12s %12s %12s %12s  %s\n", ir, d1mr, d1mw, dlmr, dlmw, label);
+}
+
+static void print_cachegrind_report(const struct cg_profile *profile, int top) {
+  const unsigned long long *totals = profile->totals;
+  unsigned long long ir = event_value(totals, profile->ir);
+  unsigned long long data = event_value(totals, event_index(profile, "Dr")) +
+                            event_value(totals, event_index(profile, "Dw"));
+  char instructions[32], accesses[32];
+  format_count((double)ir, instructions, sizeof(instructions));
+  format_count((double)data, accesses, sizeof(accesses));
+
+  printf("\n🧮 Cachegrind: %s instructions (Ir, deterministic)\n", instructions);
+  if (profile->d1mr < 0) {
+    printf("   ⚠️  No cache simulation in this output (run with --cache-sim=yes).\n");
+    return;
+  }
+  printf("   D1 miss rate: %.2f%% of %s data accesses, LL miss rate: %.2f%%\n",
+         percent(event_value(totals, profile->d1mr) + event_value(totals, profile->d1mw), data), accesses,
+         percent(event_value(totals, profile->dlmr) + event_value(totals, profile->dlmw), data));
+
+  printf("\n   Functions by D1 misses:\n");
+  printf("   %15s %12s %12s %12s %12s  %s\n", "Ir", "D1mr", "D1mw", "DLmr", "DLmw", "function");
+  for (int i = 0; i < profile->function_count && i < top; i++) {
+    const struct cg_function *function = &profile->functions[i];
+    char label[1024];
+    snprintf(label, sizeof(label), "%s (%s)", function->name, profile->files.items[function->file]);
+    print_cost_row(profile, function->counts, label);
+  }
+
+  printf("\n   Source lines by D1 misses:\n");
+  printf("   %15s %12s %12s %12s %12s  %s\n", "Ir", "D1mr", "D1mw", "DLmr", "DLmw", "line");
+  for (int i = 0; i < profile->line_count && i < top; i++) {
+    const struct cg_line *line = &profile->lines[i];
+    char label[1024];
+    snprintf(label, sizeof(label), "%s:%d", profile->files.items[line->file], line->line);
+    print_cost_row(profile, line->counts, label);
+  }
+}
+
+static void write_json_counts(FILE *file, const struct cg_profile *profile, const unsigned long long *counts) {
+  for (int e = 0; e < profile->event_count; e++) {
+    fprintf(file, ", \"%s\": %llu", profile->events[e], counts[e]);
+  }
+}
+
+static int write_cachegrind_json(const char *path, const struct cg_profile *profile,
+                                 char *const argv[]) {
+  FILE *file = fopen(path, "w");
+  if (!file) {
+    fprintf(stderr, "❌ Error: Could not write %s\n", path);
+    return -1;
+  }
+  fprintf(file, "{\n    \"binary\": ");
+  write_json_string(file, argv[0]);
+  fprintf(file, ",\n    \"args\": [");
+  for (int i = 1; argv[i]; i++) {
+    fprintf(file, "%s", i > 1 ? ", " : "");
+    write_json_string(file, argv[i]);
+  }
+  fprintf(file, "],\n    \"events\": [");
+  for (int e = 0; e < profile->event_count; e++) {
+    fprintf(file, "%s\"%s\"", e ? ", " : "", profile->events[e]);
+  }
+  fprintf(file, "],\n    \"totals\": {");
+  for (int e = 0; e < profile->event_count; e++) {
+    fprintf(file, "%s\"%s\": %llu", e ? ", " : " ", profile->events[e], profile->totals[e]);
+  }
+  fprintf(file, " },\n    \"functions\": [\n");
+  for (int i = 0; i < profile->function_count; i++) {
+    fprintf(file, "        { \"function\": ");
+    write_json_string(file, profile->functions[i].name);
+    fprintf(file, ", \"file\": ");
+    write_json_string(file, profile->files.items[profile->functions[i].file]);
+    write_json_counts(file, profile, profile->functions[i].counts);
+    fprintf(file, " }%s\n", i + 1 < profile->function_count ? "," : "");
+  }
+  int lines = profile->line_count < JSON_LINES ? profile->line_count : JSON_LINES;
+  fprintf(file, "    ],\n    \"lines\": [\n");
+  for (int i = 0; i < lines; i++) {
+    fprintf(file, "        { \"file\": ");
+    write_json_string(file, profile->files.items[profile->lines[i].file]);
+    fprintf(file, ", \"line\": %d", profile->lines[i].line);
+    write_json_counts(file, profile, profile->lines[i].counts);
+    fprintf(file, " }%s\n", i + 1 < lines ? "," : "");
+  }
+  fprintf(file, "    ]\n}\n");
+  fclose(file);
+  return 0;
+}
+
+// Run argv under cachegrind, print the tables (`top` rows each) and write
+// <work_dir>/cachegrind.out and cachegrind.json. Returns the program's exit
+// code, or -1 if cachegrind could not run.
+int run_cachegrind(char *const argv[], const char *work_dir, int top) {
+  const char *env = getenv("VALGRIND");
+  char *valgrind = env && *env ? strdup(env) : find_program("valgrind");
+  if (!valgrind) {
+    fprintf(stderr, "❌ Error: valgrind not found on PATH (needed for cachegrind).\n");
+    fprintf(stderr, "   💡 Install valgrind, or set $VALGRIND to its path.\n");
+    return -1;
+  }
+
+  make_directories(work_dir);
+  char out_path[1200], json_path[1200], out_option[1300];
+  snprintf(out_path, sizeof(out_path), "%s/cachegrind.out", work_dir);
+  snprintf(json_path, sizeof(json_path), "%s/cachegrind.json", work_dir);
+  snprintf(out_option, sizeof(out_option), "--cachegrind-out-file=%s", out_path);
+  remove(out_path);
+
+  struct arg_list command;
+  arg_list_init(&command);
+  arg_list_push(&command, valgrind);
+  arg_list_push(&command, "--tool=cachegrind");
+  // Newer valgrind releases only count instructions unless asked
+  arg_list_push(&command, "--cache-sim=yes");
+  arg_list_push(&command, out_option);
+  for (int i = 0; argv[i]; i++) {
+    arg_list_push(&command, argv[i]);
+  }
+  fflush(stdout);
+  int exit_code = run_process(command.items);
+  arg_list_free(&command);
+  free(valgrind);
+
+  struct cg_profile profile;
+  if (parse_cachegrind_output(out_path, &profile) != 0) {
+    fprintf(stderr, "❌ Error: cachegrind wrote no usable output (%s)\n", out_path);
+    free_cachegrind_profile(&profile);
+    return -1;
+  }
+
+  ranking_profile = &profile;
+  qsort(profile.functions, profile.function_count, sizeof(struct cg_function), compare_functions);
+  qsort(profile.lines, profile.line_count, sizeof(struct cg_line), compare_lines_by_cost);
+  ranking_profile = NULL;
+
+  print_cachegrind_report(&profile, top);
+  if (write_cachegrind_json(json_path, &profile, argv) == 0) {
+    printf("\n📍 Cachegrind output: ./%s\n", out_path);
+    printf("📍 JSON report:       ./%s\n", json_path);
+  }
+  free_cachegrind_profile(&profile);
+  return exit_code;
+}
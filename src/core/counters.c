@@ -0,0 +1,357 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __linux__
+  #include <errno.h>
+  #include <stdint.h>
+  #include <unistd.h>
+  #include <linux/perf_event.h>
+  #include <sys/syscall.h>
+  #include <sys/wait.h>
+#endif
+
+#include "../include/commands.h"
+
+// Hardware performance counters for `sbor run --counters[=list]`.
+//
+// The program is forked but held before exec while perf_event_open attaches
+// counters to it (enable_on_exec, inherited by its threads and children),
+// so only the program itself is counted, not sbor. Counters that belong
+// together (cycles and instructions, loads and misses) are opened as one
+// group, so the kernel schedules them at the same time and their ratios are
+// exact even when the PMU has to multiplex.
+
+struct counter_spec {
+  const char *name;
+  int type;             // PERF_TYPE_*
+  unsigned long long config;
+  int group;            // Counters of a group are scheduled together
+};
+
+#ifdef __linux__
+
+#define CACHE_EVENT(cache, op, result) \
+  ((cache) | ((op) << 8) | ((result) << 16))
+
+static const struct counter_spec counter_specs[] = {
+  { "cycles",           PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, 0 },
+  { "instructions",     PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, 0 },
+  { "branches",         PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS, 1 },
+  { "branch-misses",    PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, 1 },
+  { "l1d-loads",        PERF_TYPE_HW_CACHE,
+    CACHE_EVENT(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_ACCESS), 2 },
+  { "l1d-misses",       PERF_TYPE_HW_CACHE,
+    CACHE_EVENT(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS), 2 },
+  { "llc-refs",         PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES, 3 },
+  { "llc-misses",       PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, 3 },
+  { "context-switches", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES, 4 },
+  { "cpu-migrations",   PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_MIGRATIONS, 5 },
+  { "page-faults",      PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS, 6 },
+  { "task-clock",       PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK, 7 },
+  { NULL, 0, 0, 0 }
+};
+
+#define MAX_COUNTERS 16
+
+struct counter {
+  const struct counter_spec *spec;
+  int fd;
+  int error;                // errno of a failed open, 0 if counting
+  int user_only;            // Kernel time excluded because of perf_event_paranoid
+  double value;             // Scaled for multiplexing
+  double running_fraction;  // Share of the run the counter was scheduled
+};
+
+// The counters of one finished run, until they are printed
+struct counter_run {
+  struct counter counters[MAX_COUNTERS];
+  int count;
+};
+
+static const struct counter_spec* find_counter_spec(const char *name) {
+  for (int i = 0; counter_specs[i].name; i++) {
+    if (strcmp(counter_specs[i].name, name) == 0) {
+      return &counter_specs[i];
+    }
+  }
+  return NULL;
+}
+
+static int read_paranoid_level(void) {
+  char *value = read_file_contents("/proc/sys/kernel/perf_event_paranoid");
+  int level = value ? atoi(value) : 2;
+  free(value);
+  return level;
+}
+
+static int open_counter(const struct counter_spec *spec, pid_t pid, int group_fd, int exclude_kernel) {
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = spec->type;
+  attr.config = spec->config;
+  attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+  attr.inherit = 1;
+  attr.exclude_kernel = exclude_kernel;
+  attr.exclude_hv = 1;
+  // Group members follow their leader, which starts at exec
+  attr.disabled = group_fd == -1;
+  attr.enable_on_exec = group_fd == -1;
+  return (int)syscall(SYS_perf_event_open, &attr, pid, -1, group_fd, PERF_FLAG_FD_CLOEXEC);
+}
+
+// Attach the counters to `pid`, which has not exec'd yet
+static void open_counters(struct counter *counters, int count, pid_t pid) {
+  int leaders[8];
+  for (int g = 0; g < 8; g++) {
+    leaders[g] = -1;
+  }
+  for (int i = 0; i < count; i++) {
+    struct counter *counter = &counters[i];
+    int group = counter->spec->group;
+    // Count kernel time too where allowed; paranoid level 2 only permits
+    // user space
+    counter->fd = open_counter(counter->spec, pid, leaders[group], 0);
+    if (counter->fd < 0 && (errno == EACCES || errno == EPERM)) {
+      counter->fd = open_counter(counter->spec, pid, leaders[group], 1);
+      counter->user_only = 1;
+    }
+    counter->error = counter->fd < 0 ? errno : 0;
+    if (counter->fd >= 0 && leaders[group] == -1) {
+      leaders[group] = counter->fd;
+    }
+  }
+}
+
+static void read_counters(struct counter *counters, int count) {
+  for (int i = 0; i < count; i++) {
+    struct counter *counter = &counters[i];
+    uint64_t values[3];  // value, time enabled, time running
+    if (counter->fd < 0) {
+      continue;
+    }
+    if (read(counter->fd, values, sizeof(values)) != (ssize_t)sizeof(values) || values[2] == 0) {
+      counter->error = ENODATA;
+    } else {
+      counter->running_fraction = values[1] ? (double)values[2] / values[1] : 1.0;
+      counter->value = values[0] / counter->running_fraction;
+    }
+    close(counter->fd);
+    counter->fd = -1;
+  }
+}
+
+static const struct counter* counter_named(const struct counter *counters, int count, const char *name) {
+  for (int i = 0; i < count; i++) {
+    if (strcmp(counters[i].spec->name, name) == 0 && counters[i].error == 0) {
+      return &counters[i];
+    }
+  }
+  return NULL;
+}
+
+// The derived metric printed next to a counter, if any
+static void derived_metric(const struct counter *counters, int count, const struct counter *counter,
+                           char *buffer, size_t size) {
+  buffer[0] = '\0';
+  const char *name = counter->spec->name;
+  const struct counter *base = NULL;
+  if (strcmp(name, "instructions") == 0 && (base = counter_named(counters, count, "cycles")) && base->value > 0) {
+    snprintf(buffer, size, "# %5.2f IPC", counter->value / base->value);
+  } else if (strcmp(name, "branch-misses") == 0 && (base = counter_named(counters, count, "branches")) && base->value > 0) {
+    snprintf(buffer, size, "# %5.2f%% of branches", 100.0 * counter->value / base->value);
+  } else if (strcmp(name, "l1d-misses") == 0 && (base = counter_named(counters, count, "l1d-loads")) && base->value > 0) {
+    snprintf(buffer, size, "# %5.2f%% of L1d loads", 100.0 * counter->value / base->value);
+  } else if (strcmp(name, "llc-misses") == 0 && (base = counter_named(counters, count, "llc-refs")) && base->value > 0) {
+    snprintf(buffer, size, "# %5.2f%% of LLC references", 100.0 * counter->value / base->value);
+  } else if (strcmp(name, "cycles") == 0 && (base = counter_named(counters, count, "task-clock")) && base->value > 0) {
+    snprintf(buffer, size, "# %5.2f GHz", counter->value / base->value);
+  }
+}
+
+static void print_counters(const struct counter *counters, int count) {
+  int paranoid = read_paranoid_level();
+  int counting = 0, user_only = 0, denied = 0, unsupported = 0;
+  for (int i = 0; i < count; i++) {
+    if (counters[i].error == 0) {
+      counting++;
+      user_only |= counters[i].user_only;
+    } else if (counters[i].error == EACCES || counters[i].error == EPERM) {
+      denied++;
+    } else {
+      unsupported++;
+    }
+  }
+
+  printf("\n📊 Performance counters%s:\n", user_only ? " (user space only)" : "");
+  for (int i = 0; i < count; i++) {
+    const struct counter *counter = &counters[i];
+    if (counter->error) {
+      const char *reason = counter->error == EACCES || counter->error == EPERM ? "<not allowed>" : "<not supported>";
+      printf("   %20s  %s\n", reason, counter->spec->name);
+      continue;
+    }
+
+    char value[48], metric[64], scaled[32] = "";
+    if (strcmp(counter->spec->name, "task-clock") == 0) {
+      snprintf(value, sizeof(value), "%.3f ms", counter->value / 1e6);
+    } else {
+      format_count(counter->value, value, sizeof(value));
+    }
+    derived_metric(counters, count, counter, metric, sizeof(metric));
+    if (counter->running_fraction < 0.999) {
+      snprintf(scaled, sizeof(scaled), " (scaled, ran %.0f%%)", 100.0 * counter->running_fraction);
+    }
+    if (metric[0] || scaled[0]) {
+      printf("   %20s  %-18s %s%s\n", value, counter->spec->name, metric, scaled);
+    } else {
+      printf("   %20s  %s\n", value, counter->spec->name);
+    }
+  }
+
+  if (denied > 0 && paranoid > 2) {
+    printf("⚠️  Warning: kernel.perf_event_paranoid is %d, which forbids %s.\n", paranoid,
+           counting ? "some counters" : "performance counters");
+    printf("   💡 Allow them with: sudo sysctl kernel.perf_event_paranoid=2\n");
+  } else if (denied > 0) {
+    // The sysctl already allows them: a container, seccomp or a missing
+    // CAP_PERFMON refused perf_event_open
+    printf("⚠️  Warning: perf_event_open was refused for %s although kernel.perf_event_paranoid is %d.\n",
+           counting ? "some counters" : "performance counters", paranoid);
+    printf("   💡 A container or seccomp policy blocks it; allow perf_event_open there (e.g. CAP_PERFMON).\n");
+  } else if (unsupported > 0 && counting < count) {
+    printf("⚠️  Warning: %d counter%s not supported here (no PMU access, e.g. in a VM).\n",
+           unsupported, unsupported == 1 ? " is" : "s are");
+  }
+}
+
+// Parse "cycles,instructions" into counters. Returns the count, or -1.
+static int select_counters(const char *list, struct counter *counters) {
+  int count = 0;
+  if (!list || !*list) {
+    for (int i = 0; counter_specs[i].name && count < MAX_COUNTERS; i++) {
+      counters[count++].spec = &counter_specs[i];
+    }
+    return count;
+  }
+
+  char *copy = strdup(list);
+  for (char *name = strtok(copy, ","); name; name = strtok(NULL, ",")) {
+    const struct counter_spec *spec = find_counter_spec(name);
+    if (!spec) {
+      fprintf(stderr, "❌ Error: Unknown counter '%s'\n", name);
+      fprintf(stderr, "   Available:");
+      for (int i = 0; counter_specs[i].name; i++) {
+        fprintf(stderr, "%s %s", i ? "," : "", counter_specs[i].name);
+      }
+      fprintf(stderr, "\n");
+      free(copy);
+      return -1;
+    }
+    if (count < MAX_COUNTERS) {
+      counters[count++].spec = spec;
+    }
+  }
+  free(copy);
+  return count;
+}
+
+#endif
+
+// 1234567 -> "1,234,567"
+void format_count(double value, char *buffer, size_t size) {
+  char digits[32];
+  snprintf(digits, sizeof(digits), "%.0f", value);
+  size_t length = strlen(digits), out = 0;
+  for (size_t i = 0; i < length && out + 2 < size; i++) {
+    if (i > 0 && (length - i) % 3 == 0) {
+      buffer[out++] = ',';
+    }
+    buffer[out++] = digits[i];
+  }
+  buffer[out] = '\0';
+}
+
+// Check a --counters list before building. Returns 0 if it is valid.
+int validate_counter_list(const char *list) {
+#ifdef __linux__
+  struct counter counters[MAX_COUNTERS];
+  return select_counters(list, counters) < 0 ? -1 : 0;
+#else
+  (void)list;
+  return 0;
+#endif
+}
+
+// Run argv with the counters in `list` (comma-separated, NULL for the
+// default set). The counts go to *run for print_counter_run, so they can be
+// shown after the program's output. Returns the exit code.
+int run_with_counters(char *const argv[], const char *list, struct counter_run **run) {
+  *run = NULL;
+#ifndef __linux__
+  (void)list;
+  printf("⚠️  Warning: --counters needs Linux perf events, running without them.\n");
+  return run_process(argv);
+#else
+  struct counter_run *counted = calloc(1, sizeof(struct counter_run));
+  counted->count = select_counters(list, counted->counters);
+  if (counted->count < 0) {
+    free(counted);
+    return 1;
+  }
+
+  // The child waits on `go` until its counters are attached
+  int go[2];
+  if (pipe(go) != 0) {
+    perror("pipe");
+    free(counted);
+    return -1;
+  }
+  fflush(stdout);
+  pid_t pid = fork();
+  if (pid < 0) {
+    perror("fork");
+    close(go[0]);
+    close(go[1]);
+    free(counted);
+    return -1;
+  }
+  if (pid == 0) {
+    close(go[1]);
+    char signal_byte;
+    if (read(go[0], &signal_byte, 1) != 1) {
+      _exit(127);
+    }
+    close(go[0]);
+    execvp(argv[0], argv);
+    perror(argv[0]);
+    _exit(127);
+  }
+
+  close(go[0]);
+  open_counters(counted->counters, counted->count, pid);
+  if (write(go[1], "x", 1) != 1) {
+    perror("write");
+  }
+  close(go[1]);
+
+  int status = 0;
+  while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+  }
+  read_counters(counted->counters, counted->count);
+  *run = counted;
+  return process_exit_code(status);
+#endif
+}
+
+// Print the counters of a run and free it
+void print_counter_run(struct counter_run *run) {
+  if (!run) {
+    return;
+  }
+#ifdef __linux__
+  print_counters(run->counters, run->count);
+#endif
+  free(run);
+}
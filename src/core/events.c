@@ -0,0 +1,298 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <ctype.h>
+
+#ifdef _WIN32
+  #include <io.h>
+  #define dup _dup
+  #define write _write
+  #define STDERR_FILENO 2
+#else
+  #include <unistd.h>
+#endif
+
+#include "../include/commands.h"
+
+// Machine-readable build events (`--message-format=json`).
+//
+// Every event is one JSON object on its own line of stdout, written as soon
+// as it happens:
+//
+//   {"reason":"phase-started","time":5021.318204,"phase":"configure"}
+//
+// "time" is on the monotonic clock, in seconds. While the stream is on,
+// sbor's own text and the output of the tools it runs go to stderr, so
+// stdout carries nothing but events. The compiler and linker launchers
+// (`sbor __time`, `sbor __link`) inherit the stream's descriptor through
+// $SBOR_EVENTS_FD and report each job the moment it finishes.
+//
+// Reasons: build-started, phase-started, phase-finished, compile-finished,
+// link-finished, diagnostic, artifact, build-finished, run-started and
+// run-finished.
+
+#define EVENTS_FD_VARIABLE "SBOR_EVENTS_FD"
+
+static int events_fd = -1;
+static int events_checked = 0;
+static int events_own_stdout = 0;  // Set when events_start() moved stdout
+
+int events_enabled(void) {
+  if (!events_checked) {
+    events_checked = 1;
+    const char *fd = getenv(EVENTS_FD_VARIABLE);
+    if (fd && *fd) {
+      events_fd = atoi(fd);
+    }
+  }
+  return events_fd >= 0;
+}
+
+// Turn the event stream on: stdout now carries events only, and everything
+// else printed by sbor or its children goes to stderr
+void events_start(void) {
+  if (events_enabled()) {
+    return;
+  }
+  events_fd = redirect_stdout(STDERR_FILENO);
+  if (events_fd < 0) {
+    return;
+  }
+  events_own_stdout = 1;
+  char value[16];
+  snprintf(value, sizeof(value), "%d", events_fd);
+#ifdef _WIN32
+  _putenv_s(EVENTS_FD_VARIABLE, value);
+#else
+  setenv(EVENTS_FD_VARIABLE, value, 1);
+#endif
+}
+
+// Give stdout back to the program `sbor run` starts; events keep flowing
+// to the same stream. A stream inherited through $SBOR_EVENTS_FD (e.g. from
+// `sbor watch`) never took stdout, so there is nothing to give back.
+void events_release_stdout(void) {
+  if (events_enabled() && events_own_stdout) {
+    restore_stdout(dup(events_fd));
+  }
+}
+
+static void event_append(struct event *event, const char *text, size_t length) {
+  if (event->length + length + 1 > event->capacity) {
+    while (event->length + length + 1 > event->capacity) {
+      event->capacity = event->capacity ? event->capacity * 2 : 256;
+    }
+    event->text = realloc(event->text, event->capacity);
+  }
+  memcpy(event->text + event->length, text, length);
+  event->length += length;
+  event->text[event->length] = '\0';
+}
+
+static void event_appendf(struct event *event, const char *format, ...) {
+  char buffer[256];
+  va_list args;
+  va_start(args, format);
+  int length = vsnprintf(buffer, sizeof(buffer), format, args);
+  va_end(args);
+  if (length > 0) {
+    event_append(event, buffer, (size_t)length < sizeof(buffer) ? (size_t)length : sizeof(buffer) - 1);
+  }
+}
+
+static void event_append_string(struct event *event, const char *text) {
+  event_append(event, "\"", 1);
+  for (const char *c = text; *c; c++) {
+    if (*c == '"' || *c == '\\') {
+      char escaped[2] = { '\\', *c };
+      event_append(event, escaped, 2);
+    } else if ((unsigned char)*c < 0x20) {
+      event_appendf(event, "\\u%04x", *c);
+    } else {
+      event_append(event, c, 1);
+    }
+  }
+  event_append(event, "\"", 1);
+}
+
+static void event_key(struct event *event, const char *key) {
+  event_append(event, ",", 1);
+  event_append_string(event, key);
+  event_append(event, ":", 1);
+}
+
+void event_begin(struct event *event, const char *reason) {
+  memset(event, 0, sizeof(*event));
+  event_append(event, "{\"reason\":", 10);
+  event_append_string(event, reason);
+  event_appendf(event, ",\"time\":%.6f", timings_now());
+}
+
+// A string member; NULL is written as null
+void event_string(struct event *event, const char *key, const char *value) {
+  event_key(event, key);
+  if (value) {
+    event_append_string(event, value);
+  } else {
+    event_append(event, "null", 4);
+  }
+}
+
+void event_number(struct event *event, const char *key, double value) {
+  event_key(event, key);
+  event_appendf(event, "%.6f", value);
+}
+
+void event_int(struct event *event, const char *key, long long value) {
+  event_key(event, key);
+  event_appendf(event, "%lld", value);
+}
+
+void event_bool(struct event *event, const char *key, int value) {
+  event_key(event, key);
+  event_append(event, value ? "true" : "false", value ? 4 : 5);
+}
+
+// Write the event as one line with a single write(), so lines from parallel
+// launchers never interleave. Frees the event.
+void event_emit(struct event *event) {
+  event_append(event, "}\n", 2);
+  if (events_enabled()) {
+    size_t written = 0;
+    while (written < event->length) {
+      long count = (long)write(events_fd, event->text + written, event->length - written);
+      if (count <= 0) {
+        break;
+      }
+      written += (size_t)count;
+    }
+  }
+  free(event->text);
+  memset(event, 0, sizeof(*event));
+}
+
+// Start of a named phase of the build. Returns its start time for
+// build_phase_finished().
+double build_phase_started(const char *phase) {
+  if (events_enabled()) {
+    struct event event;
+    event_begin(&event, "phase-started");
+    event_string(&event, "phase", phase);
+    event_emit(&event);
+  }
+  return timings_now();
+}
+
+// End of a phase: reported as an event and kept for --timings
+void build_phase_finished(const char *phase, double started, int success) {
+  double finished = timings_now();
+  timings_phase(phase, started, finished);
+  if (events_enabled()) {
+    struct event event;
+    event_begin(&event, "phase-finished");
+    event_string(&event, "phase", phase);
+    event_number(&event, "duration", finished - started);
+    event_bool(&event, "success", success);
+    event_emit(&event);
+  }
+}
+
+// Split "file:line:column: severity: message [-Wflag]" as GCC and Clang
+// print it. Returns 0 for lines that are not diagnostics.
+static int parse_diagnostic(char *line, const char **file, int *line_number, int *column,
+                            const char **severity, char **message, char **option) {
+  static const char *const severities[] = { "fatal error", "error", "warning", "note", NULL };
+  char *marker = NULL;
+  for (int i = 0; severities[i]; i++) {
+    char pattern[32];
+    snprintf(pattern, sizeof(pattern), ": %s: ", severities[i]);
+    char *found = strstr(line, pattern);
+    if (found && (!marker || found < marker)) {
+      marker = found;
+      *severity = severities[i];
+    }
+  }
+  if (!marker) {
+    return 0;
+  }
+  *message = marker + strlen(*severity) + 4;
+  *marker = '\0';
+
+  // The location ends in ":line" or ":line:column"; Windows paths keep their drive colon
+  *line_number = 0;
+  *column = 0;
+  for (int part = 0; part < 2; part++) {
+    char *colon = strrchr(line, ':');
+    if (!colon || !colon[1] || !isdigit((unsigned char)colon[1])) {
+      break;
+    }
+    char *end;
+    long value = strtol(colon + 1, &end, 10);
+    if (*end != '\0') {
+      break;
+    }
+    *column = *line_number;
+    *line_number = (int)value;
+    *colon = '\0';
+  }
+  *file = line;
+
+  *option = NULL;
+  size_t length = strlen(*message);
+  if (length > 3 && (*message)[length - 1] == ']') {
+    char *open = strrchr(*message, '[');
+    if (open && open > *message && open[-1] == ' ' && open[1] == '-') {
+      open[-1] = '\0';
+      (*message)[length - 1] = '\0';
+      *option = open + 1;
+    }
+  }
+  return 1;
+}
+
+// Report a finished compile or link job: one "diagnostic" event per
+// compiler message in `output` (its stderr), then "<kind>-finished".
+void report_job(const char *kind, const char *source, const char *output, double started,
+                double finished, int exit_code, const char *diagnostics) {
+  if (!events_enabled()) {
+    return;
+  }
+  int errors = 0, warnings = 0;
+  char *text = strdup(diagnostics ? diagnostics : "");
+  for (char *line = strtok(text, "\n"); line; line = strtok(NULL, "\n")) {
+    const char *file = NULL, *severity = NULL;
+    char *message, *option;
+    int line_number, column;
+    if (!parse_diagnostic(line, &file, &line_number, &column, &severity, &message, &option)) {
+      continue;
+    }
+    if (strstr(severity, "error")) errors++;
+    else if (strcmp(severity, "warning") == 0) warnings++;
+
+    struct event event;
+    event_begin(&event, "diagnostic");
+    event_string(&event, "unit", source);
+    event_string(&event, "file", file);
+    if (line_number > 0) event_int(&event, "line", line_number);
+    if (column > 0) event_int(&event, "column", column);
+    event_string(&event, "severity", severity);
+    event_string(&event, "message", message);
+    if (option) event_string(&event, "option", option);
+    event_emit(&event);
+  }
+  free(text);
+
+  char reason[32];
+  snprintf(reason, sizeof(reason), "%s-finished", kind);
+  struct event event;
+  event_begin(&event, reason);
+  event_string(&event, "source", source);
+  event_string(&event, "output", output);
+  event_number(&event, "duration", finished - started);
+  event_int(&event, "exit_code", exit_code);
+  event_bool(&event, "success", exit_code == 0);
+  event_int(&event, "errors", errors);
+  event_int(&event, "warnings", warnings);
+  event_emit(&event);
+}
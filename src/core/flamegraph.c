@@ -0,0 +1,343 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../include/commands.h"
+
+// Output of `sbor profile`: folded stacks ("main;parse;lex 42" per line, the
+// format of Brendan Gregg's flamegraph tools), an SVG flame graph drawn from
+// them, and a table of the hottest functions.
+
+#define SVG_WIDTH 1200
+#define FRAME_HEIGHT 16
+#define TOP_MARGIN 40
+#define BOTTOM_MARGIN 10
+#define MIN_FRAME_WIDTH 0.1
+
+static int compare_strings(const void *a, const void *b) {
+  return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+// Add one sample to `stacks` as a folded stack. `frames` are leaf first;
+// folded stacks start at the root.
+void push_folded_stack(struct arg_list *stacks, const struct arg_list *frames) {
+  size_t length = 1;
+  for (int i = 0; i < frames->count; i++) {
+    length += strlen(frames->items[i]) + 1;
+  }
+  char *stack = malloc(length);
+  stack[0] = '\0';
+  for (int i = frames->count - 1; i >= 0; i--) {
+    strcat(stack, frames->items[i]);
+    if (i > 0) strcat(stack, ";");
+  }
+  arg_list_push(stacks, stack);
+  free(stack);
+}
+
+// Count identical stacks and write them as folded lines. Sorts `stacks`.
+int write_folded_stacks(struct arg_list *stacks, const char *path) {
+  qsort(stacks->items, stacks->count, sizeof(char *), compare_strings);
+  FILE *file = fopen(path, "w");
+  if (!file) {
+    fprintf(stderr, "❌ Error: Could not write %s\n", path);
+    return -1;
+  }
+  for (int i = 0; i < stacks->count;) {
+    int j = i;
+    while (j < stacks->count && strcmp(stacks->items[i], stacks->items[j]) == 0) {
+      j++;
+    }
+    fprintf(file, "%s %d\n", stacks->items[i], j - i);
+    i = j;
+  }
+  fclose(file);
+  return 0;
+}
+
+struct frame_node {
+  char *name;
+  long long samples;
+  struct frame_node *children;
+  int child_count;
+  int child_capacity;
+};
+
+static struct frame_node* child_named(struct frame_node *parent, const char *name) {
+  for (int i = 0; i < parent->child_count; i++) {
+    if (strcmp(parent->children[i].name, name) == 0) {
+      return &parent->children[i];
+    }
+  }
+  if (parent->child_count == parent->child_capacity) {
+    parent->child_capacity = parent->child_capacity ? parent->child_capacity * 2 : 4;
+    parent->children = realloc(parent->children, parent->child_capacity * sizeof(struct frame_node));
+  }
+  struct frame_node *child = &parent->children[parent->child_count++];
+  memset(child, 0, sizeof(*child));
+  child->name = strdup(name);
+  return child;
+}
+
+static void free_frames(struct frame_node *node) {
+  for (int i = 0; i < node->child_count; i++) {
+    free_frames(&node->children[i]);
+  }
+  free(node->children);
+  free(node->name);
+}
+
+static int tree_depth(const struct frame_node *node) {
+  int deepest = 0;
+  for (int i = 0; i < node->child_count; i++) {
+    int depth = tree_depth(&node->children[i]);
+    if (depth > deepest) deepest = depth;
+  }
+  return deepest + 1;
+}
+
+// Split a folded line into its stack and sample count. Returns the count,
+// or 0 for a malformed line; `line` is cut after the stack.
+static long long parse_folded_line(char *line) {
+  char *space = strrchr(line, ' ');
+  if (!space) {
+    return 0;
+  }
+  *space = '\0';
+  return atoll(space + 1);
+}
+
+// Read a folded stacks file into a tree rooted at "all"
+static int load_frames(const char *folded_path, struct frame_node *root) {
+  memset(root, 0, sizeof(*root));
+  root->name = strdup("all");
+  char *content = read_file_contents(folded_path);
+  if (!content) {
+    return -1;
+  }
+  for (char *line = strtok(content, "\n"); line; line = strtok(NULL, "\n")) {
+    long long count = parse_folded_line(line);
+    if (count <= 0) {
+      continue;
+    }
+    root->samples += count;
+    // Walk the frames by hand: strtok is busy with the lines
+    struct frame_node *node = root;
+    for (char *frame = line; frame && *frame;) {
+      char *separator = strchr(frame, ';');
+      if (separator) *separator = '\0';
+      node = child_named(node, frame);
+      node->samples += count;
+      frame = separator ? separator + 1 : NULL;
+    }
+  }
+  free(content);
+  return 0;
+}
+
+static void write_escaped(FILE *file, const char *text, size_t limit) {
+  for (size_t i = 0; text[i] && i < limit; i++) {
+    switch (text[i]) {
+      case '&': fputs("&amp;", file); break;
+      case '<': fputs("&lt;", file); break;
+      case '>': fputs("&gt;", file); break;
+      case '"': fputs("&quot;", file); break;
+      default: fputc(text[i], file);
+    }
+  }
+}
+
+// Warm colours, stable per function name
+static void frame_color(const char *name, int *red, int *green, int *blue) {
+  unsigned long long hash = hash_string(HASH_SEED, name);
+  *red = 205 + (int)(hash % 50);
+  *green = (int)((hash >> 8) % 230);
+  *blue = (int)((hash >> 16) % 55);
+}
+
+static void write_frame(FILE *file, const struct frame_node *node, long long total,
+                        double x, int depth, int height) {
+  double width = (double)node->samples / total * (SVG_WIDTH - 20);
+  if (width < MIN_FRAME_WIDTH) {
+    return;
+  }
+  int y = height - BOTTOM_MARGIN - (depth + 1) * FRAME_HEIGHT;
+  int red, green, blue;
+  frame_color(node->name, &red, &green, &blue);
+
+  fprintf(file, "<g><title>");
+  write_escaped(file, node->name, (size_t)-1);
+  fprintf(file, " (%lld samples, %.2f%%)</title>\n", node->samples, 100.0 * node->samples / total);
+  fprintf(file, "<rect x=\"%.1f\" y=\"%d\" width=\"%.1f\" height=\"%d\" fill=\"rgb(%d,%d,%d)\" rx=\"2\"/>\n",
+          x, y, width, FRAME_HEIGHT - 1, red, green, blue);
+  // About 7px per character at font-size 12
+  size_t fits = width > 21 ? (size_t)((width - 6) / 7) : 0;
+  if (fits >= 3) {
+    fprintf(file, "<text x=\"%.1f\" y=\"%d\">", x + 3, y + FRAME_HEIGHT - 4);
+    if (strlen(node->name) <= fits) {
+      write_escaped(file, node->name, fits);
+    } else {
+      write_escaped(file, node->name, fits - 2);
+      fputs("..", file);
+    }
+    fputs("</text>", file);
+  }
+  fputs("</g>\n", file);
+
+  double child_x = x;
+  for (int i = 0; i < node->child_count; i++) {
+    write_frame(file, &node->children[i], total, child_x, depth + 1, height);
+    child_x += (double)node->children[i].samples / total * (SVG_WIDTH - 20);
+  }
+}
+
+static int compare_frame_names(const void *a, const void *b) {
+  return strcmp(((const struct frame_node *)a)->name, ((const struct frame_node *)b)->name);
+}
+
+// Flame graphs order siblings alphabetically, so equal stacks line up
+static void sort_frames(struct frame_node *node) {
+  qsort(node->children, node->child_count, sizeof(struct frame_node), compare_frame_names);
+  for (int i = 0; i < node->child_count; i++) {
+    sort_frames(&node->children[i]);
+  }
+}
+
+// Draw the folded stacks as an SVG flame graph: the root at the bottom,
+// each frame as wide as its share of the samples
+int write_flamegraph(const char *folded_path, const char *svg_path, const char *title) {
+  struct frame_node root;
+  if (load_frames(folded_path, &root) != 0 || root.samples == 0) {
+    free_frames(&root);
+    return -1;
+  }
+  sort_frames(&root);
+
+  FILE *file = fopen(svg_path, "w");
+  if (!file) {
+    fprintf(stderr, "❌ Error: Could not write %s\n", svg_path);
+    free_frames(&root);
+    return -1;
+  }
+
+  int height = TOP_MARGIN + tree_depth(&root) * FRAME_HEIGHT + BOTTOM_MARGIN;
+  fprintf(file, "<?xml version=\"1.0\" standalone=\"no\"?>\n");
+  fprintf(file, "<svg version=\"1.1\" width=\"%d\" height=\"%d\" viewBox=\"0 0 %d %d\" "
+          "xmlns=\"http://www.w3.org/2000/svg\">\n", SVG_WIDTH, height, SVG_WIDTH, height);
+  fprintf(file, "<style>text { font-family: monospace; font-size: 12px; fill: #000; }\n"
+          "rect:hover { stroke: #000; stroke-width: 0.5; }</style>\n");
+  fprintf(file, "<rect width=\"100%%\" height=\"100%%\" fill=\"#f8f8f8\"/>\n");
+  fprintf(file, "<text x=\"%d\" y=\"24\" text-anchor=\"middle\" style=\"font-size: 17px\">",
+          SVG_WIDTH / 2);
+  write_escaped(file, title, (size_t)-1);
+  fprintf(file, "</text>\n");
+  write_frame(file, &root, root.samples, 10, 0, height);
+  fprintf(file, "</svg>\n");
+  fclose(file);
+  free_frames(&root);
+  return 0;
+}
+
+struct function_cost {
+  char *name;
+  long long self;    // Samples with the function on top of the stack
+  long long total;   // Samples with the function anywhere on the stack
+  int seen;          // Last stack that counted this function, for recursion
+};
+
+struct cost_table {
+  struct function_cost *slots;
+  int capacity;  // Power of two
+  int count;
+};
+
+static struct function_cost* cost_entry(struct cost_table *table, const char *name) {
+  if ((table->count + 1) * 10 > table->capacity * 7) {
+    struct cost_table grown = { calloc(table->capacity * 2, sizeof(struct function_cost)),
+                                table->capacity * 2, 0 };
+    for (int i = 0; i < table->capacity; i++) {
+      if (table->slots[i].name) {
+        struct function_cost *slot = cost_entry(&grown, table->slots[i].name);
+        free(slot->name);
+        *slot = table->slots[i];
+      }
+    }
+    free(table->slots);
+    *table = grown;
+  }
+  unsigned long long index = hash_string(HASH_SEED, name) & (table->capacity - 1);
+  while (table->slots[index].name && strcmp(table->slots[index].name, name) != 0) {
+    index = (index + 1) & (table->capacity - 1);
+  }
+  if (!table->slots[index].name) {
+    table->slots[index].name = strdup(name);
+    table->slots[index].seen = -1;
+    table->count++;
+  }
+  return &table->slots[index];
+}
+
+static int compare_costs(const void *a, const void *b) {
+  const struct function_cost *x = a, *y = b;
+  if (x->self != y->self) {
+    return x->self < y->self ? 1 : -1;
+  }
+  return (x->total < y->total) - (x->total > y->total);
+}
+
+// Print the `top` functions with the most self samples
+void print_hot_functions(const char *folded_path, int top) {
+  char *content = read_file_contents(folded_path);
+  if (!content) {
+    return;
+  }
+  struct cost_table table = { calloc(256, sizeof(struct function_cost)), 256, 0 };
+  long long samples = 0;
+  int stack_index = 0;
+  for (char *line = strtok(content, "\n"); line; line = strtok(NULL, "\n"), stack_index++) {
+    long long count = parse_folded_line(line);
+    if (count <= 0) {
+      continue;
+    }
+    samples += count;
+    char *leaf = strrchr(line, ';');
+    leaf = leaf ? leaf + 1 : line;
+    for (char *frame = line; frame && *frame;) {
+      char *separator = strchr(frame, ';');
+      if (separator) *separator = '\0';
+      struct function_cost *cost = cost_entry(&table, frame);
+      if (cost->seen != stack_index) {
+        cost->seen = stack_index;
+        cost->total += count;
+      }
+      if (frame == leaf) {
+        cost->self += count;
+      }
+      frame = separator ? separator + 1 : NULL;
+    }
+  }
+  free(content);
+
+  // Compact the used slots to the front and rank them
+  int used = 0;
+  for (int i = 0; i < table.capacity; i++) {
+    if (table.slots[i].name) {
+      table.slots[used++] = table.slots[i];
+    }
+  }
+  qsort(table.slots, used, sizeof(struct function_cost), compare_costs);
+
+  printf("\n🔥 Hot functions (%lld samples)\n", samples);
+  printf("   %7s %7s  %s\n", "self", "total", "function");
+  for (int i = 0; i < used && i < top && samples > 0; i++) {
+    if (table.slots[i].self == 0) {
+      break;
+    }
+    printf("   %6.2f%% %6.2f%%  %s\n", 100.0 * table.slots[i].self / samples,
+           100.0 * table.slots[i].total / samples, table.slots[i].name);
+  }
+  for (int i = 0; i < used; i++) {
+    free(table.slots[i].name);
+  }
+  free(table.slots);
+}
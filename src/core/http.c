@@ -0,0 +1,241 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+
+#ifndef _WIN32
+  #include <fcntl.h>
+  #include <netdb.h>
+  #include <poll.h>
+  #include <unistd.h>
+  #include <sys/socket.h>
+  #include <sys/types.h>
+#endif
+
+#include "../include/commands.h"
+
+// Minimal HTTP/1.1 client for the remote object cache.
+// Only plain http:// URLs are supported; every request uses its own
+// connection with "Connection: close".
+
+#ifndef _WIN32
+
+// Split http://host[:port][/prefix] into its parts
+static int parse_url(const char *url, char *host, size_t host_size, char *port,
+                     size_t port_size, char *prefix, size_t prefix_size) {
+  if (strncmp(url, "http://", 7) != 0) {
+    return -1;
+  }
+  const char *start = url + 7;
+  const char *slash = strchr(start, '/');
+  const char *host_end = slash ? slash : start + strlen(start);
+  const char *colon = memchr(start, ':', host_end - start);
+
+  size_t host_length = (colon ? colon : host_end) - start;
+  if (host_length == 0 || host_length >= host_size) {
+    return -1;
+  }
+  memcpy(host, start, host_length);
+  host[host_length] = '\0';
+
+  if (colon) {
+    snprintf(port, port_size, "%.*s", (int)(host_end - colon - 1), colon + 1);
+  } else {
+    snprintf(port, port_size, "80");
+  }
+
+  // Keep the prefix without a trailing slash
+  snprintf(prefix, prefix_size, "%s", slash ? slash : "");
+  size_t prefix_length = strlen(prefix);
+  while (prefix_length > 0 && prefix[prefix_length - 1] == '/') {
+    prefix[--prefix_length] = '\0';
+  }
+  return 0;
+}
+
+// Connect with a deadline; returns a blocking socket with I/O timeouts set
+static int connect_with_timeout(const char *host, const char *port, int timeout_ms) {
+  struct addrinfo hints, *addresses;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  if (getaddrinfo(host, port, &hints, &addresses) != 0) {
+    return -1;
+  }
+
+  int fd = -1;
+  for (struct addrinfo *address = addresses; address; address = address->ai_next) {
+    fd = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+    if (fd < 0) {
+      continue;
+    }
+
+    int flags = fcntl(fd, F_GETFL, 0);
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    int connected = connect(fd, address->ai_addr, address->ai_addrlen);
+    if (connected != 0 && errno == EINPROGRESS) {
+      struct pollfd pfd = { fd, POLLOUT, 0 };
+      int error = 0;
+      socklen_t length = sizeof(error);
+      if (poll(&pfd, 1, timeout_ms) == 1 &&
+          getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length) == 0 && error == 0) {
+        connected = 0;
+      }
+    }
+
+    if (connected == 0) {
+      fcntl(fd, F_SETFL, flags);
+      struct timeval tv = { timeout_ms / 1000, (timeout_ms % 1000) * 1000 };
+      setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+      setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+      break;
+    }
+    close(fd);
+    fd = -1;
+  }
+
+  freeaddrinfo(addresses);
+  return fd;
+}
+
+static int send_all(int fd, const void *data, size_t length) {
+  const char *p = data;
+  while (length > 0) {
+    ssize_t sent = send(fd, p, length, 0);
+    if (sent < 0 && errno == EINTR) {
+      continue;
+    }
+    if (sent <= 0) {
+      return -1;
+    }
+    p += sent;
+    length -= sent;
+  }
+  return 0;
+}
+
+// Read the whole response and split it into status and body
+static int read_response(int fd, char **body, size_t *body_length) {
+  size_t capacity = 65536, length = 0;
+  char *buffer = malloc(capacity);
+
+  while (1) {
+    if (length + 65536 > capacity) {
+      capacity *= 2;
+      buffer = realloc(buffer, capacity);
+    }
+    ssize_t got = recv(fd, buffer + length, capacity - length - 1, 0);
+    if (got < 0 && errno == EINTR) {
+      continue;
+    }
+    if (got <= 0) {
+      if (got < 0) {
+        free(buffer);
+        return -1;  // Timeout or reset
+      }
+      break;
+    }
+    length += got;
+  }
+  buffer[length] = '\0';
+
+  int status = 0;
+  if (sscanf(buffer, "HTTP/%*s %d", &status) != 1) {
+    free(buffer);
+    return -1;
+  }
+
+  char *header_end = strstr(buffer, "\r\n\r\n");
+  if (!header_end) {
+    free(buffer);
+    return -1;
+  }
+  char *payload = header_end + 4;
+  size_t payload_length = length - (payload - buffer);
+
+  // Trust Content-Length when present to detect truncated transfers
+  for (char *line = buffer; line < header_end; ) {
+    char *next = strstr(line, "\r\n");
+    if (strncasecmp(line, "Content-Length:", 15) == 0) {
+      size_t expected = strtoul(line + 15, NULL, 10);
+      if (expected != payload_length) {
+        free(buffer);
+        return -1;
+      }
+    }
+    line = next ? next + 2 : header_end;
+  }
+
+  if (body) {
+    *body = malloc(payload_length + 1);
+    memcpy(*body, payload, payload_length);
+    (*body)[payload_length] = '\0';
+    *body_length = payload_length;
+  }
+  free(buffer);
+  return status;
+}
+
+static int http_request(const char *method, const char *url, const char *path,
+                        const void *data, size_t data_length,
+                        char **body, size_t *body_length, int timeout_ms) {
+  char host[256], port[16], prefix[512];
+  if (parse_url(url, host, sizeof(host), port, sizeof(port), prefix, sizeof(prefix)) != 0) {
+    return -1;
+  }
+
+  int fd = connect_with_timeout(host, port, timeout_ms);
+  if (fd < 0) {
+    return -1;
+  }
+
+  char header[2048];
+  int header_length = snprintf(header, sizeof(header),
+                               "%s %s%s HTTP/1.1\r\n"
+                               "Host: %s:%s\r\n"
+                               "User-Agent: sbor\r\n"
+                               "Content-Length: %zu\r\n"
+                               "Connection: close\r\n\r\n",
+                               method, prefix, path, host, port, data_length);
+
+  int status = -1;
+  if (send_all(fd, header, header_length) == 0 &&
+      (data_length == 0 || send_all(fd, data, data_length) == 0)) {
+    status = read_response(fd, body, body_length);
+  }
+
+  close(fd);
+  return status;
+}
+
+#endif
+
+// GET <url><path>. Returns the HTTP status (body filled on 200) or -1 on
+// connection errors and timeouts.
+int http_get(const char *url, const char *path, char **body, size_t *body_length, int timeout_ms) {
+#ifdef _WIN32
+  (void)url; (void)path; (void)body; (void)body_length; (void)timeout_ms;
+  return -1;
+#else
+  *body = NULL;
+  *body_length = 0;
+  int status = http_request("GET", url, path, NULL, 0, body, body_length, timeout_ms);
+  if (status != 200 && *body) {
+    free(*body);
+    *body = NULL;
+    *body_length = 0;
+  }
+  return status;
+#endif
+}
+
+// PUT <url><path> with `data` as the body. Returns the HTTP status or -1.
+int http_put(const char *url, const char *path, const void *data, size_t length, int timeout_ms) {
+#ifdef _WIN32
+  (void)url; (void)path; (void)data; (void)length; (void)timeout_ms;
+  return -1;
+#else
+  return http_request("PUT", url, path, data, length, NULL, NULL, timeout_ms);
+#endif
+}
@@ -0,0 +1,89 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../include/commands.h"
+
+// Linker selection and link timing.
+//
+// The link is the serial tail of every build, so sbor prefers a fast linker:
+// mold, then lld, then the compiler's default. build.linker overrides the
+// choice ("mold", "lld", "gold", "bfd", or "default" for the compiler's own).
+//
+// Link steps are timed separately. The native backend times its link node;
+// with CMake, links run through `sbor __link <timing-file> <command...>`
+// (CMAKE_C_LINKER_LAUNCHER), which records the duration for the summary and
+// reports the link to --timings and --message-format=json (see timings.c).
+
+// A linker the compiler can use with -fuse-ld=<name>
+static int linker_installed(const char *name) {
+  char program[64];
+  snprintf(program, sizeof(program), "ld.%s", name);
+  char *path = find_program(program);
+  if (!path) {
+    path = find_program(name);
+  }
+  int found = path != NULL;
+  free(path);
+  return found;
+}
+
+// Pick the linker for `profile` and add the matching -fuse-ld flag.
+// Sets profile->linker to the linker's name, or NULL for the default.
+void select_linker(struct build_profile *profile) {
+  profile->linker = NULL;
+
+  char *configured = get_config_value("build", "linker");
+  const char *choice = configured && *configured ? configured : "auto";
+
+  if (strcmp(choice, "default") == 0 || strcmp(choice, "system") == 0) {
+    free(configured);
+    return;
+  }
+
+  if (strcmp(choice, "auto") == 0) {
+#if defined(_WIN32) || defined(__APPLE__)
+    // The platform linker is the only supported (and already fast) one
+    free(configured);
+    return;
+#else
+    if (linker_installed("mold")) {
+      profile->linker = strdup("mold");
+    } else if (linker_installed("lld")) {
+      profile->linker = strdup("lld");
+    }
+#endif
+  } else if (linker_installed(choice)) {
+    profile->linker = strdup(choice);
+  } else {
+    printf("⚠️  Warning: build.linker '%s' not found on PATH, using the default linker\n", choice);
+  }
+  free(configured);
+
+  if (profile->linker) {
+    arg_list_pushf(&profile->link_flags, "-fuse-ld=%s", profile->linker);
+  }
+}
+
+// `sbor __link <timing-file> <command...>`: run a link command and write its
+// duration in seconds to <timing-file>. Returns the command's exit code.
+int link_timed(int argc, char *argv[]) {
+  if (argc < 2) {
+    fprintf(stderr, "Usage: sbor __link <timing-file> <command...>\n");
+    return 1;
+  }
+
+  double seconds;
+  int result = run_launched_job("link", argv + 1, &seconds);
+  if (result == 0) {
+    char text[64];
+    snprintf(text, sizeof(text), "%.6f\n", seconds);
+    create_file_with_content(argv[0], text);
+  }
+  return result;
+}
+
+// Print the link step's duration, e.g. after a build
+void print_link_time(double seconds, const struct build_profile *profile) {
+  printf("   🔗 Link: %.3fs (%s linker)\n", seconds, profile->linker ? profile->linker : "default");
+}
@@ -0,0 +1,863 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef _WIN32
+  #include <errno.h>
+  #include <signal.h>
+  #include <unistd.h>
+  #include <sys/types.h>
+  #include <sys/wait.h>
+#endif
+
+#include "../include/commands.h"
+
+// Native build engine: compiles every translation unit under src/ in
+// parallel and links the result directly, without CMake or make.
+//
+// The build is a small DAG. Each node produces one file; a node runs when
+// all of its dependencies are finished and its output is out of date.
+// Out-of-date checks use the -MMD depfile written by the previous compile
+// plus a hash of the command line stored next to the output (<output>.cmd).
+
+enum node_state {
+  NODE_WAITING,
+  NODE_RUNNING,
+  NODE_DONE,
+  NODE_FAILED
+};
+
+struct build_node {
+  char *label;              // Progress text, e.g. "Compiling src/main.c"
+  char *source;             // Primary input, NULL for the link step
+  char *output;
+  char *depfile;            // Written by -MMD, NULL if the node has none
+  struct arg_list command;
+  int *deps;
+  int dep_count;
+  int pending;              // Dependencies that have not finished yet
+  int rebuilt;              // Ran during this build
+  enum node_state state;
+  process_t process;
+  struct timespec started;
+  double seconds;           // Wall time of the command, if it ran
+  int job;                  // Index in the build timings, -1 if not recorded
+};
+
+struct build_graph {
+  struct build_node *nodes;
+  int count;
+  int capacity;
+};
+
+static int graph_add_node(struct build_graph *graph, const char *label, const char *source,
+                          const char *output, const char *depfile) {
+  if (graph->count == graph->capacity) {
+    graph->capacity = graph->capacity ? graph->capacity * 2 : 16;
+    graph->nodes = realloc(graph->nodes, graph->capacity * sizeof(struct build_node));
+  }
+
+  struct build_node *node = &graph->nodes[graph->count];
+  memset(node, 0, sizeof(*node));
+  node->label = strdup(label);
+  node->source = source ? strdup(source) : NULL;
+  node->output = strdup(output);
+  node->depfile = depfile ? strdup(depfile) : NULL;
+  arg_list_init(&node->command);
+  node->state = NODE_WAITING;
+  node->job = -1;
+  return graph->count++;
+}
+
+static void graph_add_dep(struct build_graph *graph, int node_index, int dep_index) {
+  struct build_node *node = &graph->nodes[node_index];
+  node->deps = realloc(node->deps, (node->dep_count + 1) * sizeof(int));
+  node->deps[node->dep_count++] = dep_index;
+  node->pending++;
+}
+
+static void graph_free(struct build_graph *graph) {
+  for (int i = 0; i < graph->count; i++) {
+    struct build_node *node = &graph->nodes[i];
+    free(node->label);
+    free(node->source);
+    free(node->output);
+    free(node->depfile);
+    free(node->deps);
+    arg_list_free(&node->command);
+  }
+  free(graph->nodes);
+}
+
+// Path of the file that records the command used to build `output`
+static void command_stamp_path(const char *output, char *buffer, size_t size) {
+  snprintf(buffer, size, "%s.cmd", output);
+}
+
+static int command_changed(const struct build_node *node) {
+  char stamp_path[1100];
+  command_stamp_path(node->output, stamp_path, sizeof(stamp_path));
+
+  char expected[32];
+  snprintf(expected, sizeof(expected), "%016llx", hash_arg_list(HASH_SEED, &node->command));
+
+  char *previous = read_file_contents(stamp_path);
+  int changed = !previous || strcmp(previous, expected) != 0;
+  free(previous);
+  return changed;
+}
+
+static void write_command_stamp(const struct build_node *node) {
+  char stamp_path[1100];
+  command_stamp_path(node->output, stamp_path, sizeof(stamp_path));
+
+  char value[32];
+  snprintf(value, sizeof(value), "%016llx", hash_arg_list(HASH_SEED, &node->command));
+  create_file_with_content(stamp_path, value);
+}
+
+// Check the prerequisites listed in a Makefile-style depfile.
+// Returns 1 if any of them is missing or newer than `output_mtime`.
+int depfile_is_stale(const char *depfile, long long output_mtime) {
+  char *content = read_file_contents(depfile);
+  if (!content) {
+    return 1;
+  }
+
+  // Skip the "target:" part; the rule ends at the first unescaped newline
+  char *p = strstr(content, ": ");
+  if (!p) {
+    p = strchr(content, ':');
+  }
+  if (!p) {
+    free(content);
+    return 1;
+  }
+  p++;
+
+  int stale = 0;
+  char path[1024];
+  while (*p && !stale) {
+    // Skip whitespace and line continuations
+    while (1) {
+      if (*p == ' ' || *p == '\t') {
+        p++;
+      } else if (*p == '\\' && p[1] == '\n') {
+        p += 2;
+      } else if (*p == '\\' && p[1] == '\r' && p[2] == '\n') {
+        p += 3;
+      } else {
+        break;
+      }
+    }
+    if (*p == '\0' || *p == '\n' || *p == '\r') {
+      break;
+    }
+
+    size_t length = 0;
+    while (*p && *p != ' ' && *p != '\t' && *p != '\n' && *p != '\r') {
+      if (*p == '\\' && p[1] == ' ') {
+        p++;  // Escaped space inside a path
+      } else if (*p == '\\' && (p[1] == '\n' || p[1] == '\r')) {
+        break;
+      }
+      if (length + 1 < sizeof(path)) {
+        path[length++] = *p;
+      }
+      p++;
+    }
+    path[length] = '\0';
+
+    if (length > 0) {
+      long long mtime = file_mtime_ns(path);
+      if (mtime == 0 || mtime > output_mtime) {
+        stale = 1;
+      }
+    }
+  }
+
+  free(content);
+  return stale;
+}
+
+static int node_is_dirty(const struct build_graph *graph, const struct build_node *node) {
+  long long output_mtime = file_mtime_ns(node->output);
+  if (output_mtime == 0 || command_changed(node)) {
+    return 1;
+  }
+
+  for (int i = 0; i < node->dep_count; i++) {
+    const struct build_node *dep = &graph->nodes[node->deps[i]];
+    if (dep->rebuilt || file_mtime_ns(dep->output) > output_mtime) {
+      return 1;
+    }
+  }
+
+  if (node->source && file_mtime_ns(node->source) > output_mtime) {
+    return 1;
+  }
+
+  if (node->depfile && depfile_is_stale(node->depfile, output_mtime)) {
+    return 1;
+  }
+
+  return 0;
+}
+
+static double elapsed_seconds(const struct timespec *start) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+// Mark a node finished and release the nodes that were waiting on it
+static void finish_node(struct build_graph *graph, int index, int *ready, int *ready_count) {
+  graph->nodes[index].state = NODE_DONE;
+
+  for (int i = 0; i < graph->count; i++) {
+    struct build_node *node = &graph->nodes[i];
+    for (int d = 0; d < node->dep_count; d++) {
+      if (node->deps[d] == index && --node->pending == 0) {
+        ready[(*ready_count)++] = i;
+      }
+    }
+  }
+}
+
+// With --message-format=json a job's stderr goes to <output>.diag, so its
+// diagnostics can be reported when it finishes
+static void diagnostics_path(const struct build_node *node, char *buffer, size_t size) {
+  snprintf(buffer, size, "%s.diag", node->output);
+}
+
+// Report a finished node: to `sbor build --timings`, with the nodes it
+// waited for that ran in this build, and as a build event with its
+// diagnostics. Labels are "<verb> <name>".
+static void record_timing(struct build_graph *graph, struct build_node *node, int exit_code) {
+  const char *name = strchr(node->label, ' ');
+  name = name ? name + 1 : node->label;
+  const char *kind = node->source ? "compile" : "link";
+  double end = timings_now();
+
+  if (events_enabled()) {
+    char path[1100];
+    diagnostics_path(node, path, sizeof(path));
+    char *diagnostics = read_file_contents(path);
+    if (diagnostics) {
+      fputs(diagnostics, stderr);
+    }
+    report_job(kind, name, node->output, end - node->seconds, end, exit_code, diagnostics);
+    free(diagnostics);
+    remove(path);
+  }
+
+  if (!timings_enabled()) {
+    return;
+  }
+  int *deps = malloc((node->dep_count + 1) * sizeof(int));
+  int dep_count = 0;
+  for (int i = 0; i < node->dep_count; i++) {
+    int job = graph->nodes[node->deps[i]].job;
+    if (job >= 0) {
+      deps[dep_count++] = job;
+    }
+  }
+  node->job = timings_job(kind, name, node->output, end - node->seconds, end, deps, dep_count);
+  free(deps);
+}
+
+#ifndef _WIN32
+// Wait for one of the graph's running jobs to exit and return its index, or
+// -1 if none is running. Only the graph's own processes are reaped: other
+// children of this process (cache uploads, helpers of a daemon job) belong
+// to whoever started them. A job reaped by someone else gets status -1.
+static int wait_for_job(struct build_graph *graph, int *status) {
+  while (1) {
+    int running = 0;
+    for (int i = 0; i < graph->count; i++) {
+      struct build_node *node = &graph->nodes[i];
+      if (node->state != NODE_RUNNING) {
+        continue;
+      }
+      running = 1;
+      pid_t pid = waitpid(node->process, status, WNOHANG);
+      if (pid == node->process) {
+        return i;
+      }
+      if (pid < 0 && errno == ECHILD) {
+        *status = -1;
+        return i;
+      }
+    }
+    if (!running) {
+      return -1;
+    }
+
+    // Sleep until any child has exited, without reaping it. If that child
+    // is not one of ours it stays waitable until its owner reaps it, so
+    // fall back to polling meanwhile.
+    siginfo_t info;
+    memset(&info, 0, sizeof(info));
+    if (waitid(P_ALL, 0, &info, WEXITED | WNOWAIT) == 0) {
+      int ours = 0;
+      for (int i = 0; i < graph->count && !ours; i++) {
+        ours = graph->nodes[i].state == NODE_RUNNING && graph->nodes[i].process == info.si_pid;
+      }
+      if (!ours) {
+        struct timespec pause = { 0, 2000000 };
+        nanosleep(&pause, NULL);
+      }
+    }
+  }
+}
+#endif
+
+// Execute the graph with up to `jobs` concurrent processes.
+// Returns 0 on success; stops scheduling new work after the first failure.
+static int run_graph(struct build_graph *graph, int jobs, int *built) {
+#ifdef _WIN32
+  (void)graph;
+  (void)jobs;
+  (void)built;
+  fprintf(stderr, "❌ Error: The native build backend is not supported on Windows yet.\n");
+  return 1;
+#else
+  int *ready = malloc(graph->count * sizeof(int));
+  int ready_count = 0;
+  int ready_next = 0;
+  int running = 0;
+  int failed = 0;
+  int started = 0;
+
+  for (int i = 0; i < graph->count; i++) {
+    if (graph->nodes[i].pending == 0) {
+      ready[ready_count++] = i;
+    }
+  }
+
+  *built = 0;
+  while (1) {
+    while (!failed && running < jobs && ready_next < ready_count) {
+      int index = ready[ready_next++];
+      struct build_node *node = &graph->nodes[index];
+
+      if (!node_is_dirty(graph, node)) {
+        finish_node(graph, index, ready, &ready_count);
+        continue;
+      }
+
+      // An interrupted build must never leave a trusted stamp behind
+      char stamp_path[1100];
+      command_stamp_path(node->output, stamp_path, sizeof(stamp_path));
+      remove(stamp_path);
+
+      printf("   [%d/%d] %s\n", ++started, graph->count, node->label);
+      fflush(stdout);
+
+      // Clang's -ftime-trace is added for this run only, see timings.c
+      struct arg_list traced;
+      int trace = timings_enabled() && with_time_trace(node->command.items, &traced);
+      char *const *argv = trace ? traced.items : node->command.items;
+      int spawned;
+      if (events_enabled()) {
+        char path[1100];
+        diagnostics_path(node, path, sizeof(path));
+        spawned = spawn_process_redirected(argv, NULL, path, &node->process);
+      } else {
+        spawned = spawn_process(argv, &node->process);
+      }
+      if (trace) {
+        arg_list_free(&traced);
+      }
+      if (spawned != 0) {
+        fprintf(stderr, "❌ Error: Failed to start '%s'\n", node->command.items[0]);
+        node->state = NODE_FAILED;
+        failed = 1;
+        break;
+      }
+      node->state = NODE_RUNNING;
+      clock_gettime(CLOCK_MONOTONIC, &node->started);
+      running++;
+    }
+
+    if (running == 0) {
+      break;
+    }
+
+    int status;
+    int index = wait_for_job(graph, &status);
+    if (index < 0) {
+      break;
+    }
+
+    struct build_node *node = &graph->nodes[index];
+    running--;
+    node->seconds = elapsed_seconds(&node->started);
+    record_timing(graph, node, process_exit_code(status));
+    if (process_exit_code(status) == 0) {
+      write_command_stamp(node);
+      node->rebuilt = 1;
+      (*built)++;
+      finish_node(graph, index, ready, &ready_count);
+    } else {
+      fprintf(stderr, "❌ Error: %s failed (exit code: %d)\n", node->label,
+              process_exit_code(status));
+      node->state = NODE_FAILED;
+      failed = 1;
+    }
+  }
+
+  free(ready);
+
+  if (failed) {
+    return 1;
+  }
+  for (int i = 0; i < graph->count; i++) {
+    if (graph->nodes[i].state != NODE_DONE) {
+      fprintf(stderr, "❌ Error: Dependency cycle in build graph at '%s'\n", graph->nodes[i].label);
+      return 1;
+    }
+  }
+  return 0;
+#endif
+}
+
+// Compiler flags shared by every translation unit. With a cache launcher the
+// compile runs as `sbor cache compile --root <dir> <compiler> ...`. With a
+// precompiled header, the wrapper `pch_header` is force-included; the compiler
+// loads its .gch instead, and the include guard in src/include.h turns the
+// translation unit's own #include "include.h" into a no-op.
+static void add_compile_flags(struct arg_list *command, const struct project_config *config,
+                              const char *launcher, const char *root, const char *pch_header) {
+  if (launcher) {
+    arg_list_push(command, launcher);
+    arg_list_push(command, "cache");
+    arg_list_push(command, "compile");
+    arg_list_push(command, "--root");
+    arg_list_push(command, root);
+  }
+  arg_list_push(command, config->compiler);
+  if (config->c_standard && *config->c_standard) {
+    arg_list_pushf(command, "-std=%s", config->c_standard);
+  }
+  for (int i = 0; i < config->flags.count; i++) {
+    arg_list_push(command, config->flags.items[i]);
+  }
+  if (pch_header) {
+    arg_list_push(command, "-include");
+    arg_list_push(command, pch_header);
+  }
+  arg_list_push(command, "-Isrc");
+}
+
+// Precompiled header file name for the configured compiler
+static const char* pch_suffix(const struct project_config *config) {
+  return strstr(config->compiler, "clang") ? ".pch" : ".gch";
+}
+
+// Write <pch_dir>/include.h, a one-line wrapper around src/include.h. The
+// precompiled header is built from the wrapper, so a plain preprocess (as the
+// object cache does) still finds a real header at the same path. The file is
+// only rewritten when its content changes, to keep the PCH up to date.
+static int write_pch_wrapper(const char *pch_dir, const char *root, char *path, size_t size) {
+  if (make_directories(pch_dir) != 0) {
+    return -1;
+  }
+  snprintf(path, size, "%s/include.h", pch_dir);
+
+  char content[1200];
+  snprintf(content, sizeof(content),
+           "// Generated by sbor: precompiled form of src/include.h\n"
+           "#include \"%s/src/include.h\"\n", root);
+
+  char *existing = read_file_contents(path);
+  int same = existing && strcmp(existing, content) == 0;
+  free(existing);
+  if (same) {
+    return 0;
+  }
+  return create_file_with_content(path, content);
+}
+
+// Map src/dir/file.c to <output_dir>/obj/dir/file.c.o and create its directory.
+// Generated sources under <output_dir>/ keep their path below it.
+static void object_path_for(const struct project_config *config, const char *source,
+                            char *buffer, size_t size) {
+  size_t out_length = strlen(config->output_dir);
+  const char *relative = source;
+  if (strncmp(source, "src/", 4) == 0) {
+    relative = source + 4;
+  } else if (strncmp(source, config->output_dir, out_length) == 0 && source[out_length] == '/') {
+    relative = source + out_length + 1;
+  }
+  snprintf(buffer, size, "%s/obj/%s.o", config->output_dir, relative);
+
+  char directory[1024];
+  snprintf(directory, sizeof(directory), "%s", buffer);
+  char *slash = strrchr(directory, '/');
+  if (slash) {
+    *slash = '\0';
+    make_directories(directory);
+  }
+}
+
+static int in_list(const struct arg_list *list, const char *item) {
+  for (int i = 0; i < list->count; i++) {
+    if (strcmp(list->items[i], item) == 0) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+// Replace `sources` with unity batches: <output_dir>/unity/unity_N.c, each
+// #including up to build.unity_batch_size sources. Files listed in
+// build.unity_exclude (and `separate`, if not NULL) stay separate translation
+// units. Batches are only rewritten when their content changes, so unchanged
+// batches stay up to date.
+static int make_unity_sources(const struct project_config *config, const char *root,
+                              const char *separate, struct arg_list *sources) {
+  char directory[1024];
+  snprintf(directory, sizeof(directory), "%s/unity", config->output_dir);
+  if (make_directories(directory) != 0) {
+    fprintf(stderr, "❌ Error: Failed to create %s/\n", directory);
+    return -1;
+  }
+
+  struct arg_list excluded, units;
+  arg_list_init(&excluded);
+  arg_list_init(&units);
+  get_config_list("build", "unity_exclude", &excluded);
+  if (separate) {
+    arg_list_push(&excluded, separate);
+  }
+  int batch_size = unity_batch_size();
+
+  size_t capacity = 4096, length = 0;
+  char *content = malloc(capacity);
+  int in_batch = 0, batches = 0, result = 0;
+
+  for (int i = 0; i <= sources->count; i++) {
+    const char *source = i < sources->count ? sources->items[i] : NULL;
+    if (source && in_list(&excluded, source)) {
+      arg_list_push(&units, source);
+      continue;
+    }
+
+    if (source) {
+      if (in_batch == 0) {
+        length = snprintf(content, capacity, "// Generated by sbor: unity batch %d, do not edit\n", batches);
+      }
+      size_t needed = strlen(root) + strlen(source) + 16;
+      if (length + needed > capacity) {
+        capacity = (length + needed) * 2;
+        content = realloc(content, capacity);
+      }
+      length += snprintf(content + length, capacity - length, "#include \"%s/%s\"\n", root, source);
+      in_batch++;
+    }
+
+    // Flush a full batch, or the last partial one
+    if (in_batch > 0 && (in_batch == batch_size || !source)) {
+      char path[1100];
+      snprintf(path, sizeof(path), "%s/unity_%d.c", directory, batches++);
+      char *existing = read_file_contents(path);
+      if (!existing || strcmp(existing, content) != 0) {
+        if (create_file_with_content(path, content) != 0) {
+          fprintf(stderr, "❌ Error: Failed to write %s\n", path);
+          result = -1;
+        }
+      }
+      free(existing);
+      arg_list_push(&units, path);
+      in_batch = 0;
+    }
+  }
+
+  free(content);
+  arg_list_free(&excluded);
+  if (result == 0) {
+    arg_list_free(sources);
+    *sources = units;
+  } else {
+    arg_list_free(&units);
+  }
+  return result;
+}
+
+// Fill in the command of a link node: its dependencies are the objects
+static void add_link_command(struct build_graph *graph, int link, const struct project_config *config,
+                             const struct build_profile *profile) {
+  struct build_node *node = &graph->nodes[link];
+  arg_list_push(&node->command, config->compiler);
+  for (int i = 0; i < config->flags.count; i++) {
+    arg_list_push(&node->command, config->flags.items[i]);
+  }
+  for (int i = 0; i < node->dep_count; i++) {
+    arg_list_push(&node->command, graph->nodes[node->deps[i]].output);
+  }
+  for (int i = 0; i < profile->link_flags.count; i++) {
+    arg_list_push(&node->command, profile->link_flags.items[i]);
+  }
+  arg_list_push(&node->command, "-o");
+  arg_list_push(&node->command, node->output);
+}
+
+// One executable per benches/*.c in <output_dir>/benches/, linked with the
+// project's objects except the one holding main()
+static void add_bench_nodes(struct build_graph *graph, const struct project_config *config,
+                            const char *launcher, const char *root, int link, const char *main_source) {
+  struct arg_list benches;
+  arg_list_init(&benches);
+  list_files_recursive("benches", ".c", &benches);
+
+  char directory[1024];
+  snprintf(directory, sizeof(directory), "%s/benches", config->output_dir);
+  make_directories(directory);
+
+  // The project objects are the main link's dependencies (read before adding nodes)
+  int object_count = graph->nodes[link].dep_count;
+  int *objects = malloc((object_count + 1) * sizeof(int));
+  memcpy(objects, graph->nodes[link].deps, object_count * sizeof(int));
+
+  for (int i = 0; i < benches.count; i++) {
+    const char *source = benches.items[i];
+    if (strchr(source + strlen("benches/"), '/')) {
+      continue;  // Only benches/*.c, like the CMake template
+    }
+
+    char object[1024], depfile[1100], label[1300], binary[1200];
+    object_path_for(config, source, object, sizeof(object));
+    snprintf(depfile, sizeof(depfile), "%s.d", object);
+    snprintf(label, sizeof(label), "Compiling %s", source);
+
+    int node = graph_add_node(graph, label, source, object, depfile);
+    struct arg_list *command = &graph->nodes[node].command;
+    add_compile_flags(command, config, launcher, root, NULL);
+    arg_list_push(command, "-Ibenches");
+    arg_list_push(command, "-MMD");
+    arg_list_push(command, "-MF");
+    arg_list_push(command, depfile);
+    arg_list_push(command, "-c");
+    arg_list_push(command, source);
+    arg_list_push(command, "-o");
+    arg_list_push(command, object);
+
+    const char *name = strrchr(source, '/') + 1;
+    snprintf(binary, sizeof(binary), "%s/%.*s", directory, (int)(strlen(name) - 2), name);
+    snprintf(label, sizeof(label), "Linking %s", binary);
+    int bench_link = graph_add_node(graph, label, NULL, binary, NULL);
+    graph_add_dep(graph, bench_link, node);
+    for (int j = 0; j < object_count; j++) {
+      const char *object_source = graph->nodes[objects[j]].source;
+      if (object_source && (!main_source || strcmp(object_source, main_source) != 0)) {
+        graph_add_dep(graph, bench_link, objects[j]);
+      }
+    }
+  }
+
+  free(objects);
+  arg_list_free(&benches);
+}
+
+// List the executables this build links for `sbor run` (see targets.c).
+// Benchmarks are named bench_<name>, like their CMake targets.
+static void record_native_targets(const struct build_graph *graph, const char *directory) {
+  struct arg_list names, paths;
+  arg_list_init(&names);
+  arg_list_init(&paths);
+  size_t prefix = strlen(directory) + 1;
+  for (int i = 0; i < graph->count; i++) {
+    const char *output = graph->nodes[i].output;
+    if (graph->nodes[i].source || strncmp(output, directory, prefix - 1) != 0) {
+      continue;
+    }
+    const char *relative = output + prefix;
+    const char *file = strrchr(relative, '/');
+    file = file ? file + 1 : relative;
+    if (strncmp(relative, "benches/", 8) == 0) {
+      arg_list_pushf(&names, "bench_%s", file);
+    } else {
+      arg_list_push(&names, file);
+    }
+    arg_list_push(&paths, relative);
+  }
+  record_targets(directory, &names, &paths);
+  arg_list_free(&names);
+  arg_list_free(&paths);
+}
+
+int native_build(const struct build_options *opts, int jobs) {
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  double plan_started = build_phase_started("plan");
+
+  struct project_config config;
+  if (load_project_config(&config) != 0) {
+    fprintf(stderr, "❌ Error: Could not load the project configuration from sbor.conf.\n");
+    build_phase_finished("plan", plan_started, 0);
+    return 1;
+  }
+
+  // Build into the profile's tree with the profile's flags
+  struct build_profile profile;
+  if (load_build_profile(opts, &config, &profile) != 0) {
+    free_project_config(&config);
+    build_phase_finished("plan", plan_started, 0);
+    return 1;
+  }
+  free(config.output_dir);
+  config.output_dir = strdup(profile.directory);
+  arg_list_free(&config.flags);
+  config.flags = profile.flags;
+  arg_list_init(&profile.flags);
+
+  struct arg_list sources;
+  arg_list_init(&sources);
+  if (list_files_recursive("src", ".c", &sources) == 0) {
+    fprintf(stderr, "❌ Error: No .c files found under src/.\n");
+    arg_list_free(&sources);
+    free_build_profile(&profile);
+    free_project_config(&config);
+    build_phase_finished("plan", plan_started, 0);
+    return 1;
+  }
+
+  if (make_directories(config.output_dir) != 0) {
+    fprintf(stderr, "❌ Error: Failed to create %s/ directory\n", config.output_dir);
+    arg_list_free(&sources);
+    free_build_profile(&profile);
+    free_project_config(&config);
+    build_phase_finished("plan", plan_started, 0);
+    return 1;
+  }
+
+  char root[1024];
+  if (getcwd(root, sizeof(root)) == NULL) {
+    root[0] = '\0';
+  }
+  char *launcher = cache_enabled() ? get_self_executable() : NULL;
+
+  int source_count = sources.count;
+  int unity = unity_enabled(opts);
+  // Benchmarks link every object except the one holding main()
+  const char *main_source = opts->benches ? "src/main.c" : NULL;
+  if (unity && make_unity_sources(&config, root, main_source, &sources) != 0) {
+    free(launcher);
+    arg_list_free(&sources);
+    free_build_profile(&profile);
+    free_project_config(&config);
+    build_phase_finished("plan", plan_started, 0);
+    return 1;
+  }
+
+  // Precompile the managed umbrella header unless build.pch is false
+  char pch_dir[1024], pch_header[1100];
+  int use_pch = get_config_flag("build", "pch", 1) && file_exists("src/include.h");
+  snprintf(pch_dir, sizeof(pch_dir), "%s/pch", config.output_dir);
+  if (use_pch && write_pch_wrapper(pch_dir, root, pch_header, sizeof(pch_header)) != 0) {
+    use_pch = 0;
+  }
+
+  printf("⚙️  Native backend: %d translation unit%s, %d parallel job%s (%s, %s profile%s%s%s%s)\n",
+         sources.count, sources.count == 1 ? "" : "s", jobs, jobs == 1 ? "" : "s",
+         config.compiler, profile.name, launcher ? ", object cache" : "",
+         use_pch ? ", precompiled header" : "", profile.linker ? ", " : "",
+         profile.linker ? profile.linker : "");
+  if (unity) {
+    printf("   Unity build: %d source file%s in %d translation unit%s\n", source_count,
+           source_count == 1 ? "" : "s", sources.count, sources.count == 1 ? "" : "s");
+  }
+  printf("\n");
+
+  struct build_graph graph = {0};
+
+  char binary[1024];
+  snprintf(binary, sizeof(binary), "%s/%s", config.output_dir, config.name);
+
+  char label[1100];
+  snprintf(label, sizeof(label), "Linking %s", binary);
+  int link = graph_add_node(&graph, label, NULL, binary, NULL);
+
+  int pch = -1;
+  if (use_pch) {
+    char header[1200], depfile[1300];
+    snprintf(header, sizeof(header), "%s%s", pch_header, pch_suffix(&config));
+    snprintf(depfile, sizeof(depfile), "%s.d", header);
+
+    pch = graph_add_node(&graph, "Precompiling src/include.h", pch_header, header, depfile);
+    struct arg_list *command = &graph.nodes[pch].command;
+    add_compile_flags(command, &config, NULL, root, NULL);
+    arg_list_push(command, "-MMD");
+    arg_list_push(command, "-MF");
+    arg_list_push(command, depfile);
+    arg_list_push(command, "-x");
+    arg_list_push(command, "c-header");
+    arg_list_push(command, pch_header);
+    arg_list_push(command, "-o");
+    arg_list_push(command, header);
+  }
+
+  for (int i = 0; i < sources.count; i++) {
+    const char *source = sources.items[i];
+    char object[1024], depfile[1100];
+    object_path_for(&config, source, object, sizeof(object));
+    snprintf(depfile, sizeof(depfile), "%s.d", object);
+
+    snprintf(label, sizeof(label), "Compiling %s", source);
+    int node = graph_add_node(&graph, label, source, object, depfile);
+    struct arg_list *command = &graph.nodes[node].command;
+    add_compile_flags(command, &config, launcher, root, use_pch ? pch_header : NULL);
+    arg_list_push(command, "-MMD");
+    arg_list_push(command, "-MF");
+    arg_list_push(command, depfile);
+    arg_list_push(command, "-c");
+    arg_list_push(command, source);
+    arg_list_push(command, "-o");
+    arg_list_push(command, object);
+
+    graph_add_dep(&graph, link, node);
+    if (pch >= 0) {
+      graph_add_dep(&graph, node, pch);
+    }
+  }
+
+  if (opts->benches) {
+    add_bench_nodes(&graph, &config, launcher, root, link, main_source);
+  }
+
+  // Link commands need every object, so build them once the graph is complete
+  for (int i = 0; i < graph.count; i++) {
+    if (graph.nodes[i].source == NULL) {
+      add_link_command(&graph, i, &config, &profile);
+    }
+  }
+
+  int built = 0;
+  build_phase_finished("plan", plan_started, 1);
+  double graph_started = build_phase_started("compile and link");
+  int result = run_graph(&graph, jobs, &built);
+  build_phase_finished("compile and link", graph_started, result == 0);
+
+  if (result == 0) {
+    record_native_targets(&graph, config.output_dir);
+    if (built == 0) {
+      printf("   ✅ Everything up to date (%.3fs).\n\n", elapsed_seconds(&start));
+    } else {
+      printf("   ✅ Built %d step%s in %.3fs.\n", built, built == 1 ? "" : "s",
+             elapsed_seconds(&start));
+      if (graph.nodes[link].rebuilt) {
+        print_link_time(graph.nodes[link].seconds, &profile);
+      }
+      printf("\n");
+    }
+  }
+
+  graph_free(&graph);
+  free(launcher);
+  arg_list_free(&sources);
+  free_build_profile(&profile);
+  free_project_config(&config);
+  return result;
+}
@@ -0,0 +1,966 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <sys/stat.h>
+
+#include <signal.h>
+
+#ifndef _WIN32
+  #include <fcntl.h>
+  #include <unistd.h>
+  #include <utime.h>
+  #include <sys/file.h>
+  #include <sys/ioctl.h>
+  #include <sys/types.h>
+  #include <sys/wait.h>
+#endif
+
+#ifdef __linux__
+  #include <linux/fs.h>
+#endif
+
+#include "../include/commands.h"
+
+// Content-addressed object cache.
+//
+// `sbor cache compile <compiler> <args...>` wraps a single compile. The key
+// is a SHA-256 over the preprocessed source, the compiler identity and the
+// flags that affect code generation. Paths under the project root are
+// rewritten to "." before hashing, so identical sources in different
+// checkouts share entries. Objects live in <cache>/objects/xx/<key>.o, with
+// the split DWARF file of a -gsplit-dwarf compile beside it as <key>.dwo.
+//
+// With a remote cache (build.cache_url), a local miss starts the real
+// compile and a GET for the same key at the same time; whichever finishes
+// first wins. Fresh objects are uploaded by a detached process, so the
+// network is never on the compile's critical path.
+
+// ---------------------------------------------------------------------------
+// SHA-256
+
+struct sha256 {
+  uint32_t state[8];
+  uint64_t length;
+  unsigned char block[64];
+  size_t used;
+};
+
+static const uint32_t sha256_k[64] = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+  0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+  0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+  0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+  0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+  0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+#define ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+static void sha256_block(struct sha256 *ctx, const unsigned char *data) {
+  uint32_t w[64];
+  for (int i = 0; i < 16; i++) {
+    w[i] = (uint32_t)data[i * 4] << 24 | (uint32_t)data[i * 4 + 1] << 16 |
+           (uint32_t)data[i * 4 + 2] << 8 | (uint32_t)data[i * 4 + 3];
+  }
+  for (int i = 16; i < 64; i++) {
+    uint32_t s0 = ROTR(w[i - 15], 7) ^ ROTR(w[i - 15], 18) ^ (w[i - 15] >> 3);
+    uint32_t s1 = ROTR(w[i - 2], 17) ^ ROTR(w[i - 2], 19) ^ (w[i - 2] >> 10);
+    w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+  }
+
+  uint32_t a = ctx->state[0], b = ctx->state[1], c = ctx->state[2], d = ctx->state[3];
+  uint32_t e = ctx->state[4], f = ctx->state[5], g = ctx->state[6], h = ctx->state[7];
+
+  for (int i = 0; i < 64; i++) {
+    uint32_t s1 = ROTR(e, 6) ^ ROTR(e, 11) ^ ROTR(e, 25);
+    uint32_t ch = (e & f) ^ (~e & g);
+    uint32_t t1 = h + s1 + ch + sha256_k[i] + w[i];
+    uint32_t s0 = ROTR(a, 2) ^ ROTR(a, 13) ^ ROTR(a, 22);
+    uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+    uint32_t t2 = s0 + maj;
+    h = g; g = f; f = e; e = d + t1;
+    d = c; c = b; b = a; a = t1 + t2;
+  }
+
+  ctx->state[0] += a; ctx->state[1] += b; ctx->state[2] += c; ctx->state[3] += d;
+  ctx->state[4] += e; ctx->state[5] += f; ctx->state[6] += g; ctx->state[7] += h;
+}
+
+static void sha256_init(struct sha256 *ctx) {
+  static const uint32_t initial[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+  };
+  memcpy(ctx->state, initial, sizeof(initial));
+  ctx->length = 0;
+  ctx->used = 0;
+}
+
+static void sha256_update(struct sha256 *ctx, const void *data, size_t length) {
+  const unsigned char *bytes = data;
+  ctx->length += length;
+  while (length > 0) {
+    size_t take = 64 - ctx->used;
+    if (take > length) take = length;
+    memcpy(ctx->block + ctx->used, bytes, take);
+    ctx->used += take;
+    bytes += take;
+    length -= take;
+    if (ctx->used == 64) {
+      sha256_block(ctx, ctx->block);
+      ctx->used = 0;
+    }
+  }
+}
+
+// Hash a string including its terminator so adjacent fields cannot run together
+static void sha256_field(struct sha256 *ctx, const char *text) {
+  sha256_update(ctx, text, strlen(text) + 1);
+}
+
+static void sha256_hex(struct sha256 *ctx, char hex[65]) {
+  uint64_t bits = ctx->length * 8;
+  unsigned char pad = 0x80;
+  sha256_update(ctx, &pad, 1);
+  unsigned char zero = 0;
+  while (ctx->used != 56) {
+    sha256_update(ctx, &zero, 1);
+  }
+  unsigned char length_bytes[8];
+  for (int i = 0; i < 8; i++) {
+    length_bytes[i] = (unsigned char)(bits >> (56 - i * 8));
+  }
+  sha256_update(ctx, length_bytes, 8);
+
+  for (int i = 0; i < 8; i++) {
+    snprintf(hex + i * 8, 9, "%08x", ctx->state[i]);
+  }
+}
+
+// ---------------------------------------------------------------------------
+// Cache location and statistics
+
+// Cache root: $SBOR_CACHE_DIR, $XDG_CACHE_HOME/sbor or ~/.cache/sbor
+char* cache_directory(void) {
+  char path[1024];
+  const char *override = getenv("SBOR_CACHE_DIR");
+  const char *xdg = getenv("XDG_CACHE_HOME");
+  const char *home = getenv("HOME");
+#ifdef _WIN32
+  if (!home) home = getenv("LOCALAPPDATA");
+#endif
+
+  if (override && *override) {
+    snprintf(path, sizeof(path), "%s", override);
+  } else if (xdg && *xdg) {
+    snprintf(path, sizeof(path), "%s/sbor", xdg);
+  } else if (home && *home) {
+    snprintf(path, sizeof(path), "%s/.cache/sbor", home);
+  } else {
+    return NULL;
+  }
+  return strdup(path);
+}
+
+// Whether build.cache is switched on in sbor.conf
+int cache_enabled(void) {
+  char *value = get_config_value("build", "cache");
+  int enabled = value && (strcmp(value, "true") == 0 || strcmp(value, "local") == 0);
+  free(value);
+  return enabled;
+}
+
+enum cache_outcome {
+  CACHE_MISS,
+  CACHE_LOCAL_HIT,
+  CACHE_REMOTE_HIT
+};
+
+struct cache_stats {
+  long long hits;
+  long long misses;
+  long long remote_hits;
+};
+
+static void parse_stats(const char *text, struct cache_stats *stats) {
+  memset(stats, 0, sizeof(*stats));
+  sscanf(text, "hits=%lld misses=%lld remote_hits=%lld",
+         &stats->hits, &stats->misses, &stats->remote_hits);
+}
+
+// Add to the hit/miss counters. Parallel compiles update the same file,
+// so the read-modify-write happens under an exclusive lock.
+static void record_stat(const char *root, enum cache_outcome outcome) {
+#ifdef _WIN32
+  (void)root;
+  (void)outcome;
+#else
+  char path[1100];
+  snprintf(path, sizeof(path), "%s/stats", root);
+
+  int fd = open(path, O_RDWR | O_CREAT, 0644);
+  if (fd < 0) {
+    return;
+  }
+  flock(fd, LOCK_EX);
+
+  char buffer[160] = {0};
+  ssize_t got = read(fd, buffer, sizeof(buffer) - 1);
+  struct cache_stats stats;
+  parse_stats(got > 0 ? buffer : "", &stats);
+  if (outcome == CACHE_LOCAL_HIT) stats.hits++;
+  else if (outcome == CACHE_REMOTE_HIT) stats.remote_hits++;
+  else stats.misses++;
+
+  int length = snprintf(buffer, sizeof(buffer), "hits=%lld misses=%lld remote_hits=%lld\n",
+                        stats.hits, stats.misses, stats.remote_hits);
+  if (ftruncate(fd, 0) == 0 && lseek(fd, 0, SEEK_SET) == 0) {
+    ssize_t written = write(fd, buffer, length);
+    (void)written;
+  }
+
+  flock(fd, LOCK_UN);
+  close(fd);
+#endif
+}
+
+// Remote cache URL: $SBOR_CACHE_URL or build.cache_url, NULL if unset
+char* cache_remote_url(void) {
+  const char *env = getenv("SBOR_CACHE_URL");
+  if (env && *env) {
+    return strdup(env);
+  }
+  char *url = get_config_value("build", "cache_url");
+  if (url && !*url) {
+    free(url);
+    return NULL;
+  }
+  return url;
+}
+
+static void entry_path(const char *root, const char *key, const char *suffix,
+                       char *buffer, size_t size) {
+  snprintf(buffer, size, "%s/objects/%.2s/%s%s", root, key, key + 2, suffix);
+}
+
+// ---------------------------------------------------------------------------
+// Compile wrapper
+
+// Options whose value is a separate argument
+static int takes_value(const char *arg) {
+  static const char *options[] = {
+    "-o", "-MF", "-MT", "-MQ", "-I", "-D", "-U", "-include", "-imacros",
+    "-isystem", "-iquote", "-idirafter", "-x", "-Xpreprocessor", "-Xassembler", NULL
+  };
+  for (int i = 0; options[i]; i++) {
+    if (strcmp(arg, options[i]) == 0) return 1;
+  }
+  return 0;
+}
+
+// Flags with side outputs or inputs that the preprocessed source does not
+// capture; compiles using them are passed straight through.
+static int uncacheable(const char *arg) {
+  return strncmp(arg, "-fprofile-", 10) == 0 || strncmp(arg, "-ftime-trace", 12) == 0 ||
+         strcmp(arg, "-E") == 0 ||
+         strcmp(arg, "-save-temps") == 0 || strcmp(arg, "-") == 0;
+}
+
+// Replace every occurrence of `root` in `text` with "." and feed it to the hash
+static void hash_normalized(struct sha256 *ctx, const char *text, size_t length, const char *root) {
+  size_t root_length = root ? strlen(root) : 0;
+  if (root_length == 0) {
+    sha256_update(ctx, text, length);
+    return;
+  }
+
+  const char *p = text;
+  const char *end = text + length;
+  while (p < end) {
+    const char *match = NULL;
+    for (const char *q = p; q + root_length <= end; q++) {
+      if (*q == *root && memcmp(q, root, root_length) == 0) {
+        match = q;
+        break;
+      }
+    }
+    if (!match) {
+      sha256_update(ctx, p, end - p);
+      break;
+    }
+    sha256_update(ctx, p, match - p);
+    sha256_update(ctx, ".", 1);
+    p = match + root_length;
+  }
+}
+
+// Hash preprocessed output. Only line markers (# 12 "/abs/path.c") carry
+// checkout paths, so only those lines are normalized.
+static void hash_preprocessed(struct sha256 *ctx, const char *text, size_t length, const char *root) {
+  const char *p = text;
+  const char *end = text + length;
+  while (p < end) {
+    const char *newline = memchr(p, '\n', end - p);
+    const char *line_end = newline ? newline + 1 : end;
+    if (*p == '#') {
+      hash_normalized(ctx, p, line_end - p, root);
+    } else {
+      sha256_update(ctx, p, line_end - p);
+    }
+    p = line_end;
+  }
+}
+
+// What the compiler says it is: its --version banner and target triple
+static char* compiler_identity(const char *path) {
+  char *version = NULL, *machine = NULL;
+  size_t version_length = 0, machine_length = 0;
+  char *version_argv[] = { (char *)path, "--version", NULL };
+  char *machine_argv[] = { (char *)path, "-dumpmachine", NULL };
+  int ok = run_process_capture(version_argv, &version, &version_length, NULL, NULL) == 0 &&
+           run_process_capture(machine_argv, &machine, &machine_length, NULL, NULL) == 0 &&
+           version_length > 0;
+  char *identity = NULL;
+  if (ok) {
+    identity = malloc(version_length + machine_length + 2);
+    snprintf(identity, version_length + machine_length + 2, "%s\n%s", version, machine);
+  }
+  free(version);
+  free(machine);
+  return identity;
+}
+
+// Identify the compiler by its version banner and target triple, so the
+// same toolchain on two machines gives the same key; its path or mtime
+// would not (a reinstall changes the mtime). Asking costs two process
+// starts, so the answer is memoized under <cache>/compilers, keyed by the
+// binary's path, size and mtime.
+static void hash_compiler(struct sha256 *ctx, const char *compiler, const char *root) {
+  char *path = strchr(compiler, '/') ? strdup(compiler) : find_program(compiler);
+  struct stat info;
+  if (!path || stat(path, &info) != 0) {
+    sha256_field(ctx, compiler);
+    free(path);
+    return;
+  }
+
+  char binary[1200];
+  snprintf(binary, sizeof(binary), "%s:%lld:%lld", path, (long long)info.st_size,
+           (long long)info.st_mtime);
+  struct sha256 memo_ctx;
+  char memo_key[65];
+  sha256_init(&memo_ctx);
+  sha256_field(&memo_ctx, binary);
+  sha256_hex(&memo_ctx, memo_key);
+
+  char directory[1100], memo[1200], temp[1300];
+  snprintf(directory, sizeof(directory), "%s/compilers", root);
+  snprintf(memo, sizeof(memo), "%s/%s", directory, memo_key);
+  char *identity = read_file_contents(memo);
+  if (!identity) {
+    identity = compiler_identity(path);
+    snprintf(temp, sizeof(temp), "%s.%ld.tmp", memo, (long)getpid());
+    FILE *file = identity && make_directories(directory) == 0 ? fopen(temp, "wb") : NULL;
+    if (file) {
+      fputs(identity, file);
+      fclose(file);
+      if (rename(temp, memo) != 0) {
+        remove(temp);
+      }
+    }
+  }
+  sha256_field(ctx, identity ? identity : binary);
+  free(identity);
+  free(path);
+}
+
+static int copy_file(const char *from, const char *to) {
+  FILE *in = fopen(from, "rb");
+  if (!in) {
+    return -1;
+  }
+  FILE *out = fopen(to, "wb");
+  if (!out) {
+    fclose(in);
+    return -1;
+  }
+
+  char buffer[65536];
+  size_t got;
+  int result = 0;
+  while ((got = fread(buffer, 1, sizeof(buffer), in)) > 0) {
+    if (fwrite(buffer, 1, got, out) != got) {
+      result = -1;
+      break;
+    }
+  }
+
+  fclose(in);
+  if (fclose(out) != 0) {
+    result = -1;
+  }
+  return result;
+}
+
+// Place a cached object at `destination`: reflink if the filesystem
+// supports it, otherwise a hardlink, otherwise a plain copy.
+static int materialize(const char *entry, const char *destination) {
+  remove(destination);
+
+#if defined(__linux__) && defined(FICLONE)
+  int source_fd = open(entry, O_RDONLY);
+  if (source_fd >= 0) {
+    int dest_fd = open(destination, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (dest_fd >= 0) {
+      int cloned = ioctl(dest_fd, FICLONE, source_fd) == 0;
+      close(dest_fd);
+      close(source_fd);
+      if (cloned) {
+        return 0;
+      }
+      remove(destination);
+    } else {
+      close(source_fd);
+    }
+  }
+#endif
+
+#ifndef _WIN32
+  if (link(entry, destination) == 0) {
+    // Entries are shared and read-only; bump the mtime so build tools see
+    // the object as newer than its sources
+    utime(destination, NULL);
+    return 0;
+  }
+#endif
+
+  return copy_file(entry, destination);
+}
+
+// Store a freshly compiled object. Written to a temporary name first and
+// renamed into place so concurrent readers never see a partial entry.
+static void store_file(const char *root, const char *key, const char *suffix, const char *file) {
+  char path[1200], temp[1300];
+  entry_path(root, key, suffix, path, sizeof(path));
+  snprintf(temp, sizeof(temp), "%s.%ld.tmp", path, (long)getpid());
+  if (copy_file(file, temp) != 0) {
+    remove(temp);
+    return;
+  }
+  chmod(temp, 0444);
+  if (rename(temp, path) != 0) {
+    remove(temp);
+  }
+}
+
+static void store_entry(const char *root, const char *key, const char *object, const char *dwo,
+                        const char *diagnostics, size_t diagnostics_length) {
+  char directory[1200], temp[1300];
+  snprintf(directory, sizeof(directory), "%s/objects/%.2s", root, key);
+  if (make_directories(directory) != 0) {
+    return;
+  }
+
+  if (diagnostics_length > 0) {
+    char stderr_path[1200];
+    entry_path(root, key, ".stderr", stderr_path, sizeof(stderr_path));
+    snprintf(temp, sizeof(temp), "%s.%ld.tmp", stderr_path, (long)getpid());
+    FILE *file = fopen(temp, "wb");
+    if (file) {
+      fwrite(diagnostics, 1, diagnostics_length, file);
+      fclose(file);
+      rename(temp, stderr_path);
+    }
+  }
+
+  // The .dwo goes first: a lookup only trusts an entry whose .o exists
+  if (dwo) {
+    store_file(root, key, ".dwo", dwo);
+  }
+  store_file(root, key, ".o", object);
+}
+
+// The split DWARF file the compiler writes next to `object`:
+// the object path with its extension replaced by .dwo
+static void dwo_path_for(const char *object, char *buffer, size_t size) {
+  snprintf(buffer, size, "%s", object);
+  char *dot = strrchr(buffer, '.');
+  char *slash = strrchr(buffer, '/');
+  if (dot && (!slash || dot > slash)) {
+    *dot = '\0';
+  }
+  size_t length = strlen(buffer);
+  snprintf(buffer + length, size - length, ".dwo");
+}
+
+// Print cached compiler diagnostics so warnings survive a cache hit
+static void replay_diagnostics(const char *root, const char *key) {
+  char path[1200];
+  entry_path(root, key, ".stderr", path, sizeof(path));
+  char *diagnostics = read_file_contents(path);
+  if (diagnostics) {
+    fputs(diagnostics, stderr);
+    free(diagnostics);
+  }
+}
+
+#ifndef _WIN32
+// Upload an object, and the diagnostics its compile printed, in a detached
+// grandchild. The compile returns right away; build tools waiting on our
+// stdout/stderr are not held up either, because the uploader closes every
+// inherited descriptor. The diagnostics go first: a fetch only trusts an
+// entry whose object exists.
+static void upload_async(const char *url, const char *key, const char *object,
+                         const char *diagnostics, size_t diagnostics_length) {
+  pid_t child = fork();
+  if (child < 0) {
+    return;
+  }
+  if (child > 0) {
+    waitpid(child, NULL, 0);
+    return;
+  }
+
+  if (fork() != 0) {
+    _exit(0);
+  }
+  setsid();
+  long max_fd = sysconf(_SC_OPEN_MAX);
+  if (max_fd < 0 || max_fd > 4096) max_fd = 4096;
+  for (int fd = 0; fd < max_fd; fd++) {
+    close(fd);
+  }
+
+  char path[128];
+  if (diagnostics_length > 0) {
+    snprintf(path, sizeof(path), "/objects/%s.stderr", key);
+    if (http_put(url, path, diagnostics, diagnostics_length, 30000) / 100 != 2) {
+      _exit(1);
+    }
+  }
+
+  char *data = NULL;
+  FILE *file = fopen(object, "rb");
+  if (file) {
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    data = malloc(length > 0 ? length : 1);
+    if (length >= 0 && fread(data, 1, length, file) == (size_t)length) {
+      snprintf(path, sizeof(path), "/objects/%s", key);
+      http_put(url, path, data, length, 30000);
+    }
+    fclose(file);
+  }
+  free(data);
+  _exit(0);
+}
+
+static int write_body(const char *destination, const char *body, size_t length) {
+  FILE *file = fopen(destination, "wb");
+  int ok = file && fwrite(body, 1, length, file) == length;
+  if (file && fclose(file) != 0) ok = 0;
+  return ok;
+}
+
+// Download <key> into `destination`, and its diagnostics, if it has any,
+// into `diagnostics_destination`, in a child process. The child exits 0 on
+// a hit and 1 otherwise.
+static pid_t fetch_async(const char *url, const char *key, const char *destination,
+                         const char *diagnostics_destination, int timeout_ms) {
+  pid_t child = fork();
+  if (child != 0) {
+    return child;
+  }
+
+  char path[128];
+  snprintf(path, sizeof(path), "/objects/%s", key);
+  char *body = NULL;
+  size_t length = 0;
+  int status = http_get(url, path, &body, &length, timeout_ms);
+  if (status != 200 || length == 0 || !write_body(destination, body, length)) {
+    _exit(1);
+  }
+  free(body);
+
+  // No diagnostics (404) means the compile printed nothing
+  snprintf(path, sizeof(path), "/objects/%s.stderr", key);
+  status = http_get(url, path, &body, &length, timeout_ms);
+  if (status == 200) {
+    _exit(write_body(diagnostics_destination, body, length) ? 0 : 1);
+  }
+  _exit(status == 404 ? 0 : 1);
+}
+
+// Run the local compile and the remote lookup side by side.
+// Returns the compile's exit code, or 0 with *remote_hit set when the
+// remote object arrived first.
+static int compile_racing_remote(char *const compile[], const char *object, const char *url,
+                                 const char *key, char **diagnostics, size_t *diagnostics_length,
+                                 int *remote_hit) {
+  char local_output[1100], remote_output[1100], stderr_path[1100], remote_stderr[1100];
+  snprintf(local_output, sizeof(local_output), "%s.sbor-local", object);
+  snprintf(remote_output, sizeof(remote_output), "%s.sbor-remote", object);
+  snprintf(stderr_path, sizeof(stderr_path), "%s.sbor-stderr", object);
+  snprintf(remote_stderr, sizeof(remote_stderr), "%s.sbor-remote-stderr", object);
+
+  // The local compile writes to a side file so a losing compile can be discarded
+  struct arg_list local;
+  arg_list_init(&local);
+  for (int i = 0; compile[i]; i++) {
+    arg_list_push(&local, compile[i]);
+    if (strcmp(compile[i], "-o") == 0 && compile[i + 1]) {
+      arg_list_push(&local, local_output);
+      i++;
+    }
+  }
+
+  *remote_hit = 0;
+  *diagnostics = NULL;
+  *diagnostics_length = 0;
+
+  char *timeout_value = get_config_value("build", "cache_timeout_ms");
+  int timeout_ms = timeout_value ? atoi(timeout_value) : 10000;
+  free(timeout_value);
+  if (timeout_ms <= 0) timeout_ms = 10000;
+
+  pid_t fetcher = fetch_async(url, key, remote_output, remote_stderr, timeout_ms);
+  process_t compiler;
+  if (spawn_process_redirected(local.items, NULL, stderr_path, &compiler) != 0) {
+    arg_list_free(&local);
+    if (fetcher > 0) {
+      kill(fetcher, SIGKILL);
+      waitpid(fetcher, NULL, 0);
+    }
+    return -1;
+  }
+  arg_list_free(&local);
+
+  int fetch_running = fetcher > 0;
+  int result = -1;
+  while (1) {
+    int status;
+    pid_t pid = waitpid(-1, &status, 0);
+    if (pid < 0) {
+      break;
+    }
+
+    if (fetch_running && pid == fetcher) {
+      fetch_running = 0;
+      if (process_exit_code(status) == 0) {
+        // Remote won: drop the local compile
+        kill(compiler, SIGTERM);
+        waitpid(compiler, NULL, 0);
+        remove(local_output);
+        remove(stderr_path);
+        rename(remote_output, object);
+        char *remote_diagnostics = read_file_contents(remote_stderr);
+        if (remote_diagnostics) {
+          *diagnostics = remote_diagnostics;
+          *diagnostics_length = strlen(remote_diagnostics);
+        }
+        remove(remote_stderr);
+        *remote_hit = 1;
+        return 0;
+      }
+      remove(remote_output);
+      remove(remote_stderr);
+    } else if (pid == compiler) {
+      result = process_exit_code(status);
+      if (fetch_running) {
+        kill(fetcher, SIGKILL);
+        waitpid(fetcher, NULL, 0);
+        remove(remote_output);
+        remove(remote_stderr);
+      }
+      break;
+    }
+  }
+
+  if (result == 0) {
+    rename(local_output, object);
+  } else {
+    remove(local_output);
+  }
+
+  char *captured = read_file_contents(stderr_path);
+  if (captured) {
+    *diagnostics = captured;
+    *diagnostics_length = strlen(captured);
+  }
+  remove(stderr_path);
+  return result;
+}
+#endif
+
+// Entry point for `sbor cache compile [--root DIR] <compiler> <args...>`.
+// Returns the compiler's exit code.
+int cache_compile(int argc, char *argv[]) {
+  const char *project_root = NULL;
+  int first = 0;
+  if (argc >= 2 && strcmp(argv[0], "--root") == 0) {
+    project_root = argv[1];
+    first = 2;
+  }
+  if (first >= argc) {
+    fprintf(stderr, "Usage: sbor cache compile [--root DIR] <compiler> <args...>\n");
+    return 1;
+  }
+
+  // Map the project root to "." in debug info and __FILE__, so objects are
+  // identical across checkouts and can be shared through a remote cache
+  struct arg_list command;
+  arg_list_init(&command);
+  for (int i = first; i < argc; i++) {
+    arg_list_push(&command, argv[i]);
+    if (i == first && project_root) {
+      arg_list_pushf(&command, "-ffile-prefix-map=%s=.", project_root);
+    }
+  }
+
+  char **compile_argv = command.items;
+  int compile_argc = command.count;
+
+  // Work out what kind of command this is
+  const char *object = NULL;
+  int compile_only = 0, sources = 0, cacheable = 1, has_deps = 0, has_target = 0, split_dwarf = 0;
+  for (int i = 1; i < compile_argc; i++) {
+    const char *arg = compile_argv[i];
+    if (strcmp(arg, "-c") == 0) {
+      compile_only = 1;
+    } else if (strcmp(arg, "-o") == 0 && i + 1 < compile_argc) {
+      object = compile_argv[i + 1];
+    } else if (strcmp(arg, "-MD") == 0 || strcmp(arg, "-MMD") == 0) {
+      has_deps = 1;
+    } else if (strcmp(arg, "-MT") == 0 || strcmp(arg, "-MQ") == 0) {
+      has_target = 1;
+    } else if (strncmp(arg, "-gsplit-dwarf", 13) == 0) {
+      split_dwarf = 1;
+    } else if (uncacheable(arg)) {
+      cacheable = 0;
+    } else if (strcmp(arg, "-x") == 0 && i + 1 < compile_argc &&
+               strstr(compile_argv[i + 1], "header")) {
+      cacheable = 0;  // Precompiled headers embed absolute paths
+    } else if (arg[0] != '-') {
+      sources++;
+    }
+    if (takes_value(arg)) {
+      i++;
+    }
+  }
+
+  char *root = cache_directory();
+  if (!compile_only || !object || sources != 1 || !cacheable || !root) {
+    free(root);
+    int result = run_process(compile_argv);
+    arg_list_free(&command);
+    return result;
+  }
+
+  // Preprocess: same command with -E instead of -c/-o, output captured.
+  // If the command writes a depfile, this pass produces it as well.
+  struct arg_list preprocess;
+  arg_list_init(&preprocess);
+  for (int i = 0; i < compile_argc; i++) {
+    if (strcmp(compile_argv[i], "-c") == 0) {
+      continue;
+    }
+    if (strcmp(compile_argv[i], "-o") == 0) {
+      i++;
+      continue;
+    }
+    arg_list_push(&preprocess, compile_argv[i]);
+  }
+  arg_list_push(&preprocess, "-E");
+  if (has_deps && !has_target) {
+    arg_list_push(&preprocess, "-MT");
+    arg_list_push(&preprocess, object);
+  }
+
+  char *preprocessed = NULL;
+  size_t preprocessed_length = 0;
+  int preprocess_result = run_process_capture(preprocess.items, &preprocessed,
+                                              &preprocessed_length, NULL, NULL);
+  arg_list_free(&preprocess);
+
+  if (preprocess_result != 0) {
+    // Let the real compile report the error
+    free(preprocessed);
+    free(root);
+    int result = run_process(compile_argv);
+    arg_list_free(&command);
+    return result;
+  }
+
+  // Key: format version, compiler identity, code-generating flags, source
+  struct sha256 ctx;
+  sha256_init(&ctx);
+  sha256_field(&ctx, "sbor-object-cache-v2");
+  hash_compiler(&ctx, compile_argv[0], root);
+  for (int i = 1; i < compile_argc; i++) {
+    const char *arg = compile_argv[i];
+    if (strcmp(arg, "-o") == 0 || strcmp(arg, "-MF") == 0 ||
+        strcmp(arg, "-MT") == 0 || strcmp(arg, "-MQ") == 0) {
+      i++;  // Output locations do not affect the object
+      continue;
+    }
+    if (strcmp(arg, "-MD") == 0 || strcmp(arg, "-MMD") == 0 || strcmp(arg, "-MP") == 0) {
+      continue;
+    }
+    if (arg[0] != '-' && (i == 0 || !takes_value(compile_argv[i - 1]))) {
+      continue;  // The source path is already covered by the line markers
+    }
+    hash_normalized(&ctx, arg, strlen(arg) + 1, project_root);
+  }
+  if (split_dwarf) {
+    // The object records the name of its .dwo file
+    hash_normalized(&ctx, object, strlen(object) + 1, project_root);
+  }
+  hash_preprocessed(&ctx, preprocessed, preprocessed_length, project_root);
+  free(preprocessed);
+
+  char key[65];
+  sha256_hex(&ctx, key);
+
+  char entry[1200], dwo_entry[1200], dwo[1100];
+  entry_path(root, key, ".o", entry, sizeof(entry));
+  entry_path(root, key, ".dwo", dwo_entry, sizeof(dwo_entry));
+  dwo_path_for(object, dwo, sizeof(dwo));
+
+  if (file_exists(entry) && (!split_dwarf || file_exists(dwo_entry)) &&
+      materialize(entry, object) == 0 && (!split_dwarf || materialize(dwo_entry, dwo) == 0)) {
+    replay_diagnostics(root, key);
+    record_stat(root, CACHE_LOCAL_HIT);
+    free(root);
+    arg_list_free(&command);
+    return 0;
+  }
+
+  // Miss: compile for real. Remove the old output first so a hardlinked
+  // cache entry is never written through.
+  remove(object);
+  if (split_dwarf) {
+    remove(dwo);
+  }
+  char *diagnostics = NULL;
+  size_t diagnostics_length = 0;
+  int remote_hit = 0;
+  int result;
+
+  // The remote protocol carries a single object, not its .dwo
+  char *url = split_dwarf ? NULL : cache_remote_url();
+#ifndef _WIN32
+  if (url) {
+    result = compile_racing_remote(compile_argv, object, url, key,
+                                   &diagnostics, &diagnostics_length, &remote_hit);
+  } else
+#endif
+  {
+    result = run_process_capture(compile_argv, NULL, NULL, &diagnostics, &diagnostics_length);
+  }
+
+  if (diagnostics) {
+    fputs(diagnostics, stderr);
+  }
+
+  if (result == 0) {
+    store_entry(root, key, object, split_dwarf ? dwo : NULL, diagnostics, diagnostics_length);
+#ifndef _WIN32
+    if (url && !remote_hit) {
+      upload_async(url, key, object, diagnostics, diagnostics_length);
+    }
+#endif
+  }
+  record_stat(root, remote_hit ? CACHE_REMOTE_HIT : CACHE_MISS);
+
+  free(url);
+  free(diagnostics);
+  free(root);
+  arg_list_free(&command);
+  return result;
+}
+
+// ---------------------------------------------------------------------------
+// Maintenance
+
+static void measure_entries(const char *root, long long *count, long long *bytes) {
+  char objects[1100];
+  snprintf(objects, sizeof(objects), "%s/objects", root);
+
+  struct arg_list files;
+  arg_list_init(&files);
+  list_files_recursive(objects, ".o", &files);
+
+  *count = files.count;
+  *bytes = 0;
+  for (int i = 0; i < files.count; i++) {
+    struct stat info;
+    if (stat(files.items[i], &info) == 0) {
+      *bytes += info.st_size;
+    }
+  }
+  arg_list_free(&files);
+}
+
+int cache_print_stats(void) {
+  char *root = cache_directory();
+  if (!root) {
+    fprintf(stderr, "❌ Error: Could not determine the cache directory (set SBOR_CACHE_DIR).\n");
+    return 1;
+  }
+
+  char stats_path[1100];
+  snprintf(stats_path, sizeof(stats_path), "%s/stats", root);
+  char *stats_text = read_file_contents(stats_path);
+  struct cache_stats stats;
+  parse_stats(stats_text ? stats_text : "", &stats);
+  free(stats_text);
+
+  long long entries = 0, bytes = 0;
+  measure_entries(root, &entries, &bytes);
+
+  char *url = cache_remote_url();
+  long long hits = stats.hits + stats.remote_hits;
+  long long total = hits + stats.misses;
+  printf("📦 sbor object cache\n");
+  printf("   Location:  %s\n", root);
+  printf("   Remote:    %s\n", url ? url : "(none)");
+  printf("   Entries:   %lld (%.1f MiB)\n", entries, bytes / (1024.0 * 1024.0));
+  printf("   Hits:      %lld (local %lld, remote %lld)\n", hits, stats.hits, stats.remote_hits);
+  printf("   Misses:    %lld\n", stats.misses);
+  if (total > 0) {
+    printf("   Hit rate:  %.1f%%\n", 100.0 * hits / total);
+  } else {
+    printf("   Hit rate:  n/a\n");
+  }
+  free(url);
+
+  free(root);
+  return 0;
+}
+
+int cache_clear(void) {
+  char *root = cache_directory();
+  if (!root) {
+    fprintf(stderr, "❌ Error: Could not determine the cache directory (set SBOR_CACHE_DIR).\n");
+    return 1;
+  }
+
+  char objects[1100], stats[1100];
+  snprintf(objects, sizeof(objects), "%s/objects", root);
+  snprintf(stats, sizeof(stats), "%s/stats", root);
+
+  int result = file_exists(objects) ? remove_directory(objects) : 0;
+  remove(stats);
+
+  if (result == 0) {
+    printf("🧹 Cleared object cache at %s\n", root);
+  } else {
+    fprintf(stderr, "❌ Error: Failed to clear %s\n", objects);
+  }
+  free(root);
+  return result == 0 ? 0 : 1;
+}
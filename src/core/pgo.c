@@ -0,0 +1,254 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+  #include <unistd.h>
+#endif
+
+#include "../include/commands.h"
+
+// Profile-guided optimization: `sbor build --pgo`.
+//
+//   1. Build the profile with -fprofile-generate into <output_dir>/<profile>-pgo-gen/
+//   2. Run the instrumented binary with the "training" arguments from sbor.conf
+//   3. Merge the raw profiles (clang only; gcc accumulates .gcda files itself)
+//   4. Rebuild <output_dir>/<profile>/ with -fprofile-use
+//
+// The profile data is stamped with a hash of the sources it was trained on.
+// A later --pgo build reuses it while the sources are unchanged and retrains
+// when they differ.
+
+static int is_clang(const char *compiler) {
+  return strstr(compiler, "clang") != NULL;
+}
+
+// Absolute directory of the instrumented tree, and the profile data inside it
+static void pgo_paths(const struct project_config *config, const char *profile_name,
+                      char *tree, size_t tree_size, char *data, size_t data_size) {
+  char root[1024];
+  if (getcwd(root, sizeof(root)) == NULL) {
+    root[0] = '\0';
+  }
+  snprintf(tree, tree_size, "%s/%s/%s-pgo-gen", root, config->output_dir, profile_name);
+  snprintf(data, data_size, "%s/profiles", tree);
+}
+
+// Add the instrumentation or optimization flags for the current PGO phase.
+// Called by load_build_profile from the project root.
+void pgo_apply_flags(const struct build_options *opts, const struct project_config *config,
+                     struct build_profile *profile) {
+  char tree[1100], data[1200], root[1024];
+  pgo_paths(config, profile->name, tree, sizeof(tree), data, sizeof(data));
+  if (getcwd(root, sizeof(root)) == NULL) {
+    root[0] = '\0';
+  }
+  int clang = is_clang(config->compiler);
+
+  if (opts->pgo_phase == PGO_GENERATE) {
+    size_t size = strlen(config->output_dir) + strlen(profile->name) + 16;
+    free(profile->directory);
+    profile->directory = malloc(size);
+    snprintf(profile->directory, size, "%s/%s-pgo-gen", config->output_dir, profile->name);
+
+    arg_list_pushf(&profile->flags, "-fprofile-generate=%s", data);
+    arg_list_pushf(&profile->link_flags, "-fprofile-generate=%s", data);
+    if (!clang) {
+      // Name .gcda files relative to the build tree, so the -fprofile-use
+      // build in a different tree finds them
+      arg_list_pushf(&profile->flags, "-fprofile-prefix-path=%s", tree);
+      arg_list_push(&profile->flags, "-fprofile-update=atomic");
+    }
+  } else if (opts->pgo_phase == PGO_USE) {
+    if (clang) {
+      arg_list_pushf(&profile->flags, "-fprofile-use=%s/merged.profdata", data);
+      arg_list_push(&profile->flags, "-Wno-profile-instr-unprofiled");
+    } else {
+      arg_list_pushf(&profile->flags, "-fprofile-use=%s", data);
+      arg_list_pushf(&profile->flags, "-fprofile-prefix-path=%s/%s", root, profile->directory);
+      arg_list_push(&profile->flags, "-Wno-missing-profile");
+    }
+  }
+}
+
+// Fingerprint of everything the training profile depends on
+static unsigned long long sources_fingerprint(void) {
+  struct arg_list files;
+  arg_list_init(&files);
+  list_files_recursive("src", ".c", &files);
+  list_files_recursive("src", ".h", &files);
+
+  unsigned long long hash = HASH_SEED;
+  for (int i = 0; i < files.count; i++) {
+    hash = hash_string(hash, files.items[i]);
+    hash = hash_file(hash, files.items[i]);
+  }
+  hash = hash_file(hash, "sbor.conf");
+  arg_list_free(&files);
+  return hash;
+}
+
+// Read the "training" section of sbor.conf: the workload arguments go into
+// `args`, and the number of runs is returned. Shared with the BOLT stage.
+int load_training_config(const char *exe_path, struct arg_list *args) {
+  arg_list_init(args);
+  if (get_config_list("training", "args", args) < 0) {
+    printf("   ⚠️  No training.args in sbor.conf, running %s without arguments.\n", exe_path);
+    printf("   💡 Add \"training\": { \"args\": [...] } with a representative workload.\n");
+  }
+
+  char *runs_value = get_config_value("training", "runs");
+  int runs = runs_value ? atoi(runs_value) : 1;
+  free(runs_value);
+  return runs < 1 ? 1 : runs;
+}
+
+// Run the instrumented binary with the training arguments from sbor.conf
+static int run_training(const char *directory, const char *name) {
+  char *exe_path = find_executable(directory, name);
+  if (!exe_path) {
+    fprintf(stderr, "❌ Error: Could not find the instrumented executable in %s/\n", directory);
+    return 1;
+  }
+
+  struct arg_list args;
+  int runs = load_training_config(exe_path, &args);
+
+  int result = 0;
+  for (int run = 1; run <= runs && result == 0; run++) {
+    printf("   🏋️  Training run %d/%d: %s", run, runs, exe_path);
+    for (int i = 0; i < args.count; i++) {
+      printf(" %s", args.items[i]);
+    }
+    printf("\n");
+    fflush(stdout);
+
+    int exit_code = execute_binary_quiet(exe_path, args.count, args.items);
+    if (exit_code != 0) {
+      fprintf(stderr, "❌ Error: Training run failed (exit code: %d)\n", exit_code);
+      result = 1;
+    }
+  }
+
+  arg_list_free(&args);
+  free(exe_path);
+  return result;
+}
+
+// llvm-profdata merge for clang; gcc needs no merge step
+static int merge_profiles(const struct project_config *config, const char *data) {
+  struct arg_list raw;
+  arg_list_init(&raw);
+  int count = list_files_recursive(data, is_clang(config->compiler) ? ".profraw" : ".gcda", &raw);
+  if (count == 0) {
+    fprintf(stderr, "❌ Error: Training produced no profile data in %s\n", data);
+    arg_list_free(&raw);
+    return 1;
+  }
+
+  if (!is_clang(config->compiler)) {
+    printf("   📊 Collected %d .gcda profile%s\n", count, count == 1 ? "" : "s");
+    arg_list_free(&raw);
+    return 0;
+  }
+
+  const char *env = getenv("LLVM_PROFDATA");
+  char *tool = env && *env ? strdup(env) : find_program("llvm-profdata");
+  if (!tool) {
+    fprintf(stderr, "❌ Error: llvm-profdata not found (set $LLVM_PROFDATA to its path)\n");
+    arg_list_free(&raw);
+    return 1;
+  }
+
+  struct arg_list command;
+  arg_list_init(&command);
+  arg_list_push(&command, tool);
+  arg_list_push(&command, "merge");
+  arg_list_pushf(&command, "-output=%s/merged.profdata", data);
+  for (int i = 0; i < raw.count; i++) {
+    arg_list_push(&command, raw.items[i]);
+  }
+
+  printf("   📊 Merging %d raw profile%s with %s\n", count, count == 1 ? "" : "s", tool);
+  int result = run_process(command.items);
+  if (result != 0) {
+    fprintf(stderr, "❌ Error: llvm-profdata merge failed (exit code: %d)\n", result);
+  }
+
+  arg_list_free(&command);
+  arg_list_free(&raw);
+  free(tool);
+  return result == 0 ? 0 : 1;
+}
+
+int pgo_build(const struct build_options *opts) {
+  struct project_config config;
+  if (load_project_config(&config) != 0) {
+    fprintf(stderr, "❌ Error: Could not load the project configuration from sbor.conf.\n");
+    return 1;
+  }
+  char *profile_name = selected_profile_name(opts);
+
+  char tree[1100], data[1200], stamp_path[1300], relative_tree[1100];
+  pgo_paths(&config, profile_name, tree, sizeof(tree), data, sizeof(data));
+  snprintf(stamp_path, sizeof(stamp_path), "%s/sources.stamp", data);
+  snprintf(relative_tree, sizeof(relative_tree), "%s/%s-pgo-gen", config.output_dir, profile_name);
+
+  char expected[64];
+  snprintf(expected, sizeof(expected), "sources=%016llx\n", sources_fingerprint());
+
+  printf("📈 Profile-guided build of the %s profile\n\n", profile_name);
+
+  struct build_options phase = *opts;
+  phase.pgo = 0;
+  int result = 0;
+
+  char *previous = read_file_contents(stamp_path);
+  int reuse = previous && strcmp(previous, expected) == 0;
+  if (reuse) {
+    printf("♻️  Reusing training profiles from %s (sources unchanged)\n\n", data);
+  } else {
+    if (previous) {
+      printf("⚠️  Training profiles are stale (sources changed since training), retraining...\n\n");
+    }
+
+    // Old counters would be merged into the new run, so start from scratch
+    remove_directory(data);
+    make_directories(data);
+
+    printf("🧪 Step 1/3: Instrumented build\n");
+    phase.pgo_phase = PGO_GENERATE;
+    phase.bolt = 0;  // --bolt applies to the optimized binary only
+    result = build_project(&phase);
+
+    if (result == 0) {
+      printf("\n🏋️  Step 2/3: Training\n");
+      result = run_training(relative_tree, config.name);
+    }
+    if (result == 0) {
+      result = merge_profiles(&config, data);
+    }
+    if (result == 0) {
+      create_file_with_content(stamp_path, expected);
+    }
+    printf("\n");
+  }
+  free(previous);
+
+  if (result == 0) {
+    printf("🚀 Step 3/3: Optimized build with profile data\n");
+    phase.pgo_phase = PGO_USE;
+    phase.bolt = opts->bolt;
+    result = build_project(&phase);
+  }
+
+  if (result == 0) {
+    printf("📈 PGO build complete. Training profiles: %s\n", data);
+  } else {
+    fprintf(stderr, "❌ Error: Profile-guided build failed.\n");
+  }
+
+  free(profile_name);
+  free_project_config(&config);
+  return result;
+}
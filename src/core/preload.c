@@ -0,0 +1,312 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __linux__
+  #include <elf.h>
+  #include <unistd.h>
+#endif
+
+#include "../include/commands.h"
+
+// Support for the LD_PRELOAD helpers sbor ships: the sampler of `sbor
+// profile` and the allocation shim of `sbor run --alloc`. Their C source is
+// embedded in sbor, compiled on first use with the project's compiler and
+// handed its output path through the environment.
+// Both report raw code addresses plus a small header:
+//
+//   bias <load bias of the executable>
+//   range <start> <end>            the executable's mapped code and data
+//   sym <address> <name>           addresses in shared libraries (dladdr)
+//
+// which are resolved here against the executable's ELF symbol table.
+
+#ifdef __linux__
+
+// Write <work_dir>/<name>.c from `source` (NULL-terminated lines) and
+// compile it into <name>.so, unless an up-to-date build of the same source is
+// already there. Returns the library's absolute path.
+char* build_preload_library(const struct project_config *config, const char *work_dir,
+                            const char *name, const char *const source[]) {
+  char root[1024];
+  if (getcwd(root, sizeof(root)) == NULL) {
+    return NULL;
+  }
+  char source_path[1400], library_path[1400];
+  snprintf(source_path, sizeof(source_path), "%s/%s/%s.c", root, work_dir, name);
+  snprintf(library_path, sizeof(library_path), "%s/%s/%s.so", root, work_dir, name);
+
+  size_t length = 1;
+  for (int i = 0; source[i]; i++) {
+    length += strlen(source[i]);
+  }
+  char *text = malloc(length);
+  text[0] = '\0';
+  for (int i = 0; source[i]; i++) {
+    strcat(text, source[i]);
+  }
+
+  char *existing = read_file_contents(source_path);
+  int changed = !existing || strcmp(existing, text) != 0;
+  free(existing);
+  if (changed && create_file_with_content(source_path, text) != 0) {
+    free(text);
+    return NULL;
+  }
+  free(text);
+
+  if (!changed && file_exists(library_path)) {
+    return strdup(library_path);
+  }
+
+  char *command[] = { config->compiler, "-shared", "-fPIC", "-O2", "-o", library_path,
+                      source_path, "-ldl", "-pthread", NULL };
+  if (run_process(command) != 0) {
+    fprintf(stderr, "❌ Error: Failed to compile %s\n", source_path);
+    remove(library_path);
+    return NULL;
+  }
+  return strdup(library_path);
+}
+
+struct symbol {
+  unsigned long long address;
+  unsigned long long size;
+  char *name;
+};
+
+struct symbol_table {
+  struct symbol *items;
+  int count;
+  int capacity;
+};
+
+static void push_symbol(struct symbol_table *table, unsigned long long address,
+                        unsigned long long size, const char *name) {
+  if (table->count == table->capacity) {
+    table->capacity = table->capacity ? table->capacity * 2 : 256;
+    table->items = realloc(table->items, table->capacity * sizeof(struct symbol));
+  }
+  table->items[table->count].address = address;
+  table->items[table->count].size = size;
+  table->items[table->count].name = strdup(name);
+  table->count++;
+}
+
+static int compare_symbols(const void *a, const void *b) {
+  const struct symbol *x = a, *y = b;
+  return (x->address > y->address) - (x->address < y->address);
+}
+
+static void free_symbols(struct symbol_table *table) {
+  for (int i = 0; i < table->count; i++) {
+    free(table->items[i].name);
+  }
+  free(table->items);
+  memset(table, 0, sizeof(*table));
+}
+
+// The function symbols of a 64-bit ELF file: .symtab, or .dynsym when the
+// binary is stripped. Sorted by address.
+static int load_symbols(const char *path, struct symbol_table *table) {
+  memset(table, 0, sizeof(*table));
+  FILE *file = fopen(path, "rb");
+  if (!file) {
+    return -1;
+  }
+
+  Elf64_Ehdr header;
+  if (fread(&header, sizeof(header), 1, file) != 1 ||
+      memcmp(header.e_ident, ELFMAG, SELFMAG) != 0 || header.e_ident[EI_CLASS] != ELFCLASS64 ||
+      header.e_shentsize != sizeof(Elf64_Shdr) || header.e_shnum == 0) {
+    fclose(file);
+    return -1;
+  }
+
+  Elf64_Shdr *sections = malloc(header.e_shnum * sizeof(Elf64_Shdr));
+  fseek(file, header.e_shoff, SEEK_SET);
+  if (fread(sections, sizeof(Elf64_Shdr), header.e_shnum, file) != header.e_shnum) {
+    free(sections);
+    fclose(file);
+    return -1;
+  }
+
+  int symtab = -1;
+  for (int i = 0; i < header.e_shnum; i++) {
+    if (sections[i].sh_type == SHT_SYMTAB || (sections[i].sh_type == SHT_DYNSYM && symtab < 0)) {
+      symtab = i;
+    }
+  }
+  if (symtab < 0 || sections[symtab].sh_link >= header.e_shnum) {
+    free(sections);
+    fclose(file);
+    return -1;
+  }
+
+  Elf64_Shdr *strings = &sections[sections[symtab].sh_link];
+  char *names = malloc(strings->sh_size + 1);
+  size_t symbol_count = sections[symtab].sh_size / sizeof(Elf64_Sym);
+  Elf64_Sym *symbols = malloc(symbol_count * sizeof(Elf64_Sym) + 1);
+  int ok = fseek(file, strings->sh_offset, SEEK_SET) == 0 &&
+           fread(names, 1, strings->sh_size, file) == strings->sh_size &&
+           fseek(file, sections[symtab].sh_offset, SEEK_SET) == 0 &&
+           fread(symbols, sizeof(Elf64_Sym), symbol_count, file) == symbol_count;
+  names[strings->sh_size] = '\0';
+
+  for (size_t i = 0; ok && i < symbol_count; i++) {
+    if (ELF64_ST_TYPE(symbols[i].st_info) == STT_FUNC && symbols[i].st_value != 0 &&
+        symbols[i].st_name < strings->sh_size) {
+      push_symbol(table, symbols[i].st_value, symbols[i].st_size, names + symbols[i].st_name);
+    }
+  }
+  qsort(table->items, table->count, sizeof(struct symbol), compare_symbols);
+
+  free(symbols);
+  free(names);
+  free(sections);
+  fclose(file);
+  return ok ? 0 : -1;
+}
+
+// The symbol covering `address`, NULL if there is none
+static const struct symbol* lookup_symbol(const struct symbol_table *table, unsigned long long address) {
+  int low = 0, high = table->count - 1, found = -1;
+  while (low <= high) {
+    int middle = low + (high - low) / 2;
+    if (table->items[middle].address <= address) {
+      found = middle;
+      low = middle + 1;
+    } else {
+      high = middle - 1;
+    }
+  }
+  if (found < 0) {
+    return NULL;
+  }
+  const struct symbol *symbol = &table->items[found];
+  if (symbol->size && address >= symbol->address + symbol->size) {
+    return NULL;
+  }
+  return symbol;
+}
+
+
+// Run argv with `library` preloaded, ahead of any LD_PRELOAD the user
+// already has. Returns the exit code.
+int run_preloaded(char *const argv[], const char *library) {
+  const char *existing = getenv("LD_PRELOAD");
+  char *saved = existing ? strdup(existing) : NULL;
+  size_t length = strlen(library) + (saved ? strlen(saved) : 0) + 2;
+  char *preload = malloc(length);
+  snprintf(preload, length, "%s%s%s", library, saved ? ":" : "", saved ? saved : "");
+
+  setenv("LD_PRELOAD", preload, 1);
+  fflush(stdout);
+  int exit_code = run_process(argv);
+  if (saved) {
+    setenv("LD_PRELOAD", saved, 1);
+  } else {
+    unsetenv("LD_PRELOAD");
+  }
+  free(preload);
+  free(saved);
+  return exit_code;
+}
+
+struct address_map {
+  struct symbol_table symbols;    // The executable's functions
+  struct symbol_table libraries;  // "sym" lines
+  unsigned long long bias, start, end;
+};
+
+// Read the header and "sym" lines of a helper's report and the symbols of
+// `exe_path`. Never fails: unknown addresses simply stay unresolved.
+struct address_map* load_address_map(const char *report, const char *exe_path) {
+  struct address_map *map = calloc(1, sizeof(struct address_map));
+  if (load_symbols(exe_path, &map->symbols) != 0) {
+    printf("   ⚠️  No symbol table in %s, code will show as addresses.\n", exe_path);
+  }
+
+  for (const char *line = report; line && *line;) {
+    const char *next = strchr(line, '\n');
+    char name[512];
+    unsigned long long address;
+    if (sscanf(line, "bias %llx", &map->bias) == 1 ||
+        sscanf(line, "range %llx %llx", &map->start, &map->end) == 2) {
+      // Header
+    } else if (sscanf(line, "sym %llx %511s", &address, name) == 2) {
+      push_symbol(&map->libraries, address, 1, name);
+    }
+    line = next ? next + 1 : NULL;
+  }
+  qsort(map->libraries.items, map->libraries.count, sizeof(struct symbol), compare_symbols);
+  return map;
+}
+
+// The function containing `address`, or NULL. Return addresses point after
+// the call, so with `return_address` the call itself is looked up. `offset`
+// (optional) receives the distance into the function when it is known.
+const char* resolve_address(const struct address_map *map, unsigned long long address,
+                            int return_address, unsigned long long *offset) {
+  if (offset) {
+    *offset = 0;
+  }
+  if (address < map->start || address >= map->end) {
+    const struct symbol *symbol = lookup_symbol(&map->libraries, address);
+    return symbol ? symbol->name : NULL;
+  }
+  unsigned long long relative = address - map->bias - (return_address ? 1 : 0);
+  const struct symbol *symbol = lookup_symbol(&map->symbols, relative);
+  if (symbol && offset) {
+    *offset = relative + (return_address ? 1 : 0) - symbol->address;
+  }
+  return symbol ? symbol->name : NULL;
+}
+
+void free_address_map(struct address_map *map) {
+  if (!map) {
+    return;
+  }
+  free_symbols(&map->symbols);
+  free_symbols(&map->libraries);
+  free(map);
+}
+
+#else
+
+char* build_preload_library(const struct project_config *config, const char *work_dir,
+                            const char *name, const char *const source[]) {
+  (void)config;
+  (void)work_dir;
+  (void)name;
+  (void)source;
+  return NULL;
+}
+
+int run_preloaded(char *const argv[], const char *library) {
+  (void)library;
+  return run_process(argv);
+}
+
+struct address_map* load_address_map(const char *report, const char *exe_path) {
+  (void)report;
+  (void)exe_path;
+  return NULL;
+}
+
+const char* resolve_address(const struct address_map *map, unsigned long long address,
+                            int return_address, unsigned long long *offset) {
+  (void)map;
+  (void)address;
+  (void)return_address;
+  if (offset) {
+    *offset = 0;
+  }
+  return NULL;
+}
+
+void free_address_map(struct address_map *map) {
+  (void)map;
+}
+
+#endif
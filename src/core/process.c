@@ -0,0 +1,380 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+
+#ifdef _WIN32
+  #include <process.h>
+  #include <io.h>
+  #define dup _dup
+  #define dup2 _dup2
+  #define close _close
+  #define STDOUT_FILENO 1
+#else
+  #include <spawn.h>
+  #include <signal.h>
+  #include <fcntl.h>
+  #include <poll.h>
+  #include <unistd.h>
+  #include <sys/types.h>
+  #include <sys/wait.h>
+  extern char **environ;
+#endif
+
+#include "../include/commands.h"
+
+// Argument vector helpers.
+// The vector is always NULL-terminated so it can be handed to exec/spawn.
+
+void arg_list_init(struct arg_list *list) {
+  list->count = 0;
+  list->capacity = 8;
+  list->items = malloc(list->capacity * sizeof(char *));
+  list->items[0] = NULL;
+}
+
+void arg_list_push(struct arg_list *list, const char *arg) {
+  if (list->count + 1 >= list->capacity) {
+    list->capacity *= 2;
+    list->items = realloc(list->items, list->capacity * sizeof(char *));
+  }
+  list->items[list->count++] = strdup(arg);
+  list->items[list->count] = NULL;
+}
+
+void arg_list_pushf(struct arg_list *list, const char *format, ...) {
+  char buffer[4096];
+  va_list args;
+  va_start(args, format);
+  vsnprintf(buffer, sizeof(buffer), format, args);
+  va_end(args);
+  arg_list_push(list, buffer);
+}
+
+void arg_list_free(struct arg_list *list) {
+  for (int i = 0; i < list->count; i++) {
+    free(list->items[i]);
+  }
+  free(list->items);
+  list->items = NULL;
+  list->count = 0;
+  list->capacity = 0;
+}
+
+// Hash an argument vector, e.g. to detect changed compile commands
+unsigned long long hash_arg_list(unsigned long long hash, const struct arg_list *list) {
+  for (int i = 0; i < list->count; i++) {
+    hash = hash_string(hash, list->items[i]);
+  }
+  return hash;
+}
+
+// Start a program without waiting for it. The program is looked up on PATH.
+// Returns 0 on success and stores the child in *process.
+int spawn_process(char *const argv[], process_t *process) {
+#ifdef _WIN32
+  intptr_t handle = _spawnvp(_P_NOWAIT, argv[0], (const char *const *)argv);
+  if (handle == -1) {
+    return -1;
+  }
+  *process = handle;
+  return 0;
+#else
+  pid_t pid;
+  int result = posix_spawnp(&pid, argv[0], NULL, NULL, argv, environ);
+  if (result != 0) {
+    return -1;
+  }
+  *process = pid;
+  return 0;
+#endif
+}
+
+// Like spawn_process, but with stdout and/or stderr sent to files.
+// Pass NULL to leave a stream attached to ours.
+int spawn_process_redirected(char *const argv[], const char *stdout_path,
+                             const char *stderr_path, process_t *process) {
+#ifdef _WIN32
+  (void)stdout_path;
+  (void)stderr_path;
+  return spawn_process(argv, process);
+#else
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  if (stdout_path) {
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, stdout_path,
+                                     O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  }
+  if (stderr_path) {
+    posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, stderr_path,
+                                     O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  }
+
+  pid_t pid;
+  int result = posix_spawnp(&pid, argv[0], &actions, NULL, argv, environ);
+  posix_spawn_file_actions_destroy(&actions);
+  if (result != 0) {
+    return -1;
+  }
+  *process = pid;
+  return 0;
+#endif
+}
+
+// Point our stdout, and that of every child started from now on, at `fd`.
+// Returns a copy of the previous stdout for restore_stdout(), or -1.
+int redirect_stdout(int fd) {
+  fflush(stdout);
+  int saved = dup(STDOUT_FILENO);
+  if (saved < 0 || dup2(fd, STDOUT_FILENO) < 0) {
+    if (saved >= 0) close(saved);
+    return -1;
+  }
+  return saved;
+}
+
+// Undo redirect_stdout()
+void restore_stdout(int saved) {
+  if (saved < 0) {
+    return;
+  }
+  fflush(stdout);
+  dup2(saved, STDOUT_FILENO);
+  close(saved);
+}
+
+// Convert a raw wait status into an exit code (-1 if the child did not exit normally)
+int process_exit_code(int status) {
+#ifdef _WIN32
+  return status;
+#else
+  if (WIFEXITED(status)) {
+    return WEXITSTATUS(status);
+  }
+  return -1;
+#endif
+}
+
+// Wait for a child started with spawn_process and return its exit code
+int wait_process(process_t process) {
+#ifdef _WIN32
+  int status = 0;
+  if (_cwait(&status, process, 0) == -1) {
+    return -1;
+  }
+  return status;
+#else
+  int status;
+  if (waitpid(process, &status, 0) < 0) {
+    return -1;
+  }
+  return process_exit_code(status);
+#endif
+}
+
+// Run a program to completion and return its exit code
+int run_process(char *const argv[]) {
+  process_t process;
+  if (spawn_process(argv, &process) != 0) {
+    fprintf(stderr, "❌ Error: Failed to start '%s'\n", argv[0]);
+    return -1;
+  }
+  return wait_process(process);
+}
+
+// Run a program in the foreground, the way a shell would: its path is used
+// as given, it gets our terminal, and Ctrl-C or Ctrl-\ reach it rather than
+// us. Returns its exit code, or -1 if it could not be started. A program
+// killed by a signal returns 128 + the signal and stores it in *signal_number.
+int run_foreground(char *const argv[], int *signal_number) {
+  *signal_number = 0;
+#ifdef _WIN32
+  intptr_t result = _spawnv(_P_WAIT, argv[0], (const char *const *)argv);
+  return result == -1 ? -1 : (int)result;
+#else
+  struct sigaction ignore, old_interrupt, old_quit;
+  memset(&ignore, 0, sizeof(ignore));
+  ignore.sa_handler = SIG_IGN;
+  sigemptyset(&ignore.sa_mask);
+  sigaction(SIGINT, &ignore, &old_interrupt);
+  sigaction(SIGQUIT, &ignore, &old_quit);
+
+  // The child starts with default handling whatever we ignore
+  posix_spawnattr_t attributes;
+  posix_spawnattr_init(&attributes);
+  sigset_t defaults;
+  sigemptyset(&defaults);
+  sigaddset(&defaults, SIGINT);
+  sigaddset(&defaults, SIGQUIT);
+  posix_spawnattr_setsigdefault(&attributes, &defaults);
+  posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETSIGDEF);
+
+  fflush(stdout);
+  fflush(stderr);
+  pid_t pid;
+  int spawned = posix_spawn(&pid, argv[0], NULL, &attributes, argv, environ);
+  posix_spawnattr_destroy(&attributes);
+
+  int exit_code = -1;
+  if (spawned == 0) {
+    int status;
+    while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+    }
+    if (WIFSIGNALED(status)) {
+      *signal_number = WTERMSIG(status);
+      exit_code = 128 + *signal_number;
+    } else {
+      exit_code = process_exit_code(status);
+    }
+  } else {
+    fprintf(stderr, "❌ Error: Failed to start '%s': %s\n", argv[0], strerror(spawned));
+  }
+
+  sigaction(SIGINT, &old_interrupt, NULL);
+  sigaction(SIGQUIT, &old_quit, NULL);
+  return exit_code;
+#endif
+}
+
+// Replace this process with `argv`, so its exit code and signals are the
+// caller's own. Only returns if the program could not be started.
+int exec_program(char *const argv[]) {
+  fflush(stdout);
+  fflush(stderr);
+#ifdef _WIN32
+  // Windows has no real exec; wait for the program and exit with its code
+  int signal_number;
+  int exit_code = run_foreground(argv, &signal_number);
+  if (exit_code >= 0) {
+    exit(exit_code);
+  }
+  return -1;
+#else
+  execv(argv[0], argv);
+  fprintf(stderr, "❌ Error: Failed to start '%s': %s\n", argv[0], strerror(errno));
+  return -1;
+#endif
+}
+
+// Die from the signal that killed a foreground program, so whoever started
+// sbor sees the same termination as if it had run the program itself
+void raise_signal(int signal_number) {
+#ifdef _WIN32
+  (void)signal_number;
+#else
+  if (signal_number > 0) {
+    fflush(stdout);
+    fflush(stderr);
+    signal(signal_number, SIG_DFL);
+    raise(signal_number);
+  }
+#endif
+}
+
+#ifndef _WIN32
+// Append everything currently readable from `fd` to a growing buffer.
+// Returns 0 at end of file, 1 if more data may follow.
+static int drain_pipe(int fd, char **buffer, size_t *length, size_t *capacity) {
+  char chunk[65536];
+  ssize_t got = read(fd, chunk, sizeof(chunk));
+  if (got < 0 && errno == EINTR) {
+    return 1;
+  }
+  if (got <= 0) {
+    return 0;
+  }
+  if (*length + got + 1 > *capacity) {
+    while (*length + got + 1 > *capacity) {
+      *capacity = *capacity ? *capacity * 2 : 65536;
+    }
+    *buffer = realloc(*buffer, *capacity);
+  }
+  memcpy(*buffer + *length, chunk, got);
+  *length += got;
+  (*buffer)[*length] = '\0';
+  return 1;
+}
+#endif
+
+// Run a program to completion, collecting its stdout and/or stderr.
+// Pass NULL for a stream to leave it attached to ours. Captured buffers are
+// NUL-terminated and must be freed by the caller. Returns the exit code.
+int run_process_capture(char *const argv[], char **out, size_t *out_length,
+                        char **err, size_t *err_length) {
+#ifdef _WIN32
+  (void)out; (void)out_length; (void)err; (void)err_length;
+  return run_process(argv);
+#else
+  int out_pipe[2] = {-1, -1};
+  int err_pipe[2] = {-1, -1};
+  if ((out && pipe(out_pipe) != 0) || (err && pipe(err_pipe) != 0)) {
+    return -1;
+  }
+
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  if (out) {
+    posix_spawn_file_actions_adddup2(&actions, out_pipe[1], STDOUT_FILENO);
+    posix_spawn_file_actions_addclose(&actions, out_pipe[0]);
+    posix_spawn_file_actions_addclose(&actions, out_pipe[1]);
+  }
+  if (err) {
+    posix_spawn_file_actions_adddup2(&actions, err_pipe[1], STDERR_FILENO);
+    posix_spawn_file_actions_addclose(&actions, err_pipe[0]);
+    posix_spawn_file_actions_addclose(&actions, err_pipe[1]);
+  }
+
+  pid_t pid;
+  int spawned = posix_spawnp(&pid, argv[0], &actions, NULL, argv, environ);
+  posix_spawn_file_actions_destroy(&actions);
+
+  if (out) close(out_pipe[1]);
+  if (err) close(err_pipe[1]);
+
+  size_t out_capacity = 0, err_capacity = 0;
+  if (out) { *out = NULL; *out_length = 0; }
+  if (err) { *err = NULL; *err_length = 0; }
+
+  if (spawned != 0) {
+    if (out) close(out_pipe[0]);
+    if (err) close(err_pipe[0]);
+    return -1;
+  }
+
+  // Read both pipes together so a chatty child can never block on a full pipe
+  int out_open = out != NULL;
+  int err_open = err != NULL;
+  while (out_open || err_open) {
+    struct pollfd fds[2];
+    int count = 0;
+    if (out_open) { fds[count].fd = out_pipe[0]; fds[count].events = POLLIN; count++; }
+    if (err_open) { fds[count].fd = err_pipe[0]; fds[count].events = POLLIN; count++; }
+
+    if (poll(fds, count, -1) < 0) {
+      continue;
+    }
+    for (int i = 0; i < count; i++) {
+      if (!(fds[i].revents & (POLLIN | POLLHUP | POLLERR))) {
+        continue;
+      }
+      if (out_open && fds[i].fd == out_pipe[0]) {
+        out_open = drain_pipe(out_pipe[0], out, out_length, &out_capacity);
+      } else if (err_open && fds[i].fd == err_pipe[0]) {
+        err_open = drain_pipe(err_pipe[0], err, err_length, &err_capacity);
+      }
+    }
+  }
+
+  if (out) {
+    close(out_pipe[0]);
+    if (!*out) *out = calloc(1, 1);
+  }
+  if (err) {
+    close(err_pipe[0]);
+    if (!*err) *err = calloc(1, 1);
+  }
+
+  return wait_process(pid);
+#endif
+}
@@ -0,0 +1,253 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+  #include <unistd.h>
+#endif
+
+#include "../include/commands.h"
+
+// Build profiles, in the spirit of cargo's: a named set of optimization
+// flags selected with --profile/--release or build.profile in sbor.conf.
+//
+// Every profile builds into its own tree, <output_dir>/<name>/, so switching
+// between them never invalidates the other's objects. A profile can be
+// customised (or a new one defined) in sbor.conf:
+//
+//   "profiles": {
+//       "release": { "flags": ["-O2", "-DNDEBUG"] },
+//       "bench":   { "inherits": "release", "flags": ["-O3", "-march=native"] }
+//   }
+
+struct builtin_profile {
+  const char *name;
+  const char *build_type;   // CMake build type the profile maps to
+  const char *flags;        // Space-separated compile flags
+  const char *link_flags;   // Space-separated link flags
+};
+
+// `sbor profile` walks frame pointers, so the profiling profile keeps them
+// (leaf functions included, where the compiler supports it) plus symbols
+#if defined(__x86_64__) || defined(__aarch64__)
+  #define PROFILING_FLAGS "-O2 -g -fno-omit-frame-pointer -mno-omit-leaf-frame-pointer"
+#else
+  #define PROFILING_FLAGS "-O2 -g -fno-omit-frame-pointer"
+#endif
+
+static const struct builtin_profile builtin_profiles[] = {
+  { "dev",         "Debug",      "-O0 -g",            "" },
+  { "release",     "Release",    "-O3 -DNDEBUG",      "" },
+  { "release-lto", "Release",    "-O3 -DNDEBUG -flto", "-flto" },
+#ifdef __APPLE__
+  { "min-size",    "MinSizeRel", "-Os -DNDEBUG -ffunction-sections -fdata-sections", "-Wl,-dead_strip" },
+#else
+  { "min-size",    "MinSizeRel", "-Os -DNDEBUG -ffunction-sections -fdata-sections", "-Wl,--gc-sections" },
+#endif
+  { "profiling",   "RelWithDebInfo", PROFILING_FLAGS, "" },
+  { NULL, NULL, NULL, NULL }
+};
+
+static const struct builtin_profile* find_builtin(const char *name) {
+  for (int i = 0; builtin_profiles[i].name; i++) {
+    if (strcmp(builtin_profiles[i].name, name) == 0) {
+      return &builtin_profiles[i];
+    }
+  }
+  return NULL;
+}
+
+// Append the words of a space-separated flag string
+static void push_words(struct arg_list *list, const char *words) {
+  char *copy = strdup(words);
+  for (char *word = strtok(copy, " "); word; word = strtok(NULL, " ")) {
+    arg_list_push(list, word);
+  }
+  free(copy);
+}
+
+// Rewrite a plain -flto for the compiler in use. GCC parallelizes the LTO
+// link only when asked to (-flto=auto); clang switches to ThinLTO, whose
+// per-module results can be cached between links.
+static void select_lto_mode(struct arg_list *list, const char *compiler) {
+  const char *mode = strstr(compiler, "clang") ? "-flto=thin" : "-flto=auto";
+  for (int i = 0; i < list->count; i++) {
+    if (strcmp(list->items[i], "-flto") == 0) {
+      free(list->items[i]);
+      list->items[i] = strdup(mode);
+    }
+  }
+}
+
+static int has_flag(const struct arg_list *list, const char *flag) {
+  for (int i = 0; i < list->count; i++) {
+    if (strcmp(list->items[i], flag) == 0) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+// Debug builds write DWARF for every object into the binary. With
+// -gsplit-dwarf most of it stays in .dwo files next to the objects, and what
+// remains is compressed, so the linker copies far less. build.split_debug
+// turns this off (e.g. for debuggers without split DWARF support). It is off
+// by default when a remote object cache is set up, since split DWARF
+// compiles are only cached locally (see object_cache.c).
+static void add_split_debug(struct build_profile *profile) {
+#if defined(_WIN32) || defined(__APPLE__)
+  (void)profile;
+#else
+  int debug_info = 0;
+  for (int i = 0; i < profile->flags.count; i++) {
+    const char *flag = profile->flags.items[i];
+    if (strncmp(flag, "-g", 2) == 0 && strcmp(flag, "-g0") != 0) {
+      debug_info = 1;
+    }
+  }
+  char *remote = cache_enabled() ? cache_remote_url() : NULL;
+  int split_by_default = remote == NULL;
+  free(remote);
+  if (!debug_info || !get_config_flag("build", "split_debug", split_by_default)) {
+    return;
+  }
+  arg_list_push(&profile->flags, "-gsplit-dwarf");
+  arg_list_push(&profile->flags, "-gz");
+  arg_list_push(&profile->link_flags, "-Wl,--compress-debug-sections=zlib");
+#endif
+}
+
+// Keep ThinLTO's optimized modules in <profile dir>/lto-cache, so a relink
+// after a small edit only re-optimizes the modules that changed.
+// build.lto_cache_size bounds the cache (default 1g).
+static void add_thinlto_cache(struct build_profile *profile) {
+  char root[1024];
+  if (getcwd(root, sizeof(root)) == NULL) {
+    return;
+  }
+  char cache_dir[1400];
+  snprintf(cache_dir, sizeof(cache_dir), "%s/%s/lto-cache", root, profile->directory);
+
+  char *size = get_config_value("build", "lto_cache_size");
+  const char *limit = size && *size ? size : "1g";
+
+#ifdef __APPLE__
+  arg_list_pushf(&profile->link_flags, "-Wl,-cache_path_lto,%s", cache_dir);
+#else
+  if (profile->linker && strcmp(profile->linker, "lld") == 0) {
+    // lld understands the cache options directly
+    arg_list_pushf(&profile->link_flags, "-Wl,--thinlto-cache-dir=%s", cache_dir);
+    arg_list_pushf(&profile->link_flags, "-Wl,--thinlto-cache-policy=cache_size_bytes=%s:prune_after=168h", limit);
+  } else {
+    // Other linkers run ThinLTO through the LLVM plugin
+    arg_list_pushf(&profile->link_flags, "-Wl,-plugin-opt,cache-dir=%s", cache_dir);
+    arg_list_pushf(&profile->link_flags, "-Wl,-plugin-opt,cache-policy=cache_size_bytes=%s:prune_after=168h", limit);
+  }
+#endif
+  free(size);
+}
+
+// The profile to use: --profile/--release, then build.profile, then "dev"
+char* selected_profile_name(const struct build_options *opts) {
+  if (opts && opts->profile) {
+    return strdup(opts->profile);
+  }
+  char *configured = get_config_value("build", "profile");
+  if (configured && *configured) {
+    return configured;
+  }
+  free(configured);
+  return strdup("dev");
+}
+
+int load_build_profile(const struct build_options *opts, const struct project_config *config,
+                       struct build_profile *profile) {
+  memset(profile, 0, sizeof(*profile));
+  profile->name = selected_profile_name(opts);
+
+  // A profile defined in sbor.conf overrides or extends a built-in one
+  char section[256];
+  snprintf(section, sizeof(section), "profiles.%s", profile->name);
+  struct arg_list custom_flags, custom_link_flags;
+  arg_list_init(&custom_flags);
+  arg_list_init(&custom_link_flags);
+  int has_flags = get_config_list(section, "flags", &custom_flags) >= 0;
+  int has_link_flags = get_config_list(section, "link_flags", &custom_link_flags) >= 0;
+  char *inherits = get_config_value(section, "inherits");
+
+  const struct builtin_profile *base = find_builtin(profile->name);
+  if (!base && (has_flags || has_link_flags || inherits)) {
+    base = find_builtin(inherits ? inherits : "release");
+  }
+  if (!base) {
+    fprintf(stderr, "❌ Error: Unknown profile '%s'\n", profile->name);
+    fprintf(stderr, "   Built-in profiles: dev, release, release-lto, min-size, profiling\n");
+    fprintf(stderr, "   Define your own under \"profiles\" in sbor.conf.\n");
+    free(inherits);
+    arg_list_free(&custom_flags);
+    arg_list_free(&custom_link_flags);
+    free(profile->name);
+    profile->name = NULL;
+    return -1;
+  }
+  free(inherits);
+
+  profile->build_type = base->build_type;
+
+  // build.flags first, so the profile decides the optimization level
+  arg_list_init(&profile->flags);
+  for (int i = 0; i < config->flags.count; i++) {
+    arg_list_push(&profile->flags, config->flags.items[i]);
+  }
+  if (has_flags) {
+    for (int i = 0; i < custom_flags.count; i++) {
+      arg_list_push(&profile->flags, custom_flags.items[i]);
+    }
+  } else {
+    push_words(&profile->flags, base->flags);
+  }
+
+  arg_list_init(&profile->link_flags);
+  if (has_link_flags) {
+    for (int i = 0; i < custom_link_flags.count; i++) {
+      arg_list_push(&profile->link_flags, custom_link_flags.items[i]);
+    }
+  } else {
+    push_words(&profile->link_flags, base->link_flags);
+  }
+  arg_list_free(&custom_flags);
+  arg_list_free(&custom_link_flags);
+
+  select_lto_mode(&profile->flags, config->compiler);
+  select_lto_mode(&profile->link_flags, config->compiler);
+
+  size_t size = strlen(config->output_dir) + strlen(profile->name) + 2;
+  profile->directory = malloc(size);
+  snprintf(profile->directory, size, "%s/%s", config->output_dir, profile->name);
+
+  select_linker(profile);
+  if (strcmp(profile->build_type, "Debug") == 0) {
+    add_split_debug(profile);
+  }
+  if (has_flag(&profile->link_flags, "-flto=thin")) {
+    add_thinlto_cache(profile);
+  }
+
+  if (opts && opts->pgo_phase != PGO_NONE) {
+    pgo_apply_flags(opts, config, profile);
+  }
+  if (opts && opts->emit_relocs) {
+    // Keep relocations in the executable so llvm-bolt can move functions
+    arg_list_push(&profile->link_flags, "-Wl,--emit-relocs");
+  }
+  return 0;
+}
+
+void free_build_profile(struct build_profile *profile) {
+  free(profile->name);
+  free(profile->directory);
+  free(profile->linker);
+  arg_list_free(&profile->flags);
+  arg_list_free(&profile->link_flags);
+  memset(profile, 0, sizeof(*profile));
+}
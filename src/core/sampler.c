@@ -0,0 +1,278 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../include/commands.h"
+
+// The fallback sampler of `sbor profile`, for machines without a usable
+// perf. Its source is embedded below; sbor compiles it into
+// <profile dir>/profile/sampler.so and preloads it into the program. The
+// samples it writes are raw return addresses, resolved with preload.c.
+
+#ifdef __linux__
+
+static const char *const sampler_source[] = {
+    "// Generated by sbor: SIGPROF sampling profiler, loaded with LD_PRELOAD by\n",
+    "// `sbor profile` when perf is not available.\n",
+    "//\n",
+    "// Every 1/SBOR_PROFILE_HZ seconds of CPU time the handler walks the frame\n",
+    "// pointer chain of the interrupted thread into a preallocated buffer. At\n",
+    "// exit the raw stacks are written to $SBOR_PROFILE_OUT; sbor symbolizes them.\n",
+    "#define _GNU_SOURCE\n",
+    "#include <dlfcn.h>\n",
+    "#include <fcntl.h>\n",
+    "#include <link.h>\n",
+    "#include <signal.h>\n",
+    "#include <stdint.h>\n",
+    "#include <stdio.h>\n",
+    "#include <stdlib.h>\n",
+    "#include <string.h>\n",
+    "#include <sys/mman.h>\n",
+    "#include <sys/time.h>\n",
+    "#include <ucontext.h>\n",
+    "#include <unistd.h>\n",
+    "\n",
+    "#define MAX_DEPTH 128\n",
+    "#define BUFFER_WORDS (1u << 23)\n",
+    "\n",
+    "static uintptr_t *buffer;\n",
+    "static volatile uint32_t used;      // Words written so far\n",
+    "static volatile uint32_t dropped;   // Samples that did not fit\n",
+    "static uintptr_t main_start, main_end, main_bias;\n",
+    "static char output_path[4096];\n",
+    "static int hz;\n",
+    "\n",
+    "static void get_registers(void *context, uintptr_t *pc, uintptr_t *fp, uintptr_t *sp) {\n",
+    "  ucontext_t *uc = context;\n",
+    "#if defined(__x86_64__)\n",
+    "  *pc = uc->uc_mcontext.gregs[REG_RIP];\n",
+    "  *fp = uc->uc_mcontext.gregs[REG_RBP];\n",
+    "  *sp = uc->uc_mcontext.gregs[REG_RSP];\n",
+    "#elif defined(__aarch64__)\n",
+    "  *pc = uc->uc_mcontext.pc;\n",
+    "  *fp = uc->uc_mcontext.regs[29];\n",
+    "  *sp = uc->uc_mcontext.sp;\n",
+    "#else\n",
+    "  (void)uc;\n",
+    "  *pc = *fp = *sp = 0;\n",
+    "#endif\n",
+    "}\n",
+    "\n",
+    "static void on_sample(int signal_number, siginfo_t *info, void *context) {\n",
+    "  (void)signal_number;\n",
+    "  (void)info;\n",
+    "  uintptr_t frames[MAX_DEPTH];\n",
+    "  uintptr_t pc, fp, sp;\n",
+    "  get_registers(context, &pc, &fp, &sp);\n",
+    "  if (!pc) {\n",
+    "    return;\n",
+    "  }\n",
+    "\n",
+    "  int depth = 0;\n",
+    "  frames[depth++] = pc;\n",
+    "  // Each frame record is {previous fp, return address}. Only follow records\n",
+    "  // that lie above the interrupted stack pointer and keep moving up.\n",
+    "  while (depth < MAX_DEPTH && fp >= sp && fp - sp < (64u << 20) && (fp & (sizeof(uintptr_t) - 1)) == 0) {\n",
+    "    uintptr_t *record = (uintptr_t *)fp;\n",
+    "    uintptr_t next = record[0];\n",
+    "    uintptr_t ret = record[1];\n",
+    "    if (!ret) {\n",
+    "      break;\n",
+    "    }\n",
+    "    frames[depth++] = ret;\n",
+    "    if (next <= fp) {\n",
+    "      break;\n",
+    "    }\n",
+    "    fp = next;\n",
+    "  }\n",
+    "\n",
+    "  uint32_t start = __atomic_fetch_add(&used, (uint32_t)depth + 1, __ATOMIC_RELAXED);\n",
+    "  if (start + depth + 1 > BUFFER_WORDS) {\n",
+    "    __atomic_fetch_add(&dropped, 1, __ATOMIC_RELAXED);\n",
+    "    return;\n",
+    "  }\n",
+    "  buffer[start] = (uintptr_t)depth;\n",
+    "  memcpy(&buffer[start + 1], frames, depth * sizeof(uintptr_t));\n",
+    "}\n",
+    "\n",
+    "// The first object reported is the main executable\n",
+    "static int find_main(struct dl_phdr_info *info, size_t size, void *data) {\n",
+    "  (void)size;\n",
+    "  (void)data;\n",
+    "  main_bias = info->dlpi_addr;\n",
+    "  main_start = UINTPTR_MAX;\n",
+    "  main_end = 0;\n",
+    "  for (int i = 0; i < info->dlpi_phnum; i++) {\n",
+    "    if (info->dlpi_phdr[i].p_type != PT_LOAD) {\n",
+    "      continue;\n",
+    "    }\n",
+    "    uintptr_t start = info->dlpi_addr + info->dlpi_phdr[i].p_vaddr;\n",
+    "    uintptr_t end = start + info->dlpi_phdr[i].p_memsz;\n",
+    "    if (start < main_start) main_start = start;\n",
+    "    if (end > main_end) main_end = end;\n",
+    "  }\n",
+    "  return 1;\n",
+    "}\n",
+    "\n",
+    "__attribute__((constructor)) static void sampler_start(void) {\n",
+    "  const char *path = getenv(\"SBOR_PROFILE_OUT\");\n",
+    "  if (!path || !*path) {\n",
+    "    return;\n",
+    "  }\n",
+    "  snprintf(output_path, sizeof(output_path), \"%s\", path);\n",
+    "  const char *rate = getenv(\"SBOR_PROFILE_HZ\");\n",
+    "  hz = rate ? atoi(rate) : 0;\n",
+    "  if (hz <= 0 || hz > 10000) hz = 999;\n",
+    "\n",
+    "  // Only profile this process, not the programs it starts\n",
+    "  unsetenv(\"LD_PRELOAD\");\n",
+    "  unsetenv(\"SBOR_PROFILE_OUT\");\n",
+    "\n",
+    "  buffer = mmap(NULL, BUFFER_WORDS * sizeof(uintptr_t), PROT_READ | PROT_WRITE,\n",
+    "                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);\n",
+    "  if (buffer == MAP_FAILED) {\n",
+    "    buffer = NULL;\n",
+    "    return;\n",
+    "  }\n",
+    "  dl_iterate_phdr(find_main, NULL);\n",
+    "\n",
+    "  struct sigaction action;\n",
+    "  memset(&action, 0, sizeof(action));\n",
+    "  action.sa_sigaction = on_sample;\n",
+    "  action.sa_flags = SA_SIGINFO | SA_RESTART;\n",
+    "  sigemptyset(&action.sa_mask);\n",
+    "  sigaction(SIGPROF, &action, NULL);\n",
+    "\n",
+    "  struct itimerval timer;\n",
+    "  timer.it_interval.tv_sec = 0;\n",
+    "  timer.it_interval.tv_usec = 1000000 / hz;\n",
+    "  timer.it_value = timer.it_interval;\n",
+    "  setitimer(ITIMER_PROF, &timer, NULL);\n",
+    "}\n",
+    "\n",
+    "__attribute__((destructor)) static void sampler_stop(void) {\n",
+    "  if (!buffer) {\n",
+    "    return;\n",
+    "  }\n",
+    "  struct itimerval off;\n",
+    "  memset(&off, 0, sizeof(off));\n",
+    "  setitimer(ITIMER_PROF, &off, NULL);\n",
+    "  signal(SIGPROF, SIG_IGN);\n",
+    "\n",
+    "  FILE *file = fopen(output_path, \"w\");\n",
+    "  if (!file) {\n",
+    "    return;\n",
+    "  }\n",
+    "  uint32_t total = used < BUFFER_WORDS ? used : BUFFER_WORDS;\n",
+    "  fprintf(file, \"sbor-samples 1\\nhz %d\\nbias %lx\\nrange %lx %lx\\ndropped %u\\n\", hz,\n",
+    "          (unsigned long)main_bias, (unsigned long)main_start, (unsigned long)main_end, dropped);\n",
+    "\n",
+    "  for (uint32_t i = 0; i < total;) {\n",
+    "    uintptr_t depth = buffer[i];\n",
+    "    if (depth == 0 || i + 1 + depth > total) {\n",
+    "      break;\n",
+    "    }\n",
+    "    fprintf(file, \"stack\");\n",
+    "    for (uintptr_t d = 0; d < depth; d++) {\n",
+    "      uintptr_t address = buffer[i + 1 + d];\n",
+    "      fprintf(file, \" %lx\", (unsigned long)address);\n",
+    "    }\n",
+    "    fprintf(file, \"\\n\");\n",
+    "\n",
+    "    // Name addresses outside the executable here, where dladdr can see them\n",
+    "    for (uintptr_t d = 0; d < depth; d++) {\n",
+    "      uintptr_t address = buffer[i + 1 + d];\n",
+    "      Dl_info where;\n",
+    "      if ((address < main_start || address >= main_end) && dladdr((void *)(address - (d > 0)), &where)) {\n",
+    "        const char *object = where.dli_fname ? strrchr(where.dli_fname, '/') : NULL;\n",
+    "        object = object ? object + 1 : where.dli_fname;\n",
+    "        fprintf(file, \"sym %lx %s\\n\", (unsigned long)address,\n",
+    "                where.dli_sname ? where.dli_sname : (object && *object ? object : \"??\"));\n",
+    "      }\n",
+    "    }\n",
+    "    i += 1 + depth;\n",
+    "  }\n",
+    "  fclose(file);\n",
+    "  munmap(buffer, BUFFER_WORDS * sizeof(uintptr_t));\n",
+    "  buffer = NULL;\n",
+    "}\n",
+  NULL
+};
+
+// Write and compile the sampler in `work_dir` (see preload.c). Returns the
+// library's absolute path.
+char* build_sampler(const struct project_config *config, const char *work_dir) {
+  return build_preload_library(config, work_dir, "sampler", sampler_source);
+}
+
+// Turn the sampler's output into one "root;...;leaf" stack per sample.
+// Returns the number of samples, or -1 if the file could not be read.
+int symbolize_samples(const char *samples_path, const char *exe_path, struct arg_list *stacks) {
+  char *content = read_file_contents(samples_path);
+  if (!content || strncmp(content, "sbor-samples 1\n", 15) != 0) {
+    free(content);
+    return -1;
+  }
+
+  struct address_map *map = load_address_map(content, exe_path);
+  unsigned long dropped = 0;
+  char *header = strstr(content, "\ndropped ");
+  if (header) {
+    dropped = strtoul(header + 9, NULL, 10);
+  }
+
+  int samples = 0;
+  struct arg_list frames;
+  for (char *line = content; line && *line;) {
+    char *next = strchr(line, '\n');
+    if (next) *next++ = '\0';
+    if (strncmp(line, "stack ", 6) != 0) {
+      line = next;
+      continue;
+    }
+
+    arg_list_init(&frames);
+    for (char *word = strtok(line + 6, " "); word; word = strtok(NULL, " ")) {
+      unsigned long long address = strtoull(word, NULL, 16);
+      // Every frame but the leaf is a return address
+      const char *name = resolve_address(map, address, frames.count > 0, NULL);
+      char unknown[32];
+      if (!name) {
+        snprintf(unknown, sizeof(unknown), "0x%llx", address);
+        name = unknown;
+      }
+      arg_list_push(&frames, name);
+    }
+
+    if (frames.count > 0) {
+      push_folded_stack(stacks, &frames);
+      samples++;
+    }
+    arg_list_free(&frames);
+    line = next;
+  }
+  free(content);
+
+  if (dropped) {
+    printf("   ⚠️  %lu samples did not fit in the sampler's buffer.\n", dropped);
+  }
+  free_address_map(map);
+  return samples;
+}
+
+#else
+
+char* build_sampler(const struct project_config *config, const char *work_dir) {
+  (void)config;
+  (void)work_dir;
+  return NULL;
+}
+
+int symbolize_samples(const char *samples_path, const char *exe_path, struct arg_list *stacks) {
+  (void)samples_path;
+  (void)exe_path;
+  (void)stacks;
+  return -1;
+}
+
+#endif
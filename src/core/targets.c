@@ -0,0 +1,291 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+  #include <direct.h>
+#else
+  #include <unistd.h>
+#endif
+#include <dirent.h>
+
+#include "../include/commands.h"
+
+// Build targets: what a build produced, and whether it is still current.
+//
+// After every successful build sbor writes <profile dir>/.sbor/targets with
+// one line per executable, "<name>\t<path>", the path relative to the
+// profile directory. The native backend lists its own link outputs. CMake
+// builds take them from the File API codemodel, which sbor requests before
+// every configure, so `sbor run` never has to guess which file in the build
+// tree is the program.
+
+#define TARGETS_MANIFEST ".sbor/targets"
+#define CODEMODEL_QUERY ".cmake/api/v1/query/codemodel-v2"
+#define CODEMODEL_REPLY ".cmake/api/v1/reply"
+
+// Write the manifest for `directory`. Paths are relative to it.
+int record_targets(const char *directory, const struct arg_list *names, const struct arg_list *paths) {
+  char path[1100];
+  snprintf(path, sizeof(path), "%s/.sbor", directory);
+  make_directories(path);
+  snprintf(path, sizeof(path), "%s/%s", directory, TARGETS_MANIFEST);
+
+  FILE *file = fopen(path, "w");
+  if (!file) {
+    return -1;
+  }
+  for (int i = 0; i < names->count; i++) {
+    fprintf(file, "%s\t%s\n", names->items[i], paths->items[i]);
+  }
+  fclose(file);
+  return 0;
+}
+
+// Read the manifest of `directory`. The paths come back joined with the
+// directory unless they are absolute. Returns the number of targets, or
+// -1 if the tree has no manifest (not built yet, or built by an older sbor).
+int load_targets(const char *directory, struct arg_list *names, struct arg_list *paths) {
+  arg_list_init(names);
+  arg_list_init(paths);
+
+  char path[1100];
+  snprintf(path, sizeof(path), "%s/%s", directory, TARGETS_MANIFEST);
+  char *content = read_file_contents(path);
+  if (!content) {
+    return -1;
+  }
+  for (char *line = strtok(content, "\n"); line; line = strtok(NULL, "\n")) {
+    char *tab = strchr(line, '\t');
+    if (!tab) {
+      continue;
+    }
+    *tab = '\0';
+    arg_list_push(names, line);
+    if (tab[1] == '/' || (tab[1] && tab[2] == ':')) {
+      arg_list_push(paths, tab + 1);
+    } else {
+      arg_list_pushf(paths, "%s/%s", directory, tab + 1);
+    }
+  }
+  free(content);
+  return names->count;
+}
+
+// The path of the executable target `name` in `directory`, matched by
+// target name or file name, or NULL
+char* find_target(const char *directory, const char *name) {
+  struct arg_list names, paths;
+  char *found = NULL;
+  if (load_targets(directory, &names, &paths) > 0) {
+    for (int i = 0; i < names.count && !found; i++) {
+      const char *file = strrchr(paths.items[i], '/');
+      file = file ? file + 1 : paths.items[i];
+      if (strcmp(names.items[i], name) == 0 || strcmp(file, name) == 0) {
+        found = strdup(paths.items[i]);
+      }
+    }
+  }
+  arg_list_free(&names);
+  arg_list_free(&paths);
+  return found;
+}
+
+// Ask CMake for its codemodel on the next configure. Called from the build
+// directory.
+void request_cmake_codemodel(void) {
+  if (!file_exists(CODEMODEL_QUERY)) {
+    make_directories(".cmake/api/v1/query");
+    create_file_with_content(CODEMODEL_QUERY, "");
+  }
+}
+
+// Whether the last configure answered the query
+int cmake_codemodel_ready(void) {
+  return file_exists(CODEMODEL_REPLY);
+}
+
+// Read a reply file into memory
+static char* read_reply(const char *name) {
+  char path[1024];
+  snprintf(path, sizeof(path), "%s/%s", CODEMODEL_REPLY, name);
+  return read_file_contents(path);
+}
+
+// The newest index-*.json; CMake names them by time, so that is the last one
+static char* newest_reply_index(void) {
+  DIR *dir = opendir(CODEMODEL_REPLY);
+  if (!dir) {
+    return NULL;
+  }
+  char *newest = NULL;
+  struct dirent *entry;
+  while ((entry = readdir(dir)) != NULL) {
+    if (strncmp(entry->d_name, "index-", 6) == 0 && (!newest || strcmp(entry->d_name, newest) > 0)) {
+      free(newest);
+      newest = strdup(entry->d_name);
+    }
+  }
+  closedir(dir);
+  return newest;
+}
+
+// Add the executable described by a codemodel target file
+static void add_cmake_target(const char *reference, struct arg_list *names, struct arg_list *paths) {
+  char *file = json_string_member(reference, "jsonFile");
+  char *content = file ? read_reply(file) : NULL;
+  free(file);
+  if (!content) {
+    return;
+  }
+
+  const char *target = skip_json_space(content);
+  char *type = json_string_member(target, "type");
+  if (type && strcmp(type, "EXECUTABLE") == 0) {
+    char *name = json_string_member(target, "name");
+    const char *artifacts;
+    const char *artifact = json_member(target, "artifacts", &artifacts) ? json_first_element(artifacts) : NULL;
+    char *path = artifact && *artifact == '{' ? json_string_member(artifact, "path") : NULL;
+    if (name && path) {
+      arg_list_push(names, name);
+      arg_list_push(paths, path);
+    }
+    free(name);
+    free(path);
+  }
+  free(type);
+  free(content);
+}
+
+// Write the manifest from CMake's codemodel reply. Called from the build
+// directory after a successful build. Returns the number of executables,
+// or -1 if there is no reply to read.
+int record_cmake_targets(void) {
+  char *index_name = newest_reply_index();
+  char *index = index_name ? read_reply(index_name) : NULL;
+  free(index_name);
+
+  // index -> reply -> codemodel-v2 -> jsonFile
+  const char *reply, *codemodel_reference;
+  char *codemodel_file = NULL;
+  if (index && json_member(skip_json_space(index), "reply", &reply) &&
+      json_member(reply, "codemodel-v2", &codemodel_reference)) {
+    codemodel_file = json_string_member(codemodel_reference, "jsonFile");
+  }
+  char *codemodel = codemodel_file ? read_reply(codemodel_file) : NULL;
+  free(codemodel_file);
+  free(index);
+  if (!codemodel) {
+    return -1;
+  }
+
+  // Single-configuration generators have exactly one configuration
+  struct arg_list names, paths;
+  arg_list_init(&names);
+  arg_list_init(&paths);
+  const char *configurations, *targets;
+  const char *configuration = json_member(skip_json_space(codemodel), "configurations", &configurations)
+                                  ? json_first_element(configurations) : NULL;
+  if (configuration && *configuration == '{' && json_member(configuration, "targets", &targets)) {
+    for (const char *target = json_first_element(targets); target && *target == '{';
+         target = json_next_element(target)) {
+      add_cmake_target(target, &names, &paths);
+    }
+  }
+  free(codemodel);
+
+  int count = names.count;
+  record_targets(".", &names, &paths);
+  arg_list_free(&names);
+  arg_list_free(&paths);
+  return count;
+}
+
+// Whether anything under `directory` (the tree itself included) was
+// modified after `built`. A new or deleted file changes its directory.
+static int tree_changed_since(const char *directory, long long built) {
+  if (file_mtime_ns(directory) > built) {
+    return 1;
+  }
+  DIR *dir = opendir(directory);
+  if (!dir) {
+    return 0;
+  }
+  int changed = 0;
+  struct dirent *entry;
+  while (!changed && (entry = readdir(dir)) != NULL) {
+    if (entry->d_name[0] == '.') {
+      continue;
+    }
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/%s", directory, entry->d_name);
+    struct stat info;
+    if (stat(path, &info) != 0) {
+      continue;
+    }
+    if (S_ISDIR(info.st_mode)) {
+      changed = tree_changed_since(path, built);
+    } else {
+      changed = file_mtime_ns(path) > built;
+    }
+  }
+  closedir(dir);
+  return changed;
+}
+
+// Whether a prerequisite in any compiler depfile (*.d) in the build tree is
+// missing or newer than `built`. This covers headers outside src/, down to
+// system headers.
+static int depfiles_changed_since(const char *directory, long long built) {
+  DIR *dir = opendir(directory);
+  if (!dir) {
+    return 0;
+  }
+  int changed = 0;
+  struct dirent *entry;
+  while (!changed && (entry = readdir(dir)) != NULL) {
+    if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+      continue;
+    }
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/%s", directory, entry->d_name);
+    size_t length = strlen(entry->d_name);
+    struct stat info;
+    if (stat(path, &info) != 0) {
+      continue;
+    }
+    if (S_ISDIR(info.st_mode)) {
+      changed = depfiles_changed_since(path, built);
+    } else if (length > 2 && strcmp(entry->d_name + length - 2, ".d") == 0) {
+      changed = depfile_is_stale(path, built);
+    }
+  }
+  closedir(dir);
+  return changed;
+}
+
+// Set by sbor daemon when inotify saw no change since the last successful
+// build, which makes the scan below unnecessary
+static int targets_known_fresh = 0;
+
+void assume_targets_fresh(void) {
+  targets_known_fresh = 1;
+}
+
+// Whether `artifact`, built in `directory`, is newer than everything it is
+// built from: sbor.conf, CMakeLists.txt, every file under src/ and every
+// prerequisite the compiler recorded. If so, a build would do nothing.
+int target_is_fresh(const char *directory, const char *artifact) {
+  long long built = file_mtime_ns(artifact);
+  if (built == 0) {
+    return 0;
+  }
+  if (targets_known_fresh) {
+    return 1;
+  }
+  if (file_mtime_ns("sbor.conf") > built || file_mtime_ns("CMakeLists.txt") > built) {
+    return 0;
+  }
+  return !tree_changed_since("src", built) && !depfiles_changed_since(directory, built);
+}
@@ -4,8 +4,8 @@
 #include "../include/commands.h"
 
 char* generate_cmake_template(const char *project_name) {
-  char *template = malloc(2048);
-  snprintf(template, 2048,
+  char *template = malloc(6144);
+  snprintf(template, 6144,
            "# Minimum CMake version\n"
            "cmake_minimum_required(VERSION 3.15)\n\n"
            "# Project definition\n"
@@ -14,10 +14,13 @@ char* generate_cmake_template(const char *project_name) {
            "    DESCRIPTION \"A C project created with sbor\"\n"
            "    LANGUAGES C\n"
            ")\n\n"
-           "# Set C standard\n"
-           "set(CMAKE_C_STANDARD 17)\n"
+           "# Set C standard (sbor passes c_standard from sbor.conf)\n"
+           "if(NOT CMAKE_C_STANDARD)\n"
+           "    set(CMAKE_C_STANDARD 17)\n"
+           "endif()\n"
            "set(CMAKE_C_STANDARD_REQUIRED ON)\n\n"
-           "# Set default build type to Release if not specified\n"
+           "# Set default build type to Release if not specified.\n"
+           "# sbor picks the build type and its flags from the selected profile.\n"
            "if(NOT CMAKE_BUILD_TYPE)\n"
            "    set(CMAKE_BUILD_TYPE Release)\n"
            "endif()\n\n"
@@ -30,21 +33,37 @@ char* generate_cmake_template(const char *project_name) {
            "add_executable(${PROJECT_NAME} ${SOURCES})\n\n"
            "# Include directories\n"
            "target_include_directories(${PROJECT_NAME} PRIVATE src)\n\n"
-           "# Compiler flags\n"
+           "# Precompile the sbor-managed umbrella header (disable with \"pch\": false)\n"
+           "option(SBOR_PCH \"Precompile src/include.h\" ON)\n"
+           "if(SBOR_PCH AND NOT CMAKE_VERSION VERSION_LESS 3.16)\n"
+           "    target_precompile_headers(${PROJECT_NAME} PRIVATE src/include.h)\n"
+           "endif()\n\n"
+           "# Files in build.unity_exclude are compiled on their own in unity builds\n"
+           "if(SBOR_UNITY_EXCLUDE)\n"
+           "    set_source_files_properties(${SBOR_UNITY_EXCLUDE} PROPERTIES SKIP_UNITY_BUILD_INCLUSION ON)\n"
+           "endif()\n\n"
+           "# Compiler warnings. Optimization flags come from CMAKE_C_FLAGS_<CONFIG>,\n"
+           "# which sbor fills in from the build profile (sbor build --profile NAME).\n"
            "target_compile_options(${PROJECT_NAME} PRIVATE\n"
            "    $<$<C_COMPILER_ID:GNU,Clang>:-Wall -Wextra -Wpedantic>\n"
            "    $<$<C_COMPILER_ID:MSVC>:/W4>\n"
-           "    \n"
-           "    $<$<CONFIG:Debug>:\n"
-           "        $<$<C_COMPILER_ID:GNU,Clang>:-g -O0>\n"
-           "        $<$<C_COMPILER_ID:MSVC>:/Od /Zi>\n"
-           "    >\n"
-           "    \n"
-           "    $<$<CONFIG:Release>:\n"
-           "        $<$<C_COMPILER_ID:GNU,Clang>:-O3 -DNDEBUG>\n"
-           "        $<$<C_COMPILER_ID:MSVC>:/O2 /DNDEBUG>\n"
-           "    >\n"
            ")\n\n"
+           "# Micro-benchmarks (sbor microbench): one executable per benches/*.c,\n"
+           "# linked with the project sources except src/main.c\n"
+           "option(SBOR_BENCHES \"Build the micro-benchmarks in benches/\" OFF)\n"
+           "if(SBOR_BENCHES)\n"
+           "    file(GLOB SBOR_BENCH_SOURCES CONFIGURE_DEPENDS benches/*.c)\n"
+           "    set(SBOR_BENCH_LIBRARY_SOURCES ${SOURCES})\n"
+           "    list(REMOVE_ITEM SBOR_BENCH_LIBRARY_SOURCES src/main.c)\n"
+           "    foreach(bench_source ${SBOR_BENCH_SOURCES})\n"
+           "        get_filename_component(bench_name ${bench_source} NAME_WE)\n"
+           "        add_executable(bench_${bench_name} ${bench_source} ${SBOR_BENCH_LIBRARY_SOURCES})\n"
+           "        target_include_directories(bench_${bench_name} PRIVATE src benches)\n"
+           "        set_target_properties(bench_${bench_name} PROPERTIES\n"
+           "            OUTPUT_NAME ${bench_name}\n"
+           "            RUNTIME_OUTPUT_DIRECTORY ${CMAKE_BINARY_DIR}/benches)\n"
+           "    endforeach()\n"
+           "endif()\n\n"
            "message(STATUS \"Build type: ${CMAKE_BUILD_TYPE}\")\n"
            "message(STATUS \"C compiler: ${CMAKE_C_COMPILER}\")\n",
            project_name);
@@ -64,16 +83,19 @@ char* generate_main_template(void) {
 }
 
 char* generate_include_template(void) {
-  char *template = malloc(300);
-  snprintf(template, 300,
+  char *template = malloc(512);
+  snprintf(template, 512,
            "// Auto-generated by sbor - Managed header includes\n"
            "// Use 'sbor add <header>' to add system headers\n"
            "// Use 'sbor add <header> -c' to add custom headers\n\n"
+           "#ifndef SBOR_INCLUDE_H\n"
+           "#define SBOR_INCLUDE_H\n\n"
            "// System headers\n"
            "#include <stdio.h>\n"
            "#include <stdlib.h>\n\n"
            "// Custom headers\n"
-           "// Add your custom includes here\n");
+           "// Add your custom includes here\n\n"
+           "#endif // SBOR_INCLUDE_H\n");
   return template;
 }
 
@@ -131,10 +153,250 @@ char* generate_config_template(const char *project_name) {
            "    },\n"
            "    \"build\": {\n"
            "        \"compiler\": \"gcc\",\n"
-           "        \"flags\": [\"-Wall\", \"-Wextra\", \"-O2\"],\n"
+           "        \"flags\": [\"-Wall\", \"-Wextra\"],\n"
            "        \"output_dir\": \"build\"\n"
            "    }\n"
            "}\n",
            project_name);
   return template;
 }
+
+// Join a NULL-terminated list of lines. Used for templates longer than the
+// 4095 characters ISO C guarantees for a single string literal.
+static char* join_lines(const char *const lines[]) {
+  size_t length = 1;
+  for (int i = 0; lines[i]; i++) {
+    length += strlen(lines[i]);
+  }
+  char *text = malloc(length);
+  text[0] = '\0';
+  for (int i = 0; lines[i]; i++) {
+    strcat(text, lines[i]);
+  }
+  return text;
+}
+
+// benches/sbor_bench.h: the header-only harness used by sbor microbench
+char* generate_bench_header_template(void) {
+  static const char *const lines[] = {
+    "// sbor_bench.h - micro-benchmark harness generated by sbor\n",
+    "//\n",
+    "// Each benches/*.c is built with full optimization and run by\n",
+    "// `sbor microbench [filter]`. A benchmark runs its code b->iterations times;\n",
+    "// the harness picks the iteration count so each sample takes at least\n",
+    "// SBOR_BENCH_MIN_TIME seconds (default 0.1) and reports the median of\n",
+    "// SBOR_BENCH_SAMPLES samples (default 5).\n",
+    "//\n",
+    "//   static void bench_sum(sbor_bench *b) {\n",
+    "//       int data[1024] = {0};\n",
+    "//       sbor_reset_timer(b);            // Exclude the setup above\n",
+    "//       b->bytes = sizeof(data);        // Optional: report throughput\n",
+    "//       for (uint64_t n = 0; n < b->iterations; n++) {\n",
+    "//           long sum = 0;\n",
+    "//           for (int i = 0; i < 1024; i++) sum += data[i];\n",
+    "//           sbor_do_not_optimize(sum);  // Keep the result alive\n",
+    "//       }\n",
+    "//   }\n",
+    "//\n",
+    "//   SBOR_BENCH_MAIN(SBOR_BENCH(bench_sum))\n",
+    "\n",
+    "#ifndef SBOR_BENCH_H\n",
+    "#define SBOR_BENCH_H\n",
+    "\n",
+    "// For clock_gettime under -std=c17; falls back to timespec_get otherwise\n",
+    "#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)\n",
+    "  #define _POSIX_C_SOURCE 199309L\n",
+    "#endif\n",
+    "\n",
+    "#include <stdint.h>\n",
+    "#include <stdio.h>\n",
+    "#include <stdlib.h>\n",
+    "#include <string.h>\n",
+    "\n",
+    "#ifdef _WIN32\n",
+    "  #include <windows.h>\n",
+    "#else\n",
+    "  #include <time.h>\n",
+    "#endif\n",
+    "\n",
+    "typedef struct sbor_bench {\n",
+    "  uint64_t iterations;  // Run the measured code this many times\n",
+    "  uint64_t bytes;       // Bytes processed per iteration, for throughput (optional)\n",
+    "  uint64_t items;       // Items processed per iteration, for throughput (optional)\n",
+    "  double start;         // Set by sbor_reset_timer\n",
+    "} sbor_bench;\n",
+    "\n",
+    "typedef void (*sbor_bench_fn)(sbor_bench *b);\n",
+    "\n",
+    "struct sbor_bench_entry {\n",
+    "  const char *name;\n",
+    "  sbor_bench_fn fn;\n",
+    "};\n",
+    "\n",
+    "#define SBOR_BENCH(fn) { #fn, fn }\n",
+    "\n",
+    "static double sbor_now(void) {\n",
+    "#ifdef _WIN32\n",
+    "  LARGE_INTEGER frequency, counter;\n",
+    "  QueryPerformanceFrequency(&frequency);\n",
+    "  QueryPerformanceCounter(&counter);\n",
+    "  return (double)counter.QuadPart / (double)frequency.QuadPart;\n",
+    "#else\n",
+    "  struct timespec now;\n",
+    "#ifdef CLOCK_MONOTONIC\n",
+    "  clock_gettime(CLOCK_MONOTONIC, &now);\n",
+    "#else\n",
+    "  timespec_get(&now, TIME_UTC);\n",
+    "#endif\n",
+    "  return now.tv_sec + now.tv_nsec / 1e9;\n",
+    "#endif\n",
+    "}\n",
+    "\n",
+    "// Force `value` to be computed and stored: the compiler must assume the\n",
+    "// empty asm statement reads it. Works for any lvalue.\n",
+    "#if defined(__GNUC__) || defined(__clang__)\n",
+    "static inline void sbor_escape(void *pointer) {\n",
+    "  __asm__ volatile(\"\" : : \"g\"(pointer) : \"memory\");\n",
+    "}\n",
+    "#define sbor_clobber_memory() __asm__ volatile(\"\" : : : \"memory\")\n",
+    "#else\n",
+    "#include <intrin.h>\n",
+    "static void *volatile sbor_sink;\n",
+    "static inline void sbor_escape(void *pointer) {\n",
+    "  sbor_sink = pointer;\n",
+    "  _ReadWriteBarrier();\n",
+    "}\n",
+    "#define sbor_clobber_memory() _ReadWriteBarrier()\n",
+    "#endif\n",
+    "#define sbor_do_not_optimize(value) sbor_escape((void *)&(value))\n",
+    "\n",
+    "// Restart the clock, e.g. after expensive setup\n",
+    "#define sbor_reset_timer(b) ((b)->start = sbor_now())\n",
+    "\n",
+    "static double sbor_bench_sample(sbor_bench_fn fn, sbor_bench *b, uint64_t iterations) {\n",
+    "  b->iterations = iterations;\n",
+    "  b->start = sbor_now();\n",
+    "  fn(b);\n",
+    "  return sbor_now() - b->start;\n",
+    "}\n",
+    "\n",
+    "static int sbor_bench_compare(const void *a, const void *b) {\n",
+    "  double x = *(const double *)a, y = *(const double *)b;\n",
+    "  return (x > y) - (x < y);\n",
+    "}\n",
+    "\n",
+    "static double sbor_bench_env(const char *name, double fallback) {\n",
+    "  const char *value = getenv(name);\n",
+    "  double parsed = value ? atof(value) : 0.0;\n",
+    "  return parsed > 0 ? parsed : fallback;\n",
+    "}\n",
+    "\n",
+    "static void sbor_bench_rate(double per_second, const char *unit) {\n",
+    "  const char *prefix = \"\";\n",
+    "  if (per_second >= 1e9) { per_second /= 1e9; prefix = \"G\"; }\n",
+    "  else if (per_second >= 1e6) { per_second /= 1e6; prefix = \"M\"; }\n",
+    "  else if (per_second >= 1e3) { per_second /= 1e3; prefix = \"k\"; }\n",
+    "  printf(\"  %8.2f %s%s/s\", per_second, prefix, unit);\n",
+    "}\n",
+    "\n",
+    "static int sbor_bench_run(const struct sbor_bench_entry *entries, int count, int argc, char **argv) {\n",
+    "  double min_time = sbor_bench_env(\"SBOR_BENCH_MIN_TIME\", 0.1);\n",
+    "  int samples = (int)sbor_bench_env(\"SBOR_BENCH_SAMPLES\", 5);\n",
+    "  const char *filter = argc > 1 ? argv[1] : NULL;\n",
+    "  double *ns_per_op = malloc(samples * sizeof(double));\n",
+    "\n",
+    "  for (int e = 0; e < count; e++) {\n",
+    "    if (filter && !strstr(entries[e].name, filter)) {\n",
+    "      continue;\n",
+    "    }\n",
+    "    sbor_bench b;\n",
+    "    memset(&b, 0, sizeof(b));\n",
+    "\n",
+    "    // Calibrate: grow the iteration count until one sample is long enough\n",
+    "    uint64_t iterations = 1;\n",
+    "    double elapsed = sbor_bench_sample(entries[e].fn, &b, iterations);\n",
+    "    while (elapsed < min_time && iterations < (UINT64_C(1) << 40)) {\n",
+    "      double per_op = elapsed / iterations;\n",
+    "      uint64_t next = per_op > 0 ? (uint64_t)(min_time * 1.2 / per_op) : iterations * 100;\n",
+    "      if (next > iterations * 100) next = iterations * 100;\n",
+    "      if (next <= iterations) next = iterations * 2;\n",
+    "      iterations = next;\n",
+    "      elapsed = sbor_bench_sample(entries[e].fn, &b, iterations);\n",
+    "    }\n",
+    "\n",
+    "    for (int s = 0; s < samples; s++) {\n",
+    "      ns_per_op[s] = sbor_bench_sample(entries[e].fn, &b, iterations) * 1e9 / iterations;\n",
+    "    }\n",
+    "    qsort(ns_per_op, samples, sizeof(double), sbor_bench_compare);\n",
+    "    double median = ns_per_op[samples / 2];\n",
+    "    double spread = median > 0 ? 100.0 * (ns_per_op[samples - 1] - ns_per_op[0]) / median : 0.0;\n",
+    "\n",
+    "    printf(\"%-32s %12.2f ns/op  (min %.2f, spread %4.1f%%, %llu iterations)\",\n",
+    "           entries[e].name, median, ns_per_op[0], spread, (unsigned long long)iterations);\n",
+    "    if (b.bytes) sbor_bench_rate(b.bytes * 1e9 / median, \"B\");\n",
+    "    if (b.items) sbor_bench_rate(b.items * 1e9 / median, \"items\");\n",
+    "    printf(\"\\n\");\n",
+    "    fflush(stdout);\n",
+    "  }\n",
+    "\n",
+    "  free(ns_per_op);\n",
+    "  return 0;\n",
+    "}\n",
+    "\n",
+    "#define SBOR_BENCH_MAIN(...)                                                   \\\n",
+    "  int main(int argc, char **argv) {                                            \\\n",
+    "    static const struct sbor_bench_entry entries[] = { __VA_ARGS__ };         \\\n",
+    "    return sbor_bench_run(entries, (int)(sizeof(entries) / sizeof(entries[0])), \\\n",
+    "                          argc, argv);                                         \\\n",
+    "  }\n",
+    "\n",
+    "#endif // SBOR_BENCH_H\n",
+    NULL
+  };
+  return join_lines(lines);
+}
+
+// benches/example_bench.c
+char* generate_bench_example_template(void) {
+  static const char *const lines[] = {
+    "// Example micro-benchmarks. Run them with: sbor microbench [filter]\n",
+    "#include \"sbor_bench.h\"\n",
+    "\n",
+    "#define COUNT 4096\n",
+    "\n",
+    "static void bench_sum_array(sbor_bench *b) {\n",
+    "  static int data[COUNT];\n",
+    "  for (int i = 0; i < COUNT; i++) {\n",
+    "    data[i] = i;\n",
+    "  }\n",
+    "  sbor_reset_timer(b);\n",
+    "\n",
+    "  b->bytes = sizeof(data);\n",
+    "  for (uint64_t n = 0; n < b->iterations; n++) {\n",
+    "    long sum = 0;\n",
+    "    for (int i = 0; i < COUNT; i++) {\n",
+    "      sum += data[i];\n",
+    "    }\n",
+    "    sbor_do_not_optimize(sum);\n",
+    "  }\n",
+    "}\n",
+    "\n",
+    "static void bench_integer_division(sbor_bench *b) {\n",
+    "  unsigned value = 123456789u;\n",
+    "  b->items = 1;\n",
+    "  for (uint64_t n = 0; n < b->iterations; n++) {\n",
+    "    unsigned divisor = (unsigned)n | 1u;\n",
+    "    sbor_do_not_optimize(divisor);\n",
+    "    unsigned quotient = value / divisor;\n",
+    "    sbor_do_not_optimize(quotient);\n",
+    "  }\n",
+    "}\n",
+    "\n",
+    "SBOR_BENCH_MAIN(\n",
+    "  SBOR_BENCH(bench_sum_array),\n",
+    "  SBOR_BENCH(bench_integer_division)\n",
+    ")\n",
+    NULL
+  };
+  return join_lines(lines);
+}
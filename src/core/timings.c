@@ -0,0 +1,692 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+  #include <direct.h>
+#else
+  #include <unistd.h>
+#endif
+
+#include "../include/commands.h"
+
+// Build timings (`sbor build --timings`).
+//
+// While a build runs, sbor records its phases (configure, compile, link, ...)
+// and every compile and link job on the monotonic clock. The native backend
+// reports its jobs directly. Under CMake the compiler and linker launchers
+// (`sbor __time`, `sbor __link`) append one line per job to the file named by
+// $SBOR_TIMINGS_LOG:
+//
+//   <kind> TAB <start> TAB <end> TAB <output> TAB <source or binary>
+//
+// The result is a Chrome trace-event file (ui.perfetto.dev or
+// chrome://tracing) with one track per parallel job slot, plus a summary of
+// the phases, the slowest translation units and the critical path. Clang's
+// -ftime-trace output and CMake's configure profile are folded into the trace
+// under the job or phase they belong to.
+
+#define TIMINGS_LOG_VARIABLE "SBOR_TIMINGS_LOG"
+#define SLOWEST_UNITS 10
+
+struct timed_job {
+  char *kind;        // "compile" or "link"
+  char *name;        // Source file, or the linked binary
+  char *output;
+  double start;
+  double end;
+  int *deps;         // Jobs this one waited for
+  int dep_count;     // -1 if unknown (jobs reported by the CMake launchers)
+  int lane;          // Trace track, assigned when the trace is written
+  int critical;
+  double frontend;   // From clang's -ftime-trace, 0 without one
+  double backend;
+};
+
+struct timed_span {
+  char *name;        // Phase name, or the path of an attached trace
+  double start;
+  double end;
+};
+
+static struct {
+  int enabled;
+  double start;
+  time_t wall_start;  // Tells this build's -ftime-trace files from stale ones
+  struct timed_job *jobs;
+  int job_count;
+  int job_capacity;
+  struct timed_span *phases;
+  int phase_count;
+  int phase_capacity;
+  struct timed_span *traces;
+  int trace_count;
+  int trace_capacity;
+} timings;
+
+double timings_now(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+// Begin collecting timings for one build
+void timings_start(void) {
+  memset(&timings, 0, sizeof(timings));
+  timings.enabled = 1;
+  timings.start = timings_now();
+  timings.wall_start = time(NULL);
+}
+
+int timings_enabled(void) {
+  return timings.enabled;
+}
+
+static struct timed_span* push_span(struct timed_span **spans, int *count, int *capacity,
+                                    const char *name, double start, double end) {
+  if (*count == *capacity) {
+    *capacity = *capacity ? *capacity * 2 : 8;
+    *spans = realloc(*spans, *capacity * sizeof(struct timed_span));
+  }
+  struct timed_span *span = &(*spans)[(*count)++];
+  span->name = strdup(name);
+  span->start = start;
+  span->end = end;
+  return span;
+}
+
+void timings_phase(const char *name, double start, double end) {
+  if (timings.enabled && end > start) {
+    push_span(&timings.phases, &timings.phase_count, &timings.phase_capacity, name, start, end);
+  }
+}
+
+// Record a finished job. `deps` are indices returned by earlier calls;
+// pass a dep_count of -1 when the dependencies are unknown. Returns the
+// job's index, or -1 when timings are off.
+int timings_job(const char *kind, const char *name, const char *output, double start, double end,
+                const int *deps, int dep_count) {
+  if (!timings.enabled) {
+    return -1;
+  }
+  if (timings.job_count == timings.job_capacity) {
+    timings.job_capacity = timings.job_capacity ? timings.job_capacity * 2 : 32;
+    timings.jobs = realloc(timings.jobs, timings.job_capacity * sizeof(struct timed_job));
+  }
+  struct timed_job *job = &timings.jobs[timings.job_count];
+  memset(job, 0, sizeof(*job));
+  job->kind = strdup(kind);
+  job->name = strdup(name);
+  job->output = strdup(output);
+  job->start = start;
+  job->end = end;
+  job->dep_count = dep_count;
+  if (dep_count > 0) {
+    job->deps = malloc(dep_count * sizeof(int));
+    memcpy(job->deps, deps, dep_count * sizeof(int));
+  }
+  return timings.job_count++;
+}
+
+// When the last recorded job finished, or now if there are none
+double timings_last_job_end(void) {
+  if (timings.job_count == 0) {
+    return timings_now();
+  }
+  double last = 0;
+  for (int i = 0; i < timings.job_count; i++) {
+    if (timings.jobs[i].end > last) {
+      last = timings.jobs[i].end;
+    }
+  }
+  return last;
+}
+
+// Point the launchers of the build tool about to run at `path` (NULL stops them)
+void timings_export_log(const char *path) {
+#ifdef _WIN32
+  _putenv_s(TIMINGS_LOG_VARIABLE, path ? path : "");
+#else
+  if (path) {
+    setenv(TIMINGS_LOG_VARIABLE, path, 1);
+  } else {
+    unsetenv(TIMINGS_LOG_VARIABLE);
+  }
+#endif
+}
+
+// Read the jobs the launchers appended to `path`. Returns the number read.
+int timings_load_log(const char *path) {
+  char *content = read_file_contents(path);
+  if (!content) {
+    return 0;
+  }
+  int loaded = 0;
+  for (char *line = strtok(content, "\n"); line; line = strtok(NULL, "\n")) {
+    char *fields[5];
+    int count = 0;
+    for (char *field = line; field && count < 5; count++) {
+      fields[count] = field;
+      field = strchr(field, '\t');
+      if (field) *field++ = '\0';
+    }
+    if (count == 5) {
+      timings_job(fields[0], fields[4], fields[3], atof(fields[1]), atof(fields[2]), NULL, -1);
+      loaded++;
+    }
+  }
+  free(content);
+  return loaded;
+}
+
+// Fold another trace-event file into the build's trace, on the phase track
+// starting at `start`
+void timings_attach_trace(const char *path, double start) {
+  if (timings.enabled) {
+    push_span(&timings.traces, &timings.trace_count, &timings.trace_capacity, path, start, start);
+  }
+}
+
+// The compiler in a command, looking past an `sbor cache compile` launcher
+static const char* command_compiler(char *const argv[]) {
+  int i = 0;
+  if (argv[0] && argv[1] && strcmp(argv[1], "cache") == 0 && argv[2] && strcmp(argv[2], "compile") == 0) {
+    i = 3;
+    if (argv[i] && strcmp(argv[i], "--root") == 0) {
+      i += argv[i + 1] ? 2 : 1;
+    }
+  }
+  return argv[i];
+}
+
+static const char* argument_after(char *const argv[], const char *flag) {
+  for (int i = 0; argv[i]; i++) {
+    if (strcmp(argv[i], flag) == 0) {
+      return argv[i + 1];
+    }
+  }
+  return NULL;
+}
+
+// For a clang compile, copy the command into `traced` with -ftime-trace added
+// (clang writes <output minus extension>.json). The flag is only added when
+// the command runs, so it never changes the recorded command line. Returns 1
+// if `traced` was filled in.
+int with_time_trace(char *const argv[], struct arg_list *traced) {
+  const char *compiler = command_compiler(argv);
+  if (!compiler || !argument_after(argv, "-c") || argument_after(argv, "-ftime-trace")) {
+    return 0;
+  }
+  const char *base = strrchr(compiler, '/');
+  if (!strstr(base ? base + 1 : compiler, "clang")) {
+    return 0;
+  }
+  arg_list_init(traced);
+  for (int i = 0; argv[i]; i++) {
+    arg_list_push(traced, argv[i]);
+  }
+  arg_list_push(traced, "-ftime-trace");
+  return 1;
+}
+
+static void absolute_path(const char *path, char *buffer, size_t size) {
+  char cwd[1024];
+  int absolute = path[0] == '/' || path[0] == '\\' || (path[0] && path[1] == ':');
+  if (absolute || getcwd(cwd, sizeof(cwd)) == NULL) {
+    snprintf(buffer, size, "%s", path);
+  } else {
+    snprintf(buffer, size, "%s/%s", cwd, path);
+  }
+}
+
+// A launched job's output and name (its source, or the output for links),
+// as absolute paths: the build tool runs it from the build tree
+static void job_paths(char *const argv[], char *output, char *name, size_t size) {
+  const char *object = argument_after(argv, "-o");
+  const char *source = argument_after(argv, "-c");
+  absolute_path(object ? object : argv[0], output, size);
+  if (source) {
+    absolute_path(source, name, size);
+  } else {
+    snprintf(name, size, "%s", output);
+  }
+}
+
+static int logging_timings(void) {
+  const char *log = getenv(TIMINGS_LOG_VARIABLE);
+  return log && *log;
+}
+
+// Append a job run by a launcher to $SBOR_TIMINGS_LOG, if it is set
+static void log_timed_command(const char *kind, double start, double end, const char *output,
+                              const char *name) {
+  if (!logging_timings()) {
+    return;
+  }
+  char line[2400];
+  snprintf(line, sizeof(line), "%s\t%.6f\t%.6f\t%s\t%s\n", kind, start, end, output, name);
+
+  // One write per line in append mode, so parallel jobs never interleave
+  FILE *file = fopen(getenv(TIMINGS_LOG_VARIABLE), "a");
+  if (file) {
+    fputs(line, file);
+    fclose(file);
+  }
+}
+
+// Run a compile or link for the CMake launchers. The job is logged for
+// --timings, and with --message-format=json its stderr is captured (then
+// passed on) so its diagnostics can be reported. Returns the exit code and
+// stores the wall time in *seconds.
+int run_launched_job(const char *kind, char *const argv[], double *seconds) {
+  struct arg_list traced;
+  int trace = logging_timings() && strcmp(kind, "compile") == 0 && with_time_trace(argv, &traced);
+  char *const *command = trace ? traced.items : argv;
+
+  char *diagnostics = NULL;
+  size_t diagnostics_length = 0;
+  double start = timings_now();
+  int result;
+  if (events_enabled()) {
+    result = run_process_capture(command, NULL, NULL, &diagnostics, &diagnostics_length);
+    if (diagnostics) {
+      fputs(diagnostics, stderr);
+    }
+  } else {
+    result = run_process(command);
+  }
+  double end = timings_now();
+  if (trace) {
+    arg_list_free(&traced);
+  }
+
+  char output[1100], name[1100];
+  job_paths(argv, output, name, sizeof(output));
+  log_timed_command(kind, start, end, output, name);
+  report_job(kind, name, output, start, end, result, diagnostics);
+  free(diagnostics);
+  *seconds = end - start;
+  return result;
+}
+
+// `sbor __time <command...>`: the compiler launcher. Unless --timings or
+// --message-format=json is on, it simply becomes the command.
+int time_command(int argc, char *argv[]) {
+  if (argc < 1) {
+    fprintf(stderr, "Usage: sbor __time <command...>\n");
+    return 1;
+  }
+  if (!logging_timings() && !events_enabled()) {
+#ifdef _WIN32
+    return run_process(argv);
+#else
+    execvp(argv[0], argv);
+    fprintf(stderr, "❌ Error: Failed to start '%s'\n", argv[0]);
+    return 127;
+#endif
+  }
+  double seconds;
+  return run_launched_job("compile", argv, &seconds);
+}
+
+// The first element of the event array: the file itself (CMake's
+// google-trace) or its "traceEvents" member (clang)
+static const char* first_event(const char *content) {
+  const char *p = skip_json_space(content);
+  if (*p == '{' && json_member(p, "traceEvents", &p) == 0) {
+    return NULL;
+  }
+  return json_first_element(p);
+}
+
+// An event's phase: 'X' (complete), 'B' or 'E' (begin and end, as CMake
+// writes them) or 0 for anything else, with its timestamp
+static char event_phase(const char *event, double *ts) {
+  const char *phase, *time;
+  if (json_member(event, "ph", &phase) != 3 || json_member(event, "ts", &time) == 0) {
+    return 0;
+  }
+  *ts = atof(time);
+  return phase[1] == 'X' || phase[1] == 'B' || phase[1] == 'E' ? phase[1] : 0;
+}
+
+struct merged_event {
+  const char *name;
+  size_t name_length;
+  const char *args;
+  size_t args_length;
+  double ts;
+};
+
+static void write_merged_event(FILE *file, const struct merged_event *event, double dur, double shift,
+                               int tid, const char *category, struct timed_job *job) {
+  fputs(",\n{\"name\":", file);
+  fwrite(event->name, 1, event->name_length, file);
+  fprintf(file, ",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d",
+          category, event->ts + shift, dur, tid);
+  if (event->args_length > 0) {
+    fputs(",\"args\":", file);
+    fwrite(event->args, 1, event->args_length, file);
+  }
+  fputc('}', file);
+
+  if (job && event->name_length == 10 && strncmp(event->name, "\"Frontend\"", 10) == 0) {
+    job->frontend += dur / 1e6;
+  } else if (job && event->name_length == 9 && strncmp(event->name, "\"Backend\"", 9) == 0) {
+    job->backend += dur / 1e6;
+  }
+}
+
+// Copy the events of the trace file at `path` into `file` as complete
+// events, shifted so the earliest begins at `start` (µs) on track `tid`.
+// With `job`, clang's Frontend and Backend times are kept for the summary.
+static void merge_trace(FILE *file, const char *path, double start, int tid, const char *category,
+                        struct timed_job *job) {
+  char *content = read_file_contents(path);
+  const char *events = content ? first_event(content) : NULL;
+  if (!events) {
+    free(content);
+    return;
+  }
+
+  double ts = 0, earliest = -1;
+  for (const char *event = events; *event == '{'; event = json_next_element(event)) {
+    char phase = event_phase(event, &ts);
+    if ((phase == 'X' || phase == 'B') && (earliest < 0 || ts < earliest)) {
+      earliest = ts;
+    }
+  }
+
+  // Begin events wait on a stack for their end
+  struct merged_event *open = NULL;
+  int depth = 0, capacity = 0;
+  for (const char *event = events; *event == '{'; event = json_next_element(event)) {
+    char phase = event_phase(event, &ts);
+    if (phase == 'E') {
+      if (depth > 0) {
+        depth--;
+        write_merged_event(file, &open[depth], ts - open[depth].ts, start - earliest, tid, category, job);
+      }
+      continue;
+    }
+    struct merged_event merged = { NULL, 0, NULL, 0, ts };
+    merged.name_length = json_member(event, "name", &merged.name);
+    merged.args_length = json_member(event, "args", &merged.args);
+    if (merged.name_length == 0) {
+      merged.name = "\"?\"";
+      merged.name_length = 3;
+    }
+    if (phase == 'B') {
+      if (depth == capacity) {
+        capacity = capacity ? capacity * 2 : 16;
+        open = realloc(open, capacity * sizeof(struct merged_event));
+      }
+      open[depth++] = merged;
+    } else if (phase == 'X' && strncmp(merged.name, "\"Total ", 7) != 0) {
+      // Clang's per-category totals span the whole compile on their own
+      // tracks, so they are left out
+      const char *dur;
+      double duration = json_member(event, "dur", &dur) ? atof(dur) : 0;
+      write_merged_event(file, &merged, duration, start - earliest, tid, category, job);
+    }
+  }
+  free(open);
+  free(content);
+}
+
+// Path relative to the project root when it lies inside it
+static const char* display_path(const char *path) {
+  static char root[1024];
+  if (!root[0] && getcwd(root, sizeof(root)) == NULL) {
+    return path;
+  }
+  size_t length = strlen(root);
+  if (strncmp(path, root, length) == 0 && path[length] == '/') {
+    return path + length + 1;
+  }
+  return path;
+}
+
+// Where clang wrote the -ftime-trace file for an object, if it is from this build
+static int clang_trace_path(const struct timed_job *job, char *buffer, size_t size) {
+  snprintf(buffer, size, "%s", job->output);
+  char *dot = strrchr(buffer, '.');
+  char *slash = strrchr(buffer, '/');
+  if (!dot || (slash && dot < slash) || (size_t)(dot - buffer) + 6 > size) {
+    return 0;
+  }
+  strcpy(dot, ".json");
+  return file_mtime_ns(buffer) >= (long long)(timings.wall_start - 1) * 1000000000LL;
+}
+
+static int compare_job_starts(const void *a, const void *b) {
+  const struct timed_job *x = &timings.jobs[*(const int *)a];
+  const struct timed_job *y = &timings.jobs[*(const int *)b];
+  return (x->start > y->start) - (x->start < y->start);
+}
+
+// Put jobs on the fewest tracks without overlaps. Returns the track count.
+static int assign_lanes(void) {
+  int *order = malloc((timings.job_count + 1) * sizeof(int));
+  double *lane_ends = malloc((timings.job_count + 1) * sizeof(double));
+  for (int i = 0; i < timings.job_count; i++) {
+    order[i] = i;
+  }
+  qsort(order, timings.job_count, sizeof(int), compare_job_starts);
+
+  int lanes = 0;
+  for (int i = 0; i < timings.job_count; i++) {
+    struct timed_job *job = &timings.jobs[order[i]];
+    int lane = 0;
+    while (lane < lanes && lane_ends[lane] > job->start + 1e-6) {
+      lane++;
+    }
+    if (lane == lanes) {
+      lanes++;
+    }
+    lane_ends[lane] = job->end;
+    job->lane = lane;
+  }
+  free(order);
+  free(lane_ends);
+  return lanes;
+}
+
+// Walk back from the job that finished last. With known dependencies the
+// predecessor is the dependency that finished last; otherwise it is the job
+// that finished last before this one started (it held the slot or the input
+// this one waited for). Returns the jobs from first to last in `path`.
+static int find_critical_path(int *path) {
+  int current = -1;
+  for (int i = 0; i < timings.job_count; i++) {
+    if (current < 0 || timings.jobs[i].end > timings.jobs[current].end) {
+      current = i;
+    }
+  }
+
+  int length = 0;
+  while (current >= 0 && !timings.jobs[current].critical) {
+    struct timed_job *job = &timings.jobs[current];
+    job->critical = 1;
+    path[length++] = current;
+
+    int previous = -1;
+    if (job->dep_count >= 0) {
+      for (int d = 0; d < job->dep_count; d++) {
+        int dep = job->deps[d];
+        if (previous < 0 || timings.jobs[dep].end > timings.jobs[previous].end) {
+          previous = dep;
+        }
+      }
+    } else {
+      for (int i = 0; i < timings.job_count; i++) {
+        const struct timed_job *other = &timings.jobs[i];
+        if (i != current && other->end <= job->start + 1e-3 &&
+            (previous < 0 || other->end > timings.jobs[previous].end)) {
+          previous = i;
+        }
+      }
+    }
+    current = previous;
+  }
+
+  for (int i = 0; i < length / 2; i++) {
+    int swap = path[i];
+    path[i] = path[length - 1 - i];
+    path[length - 1 - i] = swap;
+  }
+  return length;
+}
+
+static void write_thread_name(FILE *file, int tid, const char *name) {
+  fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":", tid);
+  write_json_string(file, name);
+  fputs("}}", file);
+}
+
+static void write_event(FILE *file, const char *name, const char *category, double start, double end,
+                        int tid, const struct timed_job *job) {
+  fputs(",\n{\"name\":", file);
+  write_json_string(file, name);
+  fprintf(file, ",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d",
+          category, (start - timings.start) * 1e6, (end - start) * 1e6, tid);
+  if (job) {
+    fputs(",\"args\":{\"output\":", file);
+    write_json_string(file, display_path(job->output));
+    fprintf(file, ",\"critical_path\":%s}", job->critical ? "true" : "false");
+  }
+  fputc('}', file);
+}
+
+// Tracks: 0 for sbor's phases, 1..lanes for job slots, then the critical path
+static int write_trace(const char *path, int lanes, const int *critical, int critical_count) {
+  FILE *file = fopen(path, "w");
+  if (!file) {
+    fprintf(stderr, "❌ Error: Could not write %s\n", path);
+    return -1;
+  }
+  fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", file);
+  fputs("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"sbor build\"}}", file);
+  write_thread_name(file, 0, "phases");
+  for (int lane = 0; lane < lanes; lane++) {
+    char name[32];
+    snprintf(name, sizeof(name), "job slot %d", lane + 1);
+    write_thread_name(file, lane + 1, name);
+  }
+  write_thread_name(file, lanes + 1, "critical path");
+
+  for (int i = 0; i < timings.phase_count; i++) {
+    const struct timed_span *phase = &timings.phases[i];
+    write_event(file, phase->name, "phase", phase->start, phase->end, 0, NULL);
+  }
+  for (int i = 0; i < timings.trace_count; i++) {
+    merge_trace(file, timings.traces[i].name, (timings.traces[i].start - timings.start) * 1e6, 0, "cmake", NULL);
+  }
+
+  for (int i = 0; i < timings.job_count; i++) {
+    struct timed_job *job = &timings.jobs[i];
+    write_event(file, display_path(job->name), job->kind, job->start, job->end, job->lane + 1, job);
+    char clang_trace[1200];
+    if (strcmp(job->kind, "compile") == 0 && clang_trace_path(job, clang_trace, sizeof(clang_trace))) {
+      merge_trace(file, clang_trace, (job->start - timings.start) * 1e6, job->lane + 1, "clang", job);
+    }
+  }
+  for (int i = 0; i < critical_count; i++) {
+    const struct timed_job *job = &timings.jobs[critical[i]];
+    write_event(file, display_path(job->name), job->kind, job->start, job->end, lanes + 1, NULL);
+  }
+
+  fputs("\n]}\n", file);
+  fclose(file);
+  return 0;
+}
+
+static int compare_job_durations(const void *a, const void *b) {
+  const struct timed_job *x = &timings.jobs[*(const int *)a];
+  const struct timed_job *y = &timings.jobs[*(const int *)b];
+  double dx = x->end - x->start, dy = y->end - y->start;
+  return (dx < dy) - (dx > dy);
+}
+
+static void print_timings(double total, const int *critical, int critical_count) {
+  printf("⏱️  Build timings (%.3fs)\n", total);
+  for (int i = 0; i < timings.phase_count; i++) {
+    const struct timed_span *phase = &timings.phases[i];
+    printf("   %8.3fs  %s\n", phase->end - phase->start, phase->name);
+  }
+
+  int *units = malloc((timings.job_count + 1) * sizeof(int));
+  int unit_count = 0;
+  for (int i = 0; i < timings.job_count; i++) {
+    if (strcmp(timings.jobs[i].kind, "compile") == 0) {
+      units[unit_count++] = i;
+    }
+  }
+  qsort(units, unit_count, sizeof(int), compare_job_durations);
+  if (unit_count > 0) {
+    printf("\n🐢 Slowest translation units (%d compiled)\n", unit_count);
+    for (int i = 0; i < unit_count && i < SLOWEST_UNITS; i++) {
+      const struct timed_job *job = &timings.jobs[units[i]];
+      printf("   %8.3fs  %s", job->end - job->start, display_path(job->name));
+      if (job->frontend > 0 || job->backend > 0) {
+        printf("  (frontend %.3fs, backend %.3fs)", job->frontend, job->backend);
+      }
+      printf("\n");
+    }
+  }
+  free(units);
+
+  if (critical_count > 0) {
+    double length = 0;
+    for (int i = 0; i < critical_count; i++) {
+      length += timings.jobs[critical[i]].end - timings.jobs[critical[i]].start;
+    }
+    printf("\n🧭 Critical path: %.3fs in %d job%s (%.0f%% of the build)\n", length, critical_count,
+           critical_count == 1 ? "" : "s", total > 0 ? 100.0 * length / total : 0.0);
+    for (int i = 0; i < critical_count; i++) {
+      const struct timed_job *job = &timings.jobs[critical[i]];
+      printf("   %8.3fs  %s %s\n", job->end - job->start, job->kind, display_path(job->name));
+    }
+  }
+}
+
+static void free_timings(void) {
+  for (int i = 0; i < timings.job_count; i++) {
+    free(timings.jobs[i].kind);
+    free(timings.jobs[i].name);
+    free(timings.jobs[i].output);
+    free(timings.jobs[i].deps);
+  }
+  for (int i = 0; i < timings.phase_count; i++) {
+    free(timings.phases[i].name);
+  }
+  for (int i = 0; i < timings.trace_count; i++) {
+    free(timings.traces[i].name);
+  }
+  free(timings.jobs);
+  free(timings.phases);
+  free(timings.traces);
+  memset(&timings, 0, sizeof(timings));
+}
+
+// Write the trace to `trace_path`, print the summary and stop collecting
+int timings_finish(const char *trace_path) {
+  if (!timings.enabled) {
+    return 0;
+  }
+  double total = timings_now() - timings.start;
+  int lanes = assign_lanes();
+  int *critical = malloc((timings.job_count + 1) * sizeof(int));
+  int critical_count = find_critical_path(critical);
+
+  int result = write_trace(trace_path, lanes, critical, critical_count);
+  printf("\n");
+  print_timings(total, critical, critical_count);
+  if (result == 0) {
+    printf("\n📍 Trace: ./%s (open in https://ui.perfetto.dev or chrome://tracing)\n", trace_path);
+  }
+  free(critical);
+  free_timings();
+  return result;
+}
@@ -4,11 +4,14 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include <ctype.h>
+#include <errno.h>
+#include <dirent.h>
 
 // Cross-platform includes
 #ifdef _WIN32
 #include <direct.h>
 #define chdir _chdir
+#include <windows.h>
 #else
 #include <sys/types.h>
 #endif
@@ -26,21 +29,115 @@ int is_valid_sbor_project() {
   return file_exists("CMakeLists.txt") && file_exists("src");
 }
 
-// Helper function to execute a command and return its exit status
-int execute_command(const char *command) {
-  printf("Executing: %s\n", command);
-  int result = system(command);
+// Helper function to run a tool and return its exit status. The arguments
+// go to the program as-is, without a shell; they are only quoted for display.
+int execute_command(char *const argv[]) {
+  printf("Executing:");
+  for (int i = 0; argv[i]; i++) {
+    printf(strpbrk(argv[i], " \t\"';") ? " \"%s\"" : " %s", argv[i]);
+  }
+  printf("\n");
+  fflush(stdout);
+  return run_process(argv);
+}
 
+// Helper function to get the number of online CPUs (at least 1)
+int get_cpu_count(void) {
 #ifdef _WIN32
-  return result;
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  int count = (int)info.dwNumberOfProcessors;
 #else
-  // On Unix systems, system() returns the exit status in a specific format
-  if (WIFEXITED(result)) {
-    return WEXITSTATUS(result);
-  } else {
-    return -1; // Command failed to execute
+  long count = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+  return count > 0 ? (int)count : 1;
+}
+
+// 64-bit FNV-1a hash, chainable by passing the previous result as `hash`.
+// Start a new hash with HASH_SEED.
+unsigned long long hash_bytes(unsigned long long hash, const void *data, size_t length) {
+  const unsigned char *bytes = data;
+  for (size_t i = 0; i < length; i++) {
+    hash ^= bytes[i];
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+// Hash a string including its terminator, so ("ab","c") != ("a","bc")
+unsigned long long hash_string(unsigned long long hash, const char *text) {
+  if (!text) text = "";
+  return hash_bytes(hash, text, strlen(text) + 1);
+}
+
+// Hash a file's contents; missing files hash differently from empty ones
+unsigned long long hash_file(unsigned long long hash, const char *path) {
+  char *content = read_file_contents(path);
+  if (!content) {
+    return hash_string(hash, "<missing>");
+  }
+  hash = hash_string(hash, "<file>");
+  hash = hash_string(hash, content);
+  free(content);
+  return hash;
+}
+
+// Helper function to locate an executable on PATH.
+// Returns a newly allocated full path, or NULL if it is not installed.
+char* find_program(const char *name) {
+  const char *path_env = getenv("PATH");
+  if (!path_env || !*path_env) {
+    return NULL;
+  }
+
+#ifdef _WIN32
+  const char separator = ';';
+  const char *suffix = ".exe";
+#else
+  const char separator = ':';
+  const char *suffix = "";
+#endif
+
+  char *paths = strdup(path_env);
+  char *dir = paths;
+  char *result = NULL;
+
+  while (dir) {
+    char *next = strchr(dir, separator);
+    if (next) *next++ = '\0';
+
+    char candidate[1024];
+    snprintf(candidate, sizeof(candidate), "%s/%s%s", *dir ? dir : ".", name, suffix);
+
+    struct stat info;
+#ifdef _WIN32
+    if (stat(candidate, &info) == 0 && !(info.st_mode & S_IFDIR)) {
+#else
+    if (stat(candidate, &info) == 0 && S_ISREG(info.st_mode) && access(candidate, X_OK) == 0) {
+#endif
+      result = strdup(candidate);
+      break;
+    }
+    dir = next;
+  }
+
+  free(paths);
+  return result;
+}
+
+// Absolute path of the running sbor binary, used to re-invoke sbor as a
+// compiler launcher. Returns a newly allocated string.
+char* get_self_executable(void) {
+#ifdef __linux__
+  char path[1024];
+  ssize_t length = readlink("/proc/self/exe", path, sizeof(path) - 1);
+  if (length > 0) {
+    path[length] = '\0';
+    return strdup(path);
   }
 #endif
+  char *found = find_program("sbor");
+  return found ? found : strdup("sbor");
 }
 
 // Helper function to get project name from CMakeLists.txt
@@ -454,10 +551,12 @@ int update_include_file(void) {
     char *system_array = find_nested_json_array(config_content, "includes", "system");
     char *custom_array = find_nested_json_array(config_content, "includes", "custom");
 
-    // Generate new include.h content
-    FILE *file = fopen("src/include.h", "w");
+    // Generate the new content next to include.h and only replace the
+    // header when it differs, so its mtime (and the precompiled header built
+    // from it) only changes when the header set does
+    FILE *file = fopen("src/include.h.tmp", "w");
     if (!file) {
-        printf("Debug: Could not open src/include.h for writing\n");
+        printf("Debug: Could not open src/include.h.tmp for writing\n");
         free(config_content);
         if (system_array) free(system_array);
         if (custom_array) free(custom_array);
@@ -467,6 +566,7 @@ int update_include_file(void) {
     fprintf(file, "// Auto-generated by sbor - Managed header includes\n");
     fprintf(file, "// Use 'sbor add <header>' to add system headers\n");
     fprintf(file, "// Use 'sbor add <header> -c' to add custom headers\n\n");
+    fprintf(file, "#ifndef SBOR_INCLUDE_H\n#define SBOR_INCLUDE_H\n\n");
 
     // Write system headers
     fprintf(file, "// System headers\n");
@@ -522,12 +622,572 @@ int update_include_file(void) {
         fprintf(file, "// Add your custom includes here\n");
     }
 
+    fprintf(file, "\n#endif // SBOR_INCLUDE_H\n");
     fclose(file);
 
     free(config_content);
     if (system_array) free(system_array);
     if (custom_array) free(custom_array);
 
+    char *old_content = read_file_contents("src/include.h");
+    char *new_content = read_file_contents("src/include.h.tmp");
+    int changed = !old_content || !new_content || strcmp(old_content, new_content) != 0;
+    free(old_content);
+    free(new_content);
+
+    if (!changed) {
+        remove("src/include.h.tmp");
+        return 0;
+    }
+
+    remove("src/include.h");
+    if (rename("src/include.h.tmp", "src/include.h") != 0) {
+        fprintf(stderr, "❌ Error: Could not replace src/include.h\n");
+        return -1;
+    }
+
     printf("Debug: Updated include.h successfully\n");
     return 0;
 }
+
+// Helper function to read a whole file into a NUL-terminated buffer
+char* read_file_contents(const char *path) {
+  FILE *file = fopen(path, "rb");
+  if (!file) {
+    return NULL;
+  }
+
+  fseek(file, 0, SEEK_END);
+  long length = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  if (length < 0) {
+    fclose(file);
+    return NULL;
+  }
+
+  char *content = malloc(length + 1);
+  if (fread(content, 1, length, file) != (size_t)length) {
+    free(content);
+    fclose(file);
+    return NULL;
+  }
+  content[length] = '\0';
+
+  fclose(file);
+  return content;
+}
+
+// Locate the body of a "section": { ... } object in sbor.conf. Nested
+// objects are addressed with dots, e.g. "profiles.release".
+// Returns a newly allocated copy of the object, or NULL if it is missing.
+static char* find_config_section(const char *json, const char *section) {
+  const char *dot = strchr(section, '.');
+  if (dot) {
+    char outer[256];
+    snprintf(outer, sizeof(outer), "%.*s", (int)(dot - section), section);
+    char *parent = find_config_section(json, outer);
+    if (!parent) {
+      return NULL;
+    }
+    // Skip the parent's opening brace so its own key cannot match
+    char *result = find_config_section(parent + 1, dot + 1);
+    free(parent);
+    return result;
+  }
+
+  char pattern[256];
+  snprintf(pattern, sizeof(pattern), "\"%s\":", section);
+
+  const char *start = strstr(json, pattern);
+  if (!start) {
+    return NULL;
+  }
+
+  start = strchr(start + strlen(pattern), '{');
+  if (!start) {
+    return NULL;
+  }
+
+  int depth = 0;
+  const char *end = start;
+  do {
+    if (*end == '{') depth++;
+    else if (*end == '}') depth--;
+    end++;
+  } while (*end && depth > 0);
+
+  if (depth != 0) {
+    return NULL;
+  }
+
+  size_t length = end - start;
+  char *result = malloc(length + 1);
+  memcpy(result, start, length);
+  result[length] = '\0';
+  return result;
+}
+
+// sbor.conf as read by the lookups below. A long-running process (sbor
+// daemon) keeps the text in memory and drops it when the file changes;
+// everything else reads the file each time.
+static char *cached_config = NULL;
+static int config_cache_on = 0;
+
+void config_cache_enable(void) {
+  config_cache_on = 1;
+}
+
+void config_cache_drop(void) {
+  free(cached_config);
+  cached_config = NULL;
+}
+
+static char* read_project_config(void) {
+  if (!config_cache_on) {
+    return read_file_contents("sbor.conf");
+  }
+  if (!cached_config) {
+    cached_config = read_file_contents("sbor.conf");
+  }
+  return cached_config ? strdup(cached_config) : NULL;
+}
+
+// Read a scalar (string, number or boolean) from sbor.conf.
+// `section` may be NULL for top-level keys such as "name".
+// Returns a newly allocated string, or NULL if the key is not set.
+char* get_config_value(const char *section, const char *key) {
+  char *config = read_project_config();
+  if (!config) {
+    return NULL;
+  }
+
+  char *scope = section ? find_config_section(config, section) : config;
+  if (!scope) {
+    free(config);
+    return NULL;
+  }
+
+  char pattern[256];
+  snprintf(pattern, sizeof(pattern), "\"%s\":", key);
+
+  char *value = NULL;
+  char *start = strstr(scope, pattern);
+  if (start) {
+    start += strlen(pattern);
+    while (*start && isspace((unsigned char)*start)) start++;
+
+    char *end;
+    if (*start == '"') {
+      start++;
+      end = strchr(start, '"');
+    } else {
+      end = start;
+      while (*end && *end != ',' && *end != '}' && *end != '\n' &&
+             !isspace((unsigned char)*end)) {
+        end++;
+      }
+    }
+
+    if (end && *start != '[' && *start != '{') {
+      size_t length = end - start;
+      value = malloc(length + 1);
+      memcpy(value, start, length);
+      value[length] = '\0';
+    }
+  }
+
+  if (scope != config) free(scope);
+  free(config);
+  return value;
+}
+
+// Read a string array from sbor.conf into `list`.
+// Returns the number of items added, or -1 if the key is not set.
+int get_config_list(const char *section, const char *key, struct arg_list *list) {
+  char *config = read_project_config();
+  if (!config) {
+    return -1;
+  }
+
+  char *scope = section ? find_config_section(config, section) : config;
+  if (!scope) {
+    free(config);
+    return -1;
+  }
+
+  char pattern[256];
+  snprintf(pattern, sizeof(pattern), "\"%s\":", key);
+
+  int added = -1;
+  char *start = strstr(scope, pattern);
+  if (start) {
+    start += strlen(pattern);
+    while (*start && isspace((unsigned char)*start)) start++;
+
+    char *end = *start == '[' ? strchr(start, ']') : NULL;
+    if (end) {
+      added = 0;
+      char *item = start + 1;
+      while (item < end) {
+        char *open_quote = memchr(item, '"', end - item);
+        if (!open_quote) break;
+        char *close_quote = memchr(open_quote + 1, '"', end - open_quote - 1);
+        if (!close_quote) break;
+
+        size_t length = close_quote - open_quote - 1;
+        char *value = malloc(length + 1);
+        memcpy(value, open_quote + 1, length);
+        value[length] = '\0';
+        arg_list_push(list, value);
+        free(value);
+
+        added++;
+        item = close_quote + 1;
+      }
+    }
+  }
+
+  if (scope != config) free(scope);
+  free(config);
+  return added;
+}
+
+// Read a boolean setting; anything other than true/false yields `fallback`
+int get_config_flag(const char *section, const char *key, int fallback) {
+  char *value = get_config_value(section, key);
+  int result = fallback;
+  if (value && strcmp(value, "true") == 0) {
+    result = 1;
+  } else if (value && strcmp(value, "false") == 0) {
+    result = 0;
+  }
+  free(value);
+  return result;
+}
+
+// Modification time in nanoseconds, or 0 if the file does not exist
+long long file_mtime_ns(const char *path) {
+  struct stat info;
+  if (stat(path, &info) != 0) {
+    return 0;
+  }
+#if defined(__APPLE__)
+  return (long long)info.st_mtimespec.tv_sec * 1000000000LL + info.st_mtimespec.tv_nsec;
+#elif defined(_WIN32)
+  return (long long)info.st_mtime * 1000000000LL;
+#else
+  return (long long)info.st_mtim.tv_sec * 1000000000LL + info.st_mtim.tv_nsec;
+#endif
+}
+
+// Create a directory and any missing parents (like mkdir -p)
+int make_directories(const char *path) {
+  char buffer[1024];
+  snprintf(buffer, sizeof(buffer), "%s", path);
+
+  for (char *p = buffer + 1; *p; p++) {
+    if (*p == '/') {
+      *p = '\0';
+      if (create_directory(buffer) != 0 && errno != EEXIST) {
+        return -1;
+      }
+      *p = '/';
+    }
+  }
+
+  if (create_directory(buffer) != 0 && errno != EEXIST) {
+    return -1;
+  }
+  return 0;
+}
+
+static int compare_paths(const void *a, const void *b) {
+  return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+static void collect_files(const char *dir, const char *suffix, struct arg_list *list) {
+  DIR *handle = opendir(dir);
+  if (!handle) {
+    return;
+  }
+
+  struct dirent *entry;
+  while ((entry = readdir(handle)) != NULL) {
+    if (entry->d_name[0] == '.') {
+      continue;
+    }
+
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+
+    struct stat info;
+    if (stat(path, &info) != 0) {
+      continue;
+    }
+
+    if (S_ISDIR(info.st_mode)) {
+      collect_files(path, suffix, list);
+    } else if (!suffix) {
+      arg_list_push(list, path);
+    } else {
+      size_t name_length = strlen(entry->d_name);
+      size_t suffix_length = strlen(suffix);
+      if (name_length > suffix_length &&
+          strcmp(entry->d_name + name_length - suffix_length, suffix) == 0) {
+        arg_list_push(list, path);
+      }
+    }
+  }
+
+  closedir(handle);
+}
+
+// Recursively list files under `dir` ending in `suffix` (NULL for all files),
+// sorted so builds are deterministic. Hidden entries are skipped.
+int list_files_recursive(const char *dir, const char *suffix, struct arg_list *list) {
+  int first = list->count;
+  collect_files(dir, suffix, list);
+  qsort(list->items + first, list->count - first, sizeof(char *), compare_paths);
+  return list->count - first;
+}
+
+// Absolute form of an existing path, symbolic links resolved
+static int resolve_path(const char *path, char *buffer, size_t size) {
+#ifdef _WIN32
+  return _fullpath(buffer, path, size) ? 0 : -1;
+#else
+  char resolved[4096];
+  if (!realpath(path, resolved) || strlen(resolved) >= size) {
+    return -1;
+  }
+  strcpy(buffer, resolved);
+  return 0;
+#endif
+}
+
+// Whether `ancestor` is `path` or one of its parent directories
+static int path_contains(const char *ancestor, const char *path) {
+  size_t length = strlen(ancestor);
+  if (length > 0 && (ancestor[length - 1] == '/' || ancestor[length - 1] == '\\')) {
+    length--;  // The filesystem root
+  }
+  return strncmp(ancestor, path, length) == 0 &&
+         (path[length] == '\0' || path[length] == '/' || path[length] == '\\');
+}
+
+// Check build.output_dir before anything is built into it or `sbor clean`
+// deletes it: it has to be a relative path strictly inside the project,
+// and neither src/ nor anything below it. Prints why and returns -1 if not.
+int check_output_dir(const char *output_dir) {
+  const char *problem = NULL;
+  char first[256] = "";
+  int components = 0;
+
+  if (!output_dir || !*output_dir) {
+    problem = "it is empty";
+  } else if (output_dir[0] == '/' || output_dir[0] == '\\' ||
+             (isalpha((unsigned char)output_dir[0]) && output_dir[1] == ':')) {
+    problem = "it is an absolute path";
+  } else {
+    // Walk the components, skipping "." and empty ones
+    const char *p = output_dir;
+    while (*p && !problem) {
+      size_t length = strcspn(p, "/\\");
+      if (length == 2 && strncmp(p, "..", 2) == 0) {
+        problem = "it leaves the project with '..'";
+      } else if (length > 0 && !(length == 1 && *p == '.')) {
+        if (components++ == 0) {
+          snprintf(first, sizeof(first), "%.*s", (int)length, p);
+        }
+      }
+      p += length;
+      if (*p) {
+        p++;
+      }
+    }
+    if (!problem && components == 0) {
+      problem = "it is the project directory";
+    } else if (!problem && strcmp(first, "src") == 0) {
+      problem = "it is inside src/";
+    }
+  }
+
+  // A symbolic link could still point at the project, a parent of it or src/
+  char root[4096], target[4096], sources[4096];
+  if (!problem && file_exists(output_dir) && resolve_path(".", root, sizeof(root)) == 0 &&
+      resolve_path(output_dir, target, sizeof(target)) == 0) {
+    if (path_contains(target, root)) {
+      problem = "it resolves to the project directory or one of its parents";
+    } else if (resolve_path("src", sources, sizeof(sources)) == 0 && path_contains(sources, target)) {
+      problem = "it resolves to a directory inside src/";
+    }
+  }
+
+  if (problem) {
+    fprintf(stderr, "❌ Error: build.output_dir \"%s\" cannot be used: %s.\n",
+            output_dir ? output_dir : "", problem);
+    fprintf(stderr, "   Use a relative directory inside the project, such as \"build\".\n");
+    return -1;
+  }
+  return 0;
+}
+
+// Load the project model from sbor.conf, filling in defaults for missing keys
+int load_project_config(struct project_config *config) {
+  if (!file_exists("sbor.conf")) {
+    return -1;
+  }
+
+  config->name = get_config_value(NULL, "name");
+  if (!config->name) {
+    config->name = get_project_name();
+  }
+  if (!config->name) {
+    return -1;
+  }
+
+  config->compiler = get_config_value("build", "compiler");
+  if (!config->compiler || !*config->compiler) {
+    free(config->compiler);
+    const char *cc = getenv("CC");
+    config->compiler = strdup(cc && *cc ? cc : "cc");
+  }
+
+  config->c_standard = get_config_value(NULL, "c_standard");
+  config->output_dir = get_config_value("build", "output_dir");
+  if (!config->output_dir || !*config->output_dir) {
+    free(config->output_dir);
+    config->output_dir = strdup("build");
+  }
+  arg_list_init(&config->flags);
+  if (check_output_dir(config->output_dir) != 0) {
+    free_project_config(config);
+    return -1;
+  }
+
+  get_config_list("build", "flags", &config->flags);
+  return 0;
+}
+
+void free_project_config(struct project_config *config) {
+  free(config->name);
+  free(config->compiler);
+  free(config->c_standard);
+  free(config->output_dir);
+  arg_list_free(&config->flags);
+}
+
+// Write `text` as a quoted JSON string
+void write_json_string(FILE *file, const char *text) {
+  fputc('"', file);
+  for (const char *c = text; *c; c++) {
+    if (*c == '"' || *c == '\\') {
+      fputc('\\', file);
+      fputc(*c, file);
+    } else if ((unsigned char)*c < 0x20) {
+      fprintf(file, "\\u%04x", *c);
+    } else {
+      fputc(*c, file);
+    }
+  }
+  fputc('"', file);
+}
+
+// Minimal JSON scanning, for files written by other tools (traces, CMake's
+// File API). Values are returned as pointers into the original text.
+
+const char* skip_json_space(const char *p) {
+  while (*p && isspace((unsigned char)*p)) p++;
+  return p;
+}
+
+// Skip one value (string, object, array or literal) starting at `p`
+const char* skip_json_value(const char *p) {
+  p = skip_json_space(p);
+  if (*p == '"') {
+    for (p++; *p && *p != '"'; p++) {
+      if (*p == '\\' && p[1]) p++;
+    }
+    return *p ? p + 1 : p;
+  }
+  if (*p == '{' || *p == '[') {
+    int depth = 0;
+    while (*p) {
+      if (*p == '"') {
+        p = skip_json_value(p);
+        continue;
+      }
+      if (*p == '{' || *p == '[') {
+        depth++;
+      } else if ((*p == '}' || *p == ']') && --depth == 0) {
+        return p + 1;
+      }
+      p++;
+    }
+    return p;
+  }
+  while (*p && *p != ',' && *p != '}' && *p != ']' && !isspace((unsigned char)*p)) p++;
+  return p;
+}
+
+// Find member `key` of the object at `object`. Sets *value to the raw JSON
+// text of its value and returns its length, or 0 if there is no such member.
+size_t json_member(const char *object, const char *key, const char **value) {
+  size_t key_length = strlen(key);
+  const char *p = skip_json_space(object + 1);
+  while (*p == '"') {
+    const char *name = p + 1;
+    const char *after = skip_json_value(p);
+    p = skip_json_space(after);
+    if (*p != ':') {
+      return 0;
+    }
+    const char *start = skip_json_space(p + 1);
+    const char *end = skip_json_value(start);
+    if ((size_t)(after - name - 1) == key_length && strncmp(name, key, key_length) == 0) {
+      *value = start;
+      return end - start;
+    }
+    p = skip_json_space(end);
+    if (*p == ',') p = skip_json_space(p + 1);
+  }
+  return 0;
+}
+
+// Iterate over an array: json_first_element() returns NULL if `array` is
+// not one; the walk ends when the element no longer starts a value (']')
+const char* json_first_element(const char *array) {
+  array = skip_json_space(array);
+  return *array == '[' ? skip_json_space(array + 1) : NULL;
+}
+
+const char* json_next_element(const char *element) {
+  const char *p = skip_json_space(skip_json_value(element));
+  return *p == ',' ? skip_json_space(p + 1) : p;
+}
+
+// Copy of a string member's value with the common escapes undone, or NULL
+// if the object has no such string
+char* json_string_member(const char *object, const char *key) {
+  const char *value;
+  size_t length = json_member(object, key, &value);
+  if (length < 2 || *value != '"') {
+    return NULL;
+  }
+  char *text = malloc(length);
+  size_t out = 0;
+  for (size_t i = 1; i + 1 < length; i++) {
+    if (value[i] == '\\' && i + 2 < length) {
+      i++;
+      switch (value[i]) {
+        case 'n': text[out++] = '\n'; break;
+        case 't': text[out++] = '\t'; break;
+        default: text[out++] = value[i]; break;
+      }
+    } else {
+      text[out++] = value[i];
+    }
+  }
+  text[out] = '\0';
+  return text;
+}
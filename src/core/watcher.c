@@ -0,0 +1,193 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __linux__
+  #include <errno.h>
+  #include <poll.h>
+  #include <unistd.h>
+  #include <dirent.h>
+  #include <sys/inotify.h>
+  #include <sys/stat.h>
+#endif
+
+#include "../include/commands.h"
+
+// File change notification for `sbor watch` and `sbor daemon`.
+//
+// Watches everything a build reads from the project: the src/ tree (inotify
+// is not recursive, so every directory gets its own watch, and directories
+// created later are added as they appear) plus sbor.conf and CMakeLists.txt.
+// The two files are watched through the project directory, since editors
+// often save by writing a new file and renaming it over the old one.
+//
+// The descriptor from watcher_fd() becomes readable when something changed,
+// so callers sleep in poll() and cost nothing while the tree is idle.
+
+#define WATCHED_DIRECTORIES 512
+
+struct file_watcher {
+  int fd;
+  int root;                               // Watch on the project directory
+  int watches[WATCHED_DIRECTORIES];
+  char *paths[WATCHED_DIRECTORIES];       // Directory of each watch
+  int count;
+};
+
+#ifdef __linux__
+
+#define WATCH_EVENTS (IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE)
+
+// Add a watch on `directory` and everything below it
+static void watch_tree(struct file_watcher *watcher, const char *directory) {
+  if (watcher->count >= WATCHED_DIRECTORIES) {
+    return;
+  }
+  int watch = inotify_add_watch(watcher->fd, directory, WATCH_EVENTS | IN_ONLYDIR);
+  if (watch < 0) {
+    return;
+  }
+  watcher->watches[watcher->count] = watch;
+  watcher->paths[watcher->count] = strdup(directory);
+  watcher->count++;
+
+  DIR *dir = opendir(directory);
+  if (!dir) {
+    return;
+  }
+  struct dirent *entry;
+  while ((entry = readdir(dir)) != NULL) {
+    if (entry->d_name[0] == '.') {
+      continue;
+    }
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/%s", directory, entry->d_name);
+    struct stat info;
+    if (stat(path, &info) == 0 && S_ISDIR(info.st_mode)) {
+      watch_tree(watcher, path);
+    }
+  }
+  closedir(dir);
+}
+
+static const char* watched_directory(const struct file_watcher *watcher, int watch) {
+  for (int i = 0; i < watcher->count; i++) {
+    if (watcher->watches[i] == watch) {
+      return watcher->paths[i];
+    }
+  }
+  return NULL;
+}
+
+// Editor droppings: dotfiles (swap files, .#locks), backups and vim's probe
+static int ignored_name(const char *name) {
+  size_t length = strlen(name);
+  return name[0] == '.' || (length > 0 && name[length - 1] == '~') ||
+         (length > 4 && strcmp(name + length - 4, ".swp") == 0) || strcmp(name, "4913") == 0;
+}
+
+#endif
+
+// Start watching the project in the current directory. Returns NULL where
+// inotify is not available.
+struct file_watcher* watcher_open(void) {
+#ifndef __linux__
+  return NULL;
+#else
+  struct file_watcher *watcher = calloc(1, sizeof(struct file_watcher));
+  watcher->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (watcher->fd < 0) {
+    free(watcher);
+    return NULL;
+  }
+  watcher->root = inotify_add_watch(watcher->fd, ".", WATCH_EVENTS | IN_ONLYDIR);
+  watch_tree(watcher, "src");
+  return watcher;
+#endif
+}
+
+int watcher_fd(const struct file_watcher *watcher) {
+  return watcher->fd;
+}
+
+// Read every pending event. Returns how many of them touch the build's
+// inputs and copies the path of the first into `changed`. New directories
+// under src/ are watched from here on.
+int watcher_read(struct file_watcher *watcher, char *changed, size_t size) {
+#ifndef __linux__
+  (void)watcher; (void)changed; (void)size;
+  return 0;
+#else
+  int relevant = 0;
+  char buffer[16384] __attribute__((aligned(__alignof__(struct inotify_event))));
+  while (1) {
+    ssize_t length = read(watcher->fd, buffer, sizeof(buffer));
+    if (length < 0 && errno == EINTR) {
+      continue;
+    }
+    if (length <= 0) {
+      break;
+    }
+    for (char *p = buffer; p < buffer + length;) {
+      const struct inotify_event *event = (const struct inotify_event *)p;
+      p += sizeof(struct inotify_event) + event->len;
+      if (event->len == 0 || ignored_name(event->name)) {
+        continue;
+      }
+
+      char path[1024];
+      if (event->wd == watcher->root) {
+        // Only the two project files matter at the top level
+        if (strcmp(event->name, "sbor.conf") != 0 && strcmp(event->name, "CMakeLists.txt") != 0) {
+          continue;
+        }
+        snprintf(path, sizeof(path), "%s", event->name);
+      } else {
+        const char *directory = watched_directory(watcher, event->wd);
+        if (!directory) {
+          continue;
+        }
+        snprintf(path, sizeof(path), "%s/%s", directory, event->name);
+        if ((event->mask & (IN_CREATE | IN_MOVED_TO)) && (event->mask & IN_ISDIR)) {
+          watch_tree(watcher, path);
+        }
+      }
+
+      if (relevant++ == 0 && changed) {
+        snprintf(changed, size, "%s", path);
+      }
+    }
+  }
+  return relevant;
+#endif
+}
+
+// Wait until no event has arrived for `quiet_ms`, so a burst of saves (an
+// editor writing several files, a git checkout) becomes one change. Returns
+// the number of relevant events drained meanwhile.
+int watcher_settle(struct file_watcher *watcher, int quiet_ms) {
+#ifndef __linux__
+  (void)watcher; (void)quiet_ms;
+  return 0;
+#else
+  int total = 0;
+  struct pollfd pending = { watcher->fd, POLLIN, 0 };
+  while (poll(&pending, 1, quiet_ms) > 0) {
+    total += watcher_read(watcher, NULL, 0);
+  }
+  return total;
+#endif
+}
+
+void watcher_close(struct file_watcher *watcher) {
+  if (!watcher) {
+    return;
+  }
+#ifdef __linux__
+  close(watcher->fd);
+#endif
+  for (int i = 0; i < watcher->count; i++) {
+    free(watcher->paths[i]);
+  }
+  free(watcher);
+}
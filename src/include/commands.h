@@ -1,6 +1,19 @@
 #ifndef COMMANDS_H
 #define COMMANDS_H
 
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef _WIN32
+typedef intptr_t process_t;
+#else
+#include <sys/types.h>
+typedef pid_t process_t;
+#endif
+
+#define HASH_SEED 14695981039346656037ULL
+
 // Command function declarations
 int cmd_init(int argc, char *argv[]);
 int cmd_add(int argc, char *argv[]);
@@ -9,6 +22,220 @@ int cmd_list(int argc, char *argv[]);
 int cmd_build(int argc, char *argv[]);
 int cmd_run(int argc, char *argv[]);
 int cmd_clean(int argc, char *argv[]);
+int cmd_cache(int argc, char *argv[]);
+int cmd_bench(int argc, char *argv[]);
+int cmd_microbench(int argc, char *argv[]);
+int cmd_profile(int argc, char *argv[]);
+int cmd_watch(int argc, char *argv[]);
+int cmd_daemon(int argc, char *argv[]);
+
+// NULL-terminated argument vector used to launch tools without a shell
+struct arg_list {
+  char **items;
+  int count;
+  int capacity;
+};
+
+// Process helpers (process.c)
+void arg_list_init(struct arg_list *list);
+void arg_list_push(struct arg_list *list, const char *arg);
+void arg_list_pushf(struct arg_list *list, const char *format, ...);
+void arg_list_free(struct arg_list *list);
+unsigned long long hash_arg_list(unsigned long long hash, const struct arg_list *list);
+int spawn_process(char *const argv[], process_t *process);
+int spawn_process_redirected(char *const argv[], const char *stdout_path,
+                             const char *stderr_path, process_t *process);
+int wait_process(process_t process);
+int process_exit_code(int status);
+int redirect_stdout(int fd);
+void restore_stdout(int saved);
+int run_process(char *const argv[]);
+int run_foreground(char *const argv[], int *signal_number);
+int exec_program(char *const argv[]);
+void raise_signal(int signal_number);
+int run_process_capture(char *const argv[], char **out, size_t *out_length,
+                        char **err, size_t *err_length);
+
+// Project model read from sbor.conf
+struct project_config {
+  char *name;
+  char *compiler;        // build.compiler, falling back to $CC and then cc
+  char *c_standard;      // e.g. "c17", NULL if unset
+  char *output_dir;      // build.output_dir, "build" by default
+  struct arg_list flags; // build.flags
+};
+
+int load_project_config(struct project_config *config);
+int check_output_dir(const char *output_dir);
+void free_project_config(struct project_config *config);
+
+// Options shared by the build and run commands
+struct build_options {
+  int jobs;         // Parallel compile jobs, 0 = use build.jobs or the CPU count
+  int reconfigure;  // Force CMake to re-run even if the fingerprint matches
+  int unity;        // Compile batched unity sources (also build.unity)
+  const char *profile;  // --profile/--release, NULL = build.profile or "dev"
+  int pgo;          // --pgo: instrument, train and rebuild with profile data
+  int pgo_phase;    // Set internally while a PGO build runs (enum pgo_phase)
+  int bolt;         // --bolt: optimize the linked binary's layout with llvm-bolt
+  int emit_relocs;  // Set internally: link with --emit-relocs for BOLT
+  int benches;      // Also build benches/*.c (sbor microbench)
+  int timings;      // --timings: write a trace of the build's phases and jobs
+  int json_messages;  // --message-format=json: stream build events to stdout
+};
+
+enum pgo_phase {
+  PGO_NONE,
+  PGO_GENERATE,
+  PGO_USE
+};
+
+void init_build_options(struct build_options *opts);
+int parse_build_option(int argc, char *argv[], int *index, struct build_options *opts);
+int build_project(const struct build_options *opts);
+int native_build(const struct build_options *opts, int jobs);
+int depfile_is_stale(const char *depfile, long long output_mtime);
+int unity_enabled(const struct build_options *opts);
+int unity_batch_size(void);
+
+// Named build profiles (profile.c)
+struct build_profile {
+  char *name;                 // e.g. "dev", "release"
+  const char *build_type;     // CMake build type: Debug, Release, MinSizeRel, RelWithDebInfo
+  struct arg_list flags;      // build.flags followed by the profile's flags
+  struct arg_list link_flags;
+  char *directory;            // <output_dir>/<name>
+  char *linker;               // -fuse-ld linker, NULL for the compiler's default
+};
+
+char* selected_profile_name(const struct build_options *opts);
+int load_build_profile(const struct build_options *opts, const struct project_config *config,
+                       struct build_profile *profile);
+void free_build_profile(struct build_profile *profile);
+
+// Linker selection and link timing (linker.c)
+void select_linker(struct build_profile *profile);
+int link_timed(int argc, char *argv[]);
+void print_link_time(double seconds, const struct build_profile *profile);
+
+// Build timings and trace output (timings.c)
+double timings_now(void);
+void timings_start(void);
+int timings_enabled(void);
+void timings_phase(const char *name, double start, double end);
+int timings_job(const char *kind, const char *name, const char *output, double start, double end,
+                const int *deps, int dep_count);
+double timings_last_job_end(void);
+void timings_export_log(const char *path);
+int timings_load_log(const char *path);
+void timings_attach_trace(const char *path, double start);
+int with_time_trace(char *const argv[], struct arg_list *traced);
+int run_launched_job(const char *kind, char *const argv[], double *seconds);
+int time_command(int argc, char *argv[]);
+int timings_finish(const char *trace_path);
+
+// Machine-readable build events (events.c)
+struct event {
+  char *text;
+  size_t length;
+  size_t capacity;
+};
+
+int events_enabled(void);
+void events_start(void);
+void events_release_stdout(void);
+void event_begin(struct event *event, const char *reason);
+void event_string(struct event *event, const char *key, const char *value);
+void event_number(struct event *event, const char *key, double value);
+void event_int(struct event *event, const char *key, long long value);
+void event_bool(struct event *event, const char *key, int value);
+void event_emit(struct event *event);
+double build_phase_started(const char *phase);
+void build_phase_finished(const char *phase, double started, int success);
+void report_job(const char *kind, const char *source, const char *output, double started,
+                double finished, int exit_code, const char *diagnostics);
+
+// Profile-guided optimization (pgo.c)
+int pgo_build(const struct build_options *opts);
+void pgo_apply_flags(const struct build_options *opts, const struct project_config *config,
+                     struct build_profile *profile);
+int load_training_config(const char *exe_path, struct arg_list *args);
+
+// Post-link layout optimization (bolt.c)
+int bolt_build(const struct build_options *opts);
+
+// LD_PRELOAD helpers shipped with sbor (preload.c)
+struct address_map;
+char* build_preload_library(const struct project_config *config, const char *work_dir,
+                            const char *name, const char *const source[]);
+int run_preloaded(char *const argv[], const char *library);
+struct address_map* load_address_map(const char *report, const char *exe_path);
+const char* resolve_address(const struct address_map *map, unsigned long long address,
+                            int return_address, unsigned long long *offset);
+void free_address_map(struct address_map *map);
+
+// Sampling profiler (sampler.c, flamegraph.c)
+char* build_sampler(const struct project_config *config, const char *work_dir);
+int symbolize_samples(const char *samples_path, const char *exe_path, struct arg_list *stacks);
+void push_folded_stack(struct arg_list *stacks, const struct arg_list *frames);
+int write_folded_stacks(struct arg_list *stacks, const char *path);
+int write_flamegraph(const char *folded_path, const char *svg_path, const char *title);
+void print_hot_functions(const char *folded_path, int top);
+
+// Hardware performance counters (counters.c)
+struct counter_run;
+int validate_counter_list(const char *list);
+int run_with_counters(char *const argv[], const char *list, struct counter_run **run);
+void print_counter_run(struct counter_run *run);
+void format_count(double value, char *buffer, size_t size);
+
+// Allocation profiling (allocations.c)
+int run_with_alloc_profile(const struct project_config *config, char *const argv[],
+                           const char *work_dir, int top);
+
+// Cache simulation with valgrind (cachegrind.c)
+int run_cachegrind(char *const argv[], const char *work_dir, int top);
+
+// Build targets and up-to-date checks (targets.c)
+int record_targets(const char *directory, const struct arg_list *names, const struct arg_list *paths);
+int load_targets(const char *directory, struct arg_list *names, struct arg_list *paths);
+char* find_target(const char *directory, const char *name);
+void request_cmake_codemodel(void);
+int cmake_codemodel_ready(void);
+int record_cmake_targets(void);
+int target_is_fresh(const char *directory, const char *artifact);
+void assume_targets_fresh(void);
+
+// File change notification (watcher.c)
+struct file_watcher;
+struct file_watcher* watcher_open(void);
+int watcher_fd(const struct file_watcher *watcher);
+int watcher_read(struct file_watcher *watcher, char *changed, size_t size);
+int watcher_settle(struct file_watcher *watcher, int quiet_ms);
+void watcher_close(struct file_watcher *watcher);
+
+// Running the built program (run.c)
+char* find_executable(const char *directory, const char *name);
+int execute_binary_quiet(const char *exe_path, int argc, char *argv[]);
+int build_can_be_skipped(const struct build_options *opts);
+void run_hand_off(int fd);
+void run_prebuilt(const char *exe_path);
+
+// Per-project build server (daemon.c)
+int daemon_forward(int argc, char *argv[]);
+
+// Object cache (object_cache.c)
+char* cache_directory(void);
+int cache_enabled(void);
+int cache_compile(int argc, char *argv[]);
+int cache_print_stats(void);
+int cache_clear(void);
+char* cache_remote_url(void);
+int cache_serve(int argc, char *argv[]);
+
+// HTTP client for the remote cache (http.c)
+int http_get(const char *url, const char *path, char **body, size_t *body_length, int timeout_ms);
+int http_put(const char *url, const char *path, const void *data, size_t length, int timeout_ms);
 
 // Utility functions for the init Command
 int create_directory(const char *path);
@@ -19,12 +246,37 @@ char* generate_include_template(void);
 char* generate_readme_template(const char *project_name);
 char* generate_gitignore_template(void);
 char* generate_config_template(const char *project_name);
+char* generate_bench_header_template(void);
+char* generate_bench_example_template(void);
 
 // Shared utility functions 
 int file_exists(const char *filename);
 int is_valid_sbor_project(void);
-int execute_command(const char *command);
+int execute_command(char *const argv[]);
+int remove_directory(const char *path);
 char* get_project_name(void);
+char* read_file_contents(const char *path);
+char* get_config_value(const char *section, const char *key);
+void config_cache_enable(void);
+void config_cache_drop(void);
+int get_cpu_count(void);
+char* find_program(const char *name);
+char* get_self_executable(void);
+unsigned long long hash_bytes(unsigned long long hash, const void *data, size_t length);
+unsigned long long hash_string(unsigned long long hash, const char *text);
+unsigned long long hash_file(unsigned long long hash, const char *path);
+int get_config_list(const char *section, const char *key, struct arg_list *list);
+int get_config_flag(const char *section, const char *key, int fallback);
+long long file_mtime_ns(const char *path);
+int make_directories(const char *path);
+int list_files_recursive(const char *dir, const char *suffix, struct arg_list *list);
+void write_json_string(FILE *file, const char *text);
+const char* skip_json_space(const char *p);
+const char* skip_json_value(const char *p);
+size_t json_member(const char *object, const char *key, const char **value);
+const char* json_first_element(const char *array);
+const char* json_next_element(const char *element);
+char* json_string_member(const char *object, const char *key);
 
 // JSON utility functions for add and remove commands
 int add_system_header(const char *header);
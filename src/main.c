@@ -10,15 +10,54 @@ void print_usage(void) {
   printf("Usage: sbor <command> [options]\n\n");
   printf("Commands:\n");
   printf("  init <name>      Create a new C project\n");
+  printf("    --bench        Add benches/ with the micro-benchmark harness\n");
   printf("  add <header>     Add header to include.h\n");
   printf("  remove <header>  Remove header from include.h\n");
-  printf("  list             List current headers\n");
+  printf("  list             List current headers and executable targets\n");
   printf("  build            Build the project\n");
+  printf("    -j  --jobs N   Number of parallel compile jobs (Default: CPU count)\n");
+  printf("    --reconfigure  Re-run CMake even if the configuration is unchanged\n");
+  printf("    --unity        Compile batched unity sources (see build.unity_batch_size)\n");
+  printf("    --release      Build with the release profile\n");
+  printf("    --profile NAME Build with a named profile (dev, release, release-lto, min-size, profiling)\n");
+  printf("    --pgo          Profile-guided build: instrument, run training.args, rebuild\n");
+  printf("    --bolt         Optimize the binary layout with llvm-bolt (needs perf)\n");
+  printf("    --timings      Write a trace of the build (timings.json) and print the slowest steps\n");
+  printf("    --message-format json  Stream build events as JSON lines on stdout\n");
   printf("  run              Build and run the project\n");
   printf("    -q  --quiet    Build and Run in quiet Mode\n");
   printf("    -v  --verbose  Build and Run in verbose Mode (Default)\n");
+  printf("    -j  --jobs N   Number of parallel compile jobs\n");
+  printf("    --release      Build and run the release profile\n");
+  printf("    --bin NAME     Run the executable target NAME\n");
+  printf("    --counters[=list]  Print hardware performance counters (cycles, IPC, misses)\n");
+  printf("    --cachegrind   Run under valgrind's cache simulator and report misses\n");
+  printf("    --alloc        Count allocations, heap peak and sizes per call site\n");
+  printf("    --message-format json  Build events as JSON lines, then the program's output\n");
+  printf("    -- <args>      Pass the remaining arguments to the program\n");
+  printf("  bench            Benchmark the release binary\n");
+  printf("    -n  --runs N   Measured runs (Default: 10, bench.runs)\n");
+  printf("    --warmup N     Unmeasured warmup runs (Default: 1)\n");
+  printf("    --save NAME    Store the results as a baseline\n");
+  printf("    --baseline NAME  Compare with a baseline, fail on a regression\n");
+  printf("    --threshold P  Allowed median slowdown in percent (Default: 5)\n");
+  printf("  microbench [filter]  Build and run the micro-benchmarks in benches/\n");
+  printf("  profile          Sample the program and write a flame graph\n");
+  printf("    --hz N         Samples per second (Default: 999)\n");
+  printf("    --top N        Rows in the hot function table (Default: 20)\n");
+  printf("    --sampler      Use the built-in sampler even if perf is installed\n");
+  printf("    --cache        Simulate the caches with cachegrind instead of sampling\n");
+  printf("  watch [build|run] Rebuild (and rerun) whenever a source file changes\n");
+  printf("    [options]      Passed to build or run, e.g. --release -- <args>\n");
+  printf("  daemon [start]   Keep a build server for the project (build, run and list use it)\n");
+  printf("    --idle-timeout S  Stop after S seconds without a request (Default: 1800, 0 = never)\n");
+  printf("  daemon status    Show the project's daemon\n");
+  printf("  daemon stop      Stop the project's daemon\n");
   printf("  version          Display sbor version\n");
   printf("  clean            Clean the build files\n");
+  printf("  cache stats      Show object cache hit/miss counts\n");
+  printf("  cache clear      Empty the object cache\n");
+  printf("  cache serve      Run a shared remote cache server\n");
   printf("  help             Display this message\n\n");
   printf("Examples:\n");
   printf("  sbor init my_project\n");
@@ -36,6 +75,14 @@ int main(int argc, char *argv[]) {
 
   const char *command = argv[1];
 
+  // With a daemon running for the project, it does the work (daemon.c)
+  if (strcmp(command, "build") == 0 || strcmp(command, "run") == 0 || strcmp(command, "list") == 0) {
+    int exit_code = daemon_forward(argc - 1, argv + 1);
+    if (exit_code >= 0) {
+      return exit_code;
+    }
+  }
+
   if (strcmp(command, "init") == 0) {
     return cmd_init(argc - 1, argv + 1);
   } else if (strcmp(command, "add") == 0) {
@@ -56,6 +103,22 @@ int main(int argc, char *argv[]) {
     return 0;
   } else if (strcmp(command, "clean") == 0) {
     return cmd_clean(argc - 1, argv + 1);
+  } else if (strcmp(command, "cache") == 0) {
+    return cmd_cache(argc - 1, argv + 1);
+  } else if (strcmp(command, "bench") == 0) {
+    return cmd_bench(argc - 1, argv + 1);
+  } else if (strcmp(command, "microbench") == 0) {
+    return cmd_microbench(argc - 1, argv + 1);
+  } else if (strcmp(command, "profile") == 0) {
+    return cmd_profile(argc - 1, argv + 1);
+  } else if (strcmp(command, "watch") == 0) {
+    return cmd_watch(argc - 1, argv + 1);
+  } else if (strcmp(command, "daemon") == 0) {
+    return cmd_daemon(argc - 1, argv + 1);
+  } else if (strcmp(command, "__link") == 0) {
+    return link_timed(argc - 2, argv + 2);
+  } else if (strcmp(command, "__time") == 0) {
+    return time_command(argc - 2, argv + 2);
   } else {
     fprintf(stderr, "Unknown Command : %s\n", command);
     print_usage();